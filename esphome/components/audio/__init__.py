@@ -1,6 +1,14 @@
+from esphome import automation
 import esphome.codegen as cg
+from esphome.components import esp32
 import esphome.config_validation as cv
-from esphome.const import CONF_BITS_PER_SAMPLE, CONF_NUM_CHANNELS, CONF_SAMPLE_RATE
+from esphome.const import (
+    CONF_BITS_PER_SAMPLE,
+    CONF_NUM_CHANNELS,
+    CONF_PATH,
+    CONF_SAMPLE_RATE,
+    CONF_SIZE,
+)
 import esphome.final_validate as fv
 
 CODEOWNERS = ["@kahrendt"]
@@ -13,9 +21,23 @@ AUDIO_FILE_TYPE_ENUM = {
     "WAV": AudioFileType.WAV,
     "MP3": AudioFileType.MP3,
     "FLAC": AudioFileType.FLAC,
+    "OPUS": AudioFileType.OPUS,
+}
+
+DumpTraceAction = audio_ns.class_("DumpTraceAction", automation.Action)
+
+GainRampType = audio_ns.enum("GainRampType", is_class=True)
+GAIN_RAMP_TYPES = {
+    "linear": GainRampType.LINEAR,
+    "exponential": GainRampType.EXPONENTIAL,
 }
 
 
+CONF_BUFFER_POOL_SIZE = "buffer_pool_size"
+CONF_FILE_CACHE_SIZE = "file_cache_size"
+CONF_FILE_CACHE_STORE = "file_cache_store"
+CONF_OPUS_SUPPORT = "opus_support"
+CONF_TRACE_EVENTS = "trace_events"
 CONF_MIN_BITS_PER_SAMPLE = "min_bits_per_sample"
 CONF_MAX_BITS_PER_SAMPLE = "max_bits_per_sample"
 CONF_MIN_CHANNELS = "min_channels"
@@ -24,8 +46,29 @@ CONF_MIN_SAMPLE_RATE = "min_sample_rate"
 CONF_MAX_SAMPLE_RATE = "max_sample_rate"
 
 
+def _validate_file_cache_store(config):
+    if CONF_FILE_CACHE_STORE in config and CONF_FILE_CACHE_SIZE not in config:
+        raise cv.Invalid(f"{CONF_FILE_CACHE_STORE} requires {CONF_FILE_CACHE_SIZE}")
+    return config
+
+
 CONFIG_SCHEMA = cv.All(
-    cv.Schema({}),
+    cv.Schema(
+        {
+            cv.Optional(CONF_BUFFER_POOL_SIZE, default="96KB"): cv.validate_bytes,
+            cv.Optional(CONF_FILE_CACHE_SIZE): cv.validate_bytes,
+            # Directory on a filesystem mounted in the VFS by another component
+            cv.Optional(CONF_FILE_CACHE_STORE): cv.Schema(
+                {
+                    cv.Required(CONF_PATH): cv.string_strict,
+                    cv.Required(CONF_SIZE): cv.validate_bytes,
+                }
+            ),
+            cv.Optional(CONF_OPUS_SUPPORT, default=False): cv.boolean,
+            cv.Optional(CONF_TRACE_EVENTS): cv.int_range(min=16, max=8192),
+        }
+    ),
+    _validate_file_cache_store,
 )
 
 AUDIO_COMPONENT_SCHEMA = cv.Schema(
@@ -166,3 +209,34 @@ def final_validate_audio_schema(
 
 async def to_code(config):
     cg.add_library("esphome/esp-audio-libs", "1.1.4")
+
+    # Maximum total size of unused transfer buffers cached for reuse by later tracks
+    cg.add_define("AUDIO_BUFFER_POOL_MAX_CACHED_BYTES", config[CONF_BUFFER_POOL_SIZE])
+
+    if CONF_FILE_CACHE_SIZE in config:
+        # Downloaded files that fit are kept in memory and replayed without the network, up to this total size
+        cg.add_define("USE_AUDIO_FILE_CACHE")
+        cg.add_define("AUDIO_FILE_CACHE_MAX_BYTES", config[CONF_FILE_CACHE_SIZE])
+
+    if store_config := config.get(CONF_FILE_CACHE_STORE):
+        # Cached files are also written to this directory and reloaded after a reboot, up to this total size
+        cg.add_define("AUDIO_FILE_STORE_PATH", store_config[CONF_PATH].rstrip("/"))
+        cg.add_define("AUDIO_FILE_STORE_MAX_BYTES", store_config[CONF_SIZE])
+
+    if CONF_TRACE_EVENTS in config:
+        # Pipeline stages record timed events into a ring of this many events, dumped with audio.dump_trace
+        cg.add_define("USE_AUDIO_TRACE")
+        cg.add_define("AUDIO_TRACE_MAX_EVENTS", config[CONF_TRACE_EVENTS])
+
+    if config[CONF_OPUS_SUPPORT]:
+        # Ogg/Opus decoding uses libopus packaged as an ESP-IDF component
+        cg.add_define("USE_AUDIO_OPUS_SUPPORT")
+        esp32.add_idf_component(
+            name="esp-opus",
+            repo="https://github.com/78/esp-opus.git",
+        )
+
+
+@automation.register_action("audio.dump_trace", DumpTraceAction, cv.Schema({}))
+async def audio_dump_trace_to_code(config, action_id, template_arg, args):
+    return cg.new_Pvariable(action_id, template_arg)
@@ -1,4 +1,5 @@
 #include "audio.h"
+#include "audio_gain.h"
 
 namespace esphome {
 namespace audio {
@@ -20,7 +21,9 @@ AudioStreamInfo::AudioStreamInfo(uint8_t bits_per_sample, uint8_t channels, uint
 }
 
 uint32_t AudioStreamInfo::frames_to_microseconds(uint32_t frames) const {
-  return (frames * 1000000 + (this->sample_rate_ >> 1)) / this->sample_rate_;
+  // Computed in 64 bits, since more than ~4300 frames would overflow
+  return static_cast<uint32_t>((static_cast<uint64_t>(frames) * 1000000 + (this->sample_rate_ >> 1)) /
+                               this->sample_rate_);
 }
 
 uint32_t AudioStreamInfo::frames_to_milliseconds_with_remainder(uint32_t *total_frames) const {
@@ -46,9 +49,15 @@ const char *audio_file_type_to_string(AudioFileType file_type) {
 #ifdef USE_AUDIO_MP3_SUPPORT
     case AudioFileType::MP3:
       return "MP3";
+#endif
+#ifdef USE_AUDIO_OPUS_SUPPORT
+    case AudioFileType::OPUS:
+      return "OPUS";
 #endif
     case AudioFileType::WAV:
       return "WAV";
+    case AudioFileType::PCM:
+      return "PCM";
     default:
       return "unknown";
   }
@@ -56,11 +65,7 @@ const char *audio_file_type_to_string(AudioFileType file_type) {
 
 void scale_audio_samples(const int16_t *audio_samples, int16_t *output_buffer, int16_t scale_factor,
                          size_t samples_to_scale) {
-  // Note the assembly dsps_mulc function has audio glitches if the input and output buffers are the same.
-  for (int i = 0; i < samples_to_scale; i++) {
-    int32_t acc = (int32_t) audio_samples[i] * (int32_t) scale_factor;
-    output_buffer[i] = (int16_t) (acc >> 15);
-  }
+  apply_q15_gain_s16(audio_samples, output_buffer, samples_to_scale, scale_factor);
 }
 
 }  // namespace audio
@@ -114,6 +114,10 @@ enum class AudioFileType : uint8_t {
   MP3,
 #endif
   WAV,
+  PCM,  // Headerless PCM; the stream info is supplied separately
+#ifdef USE_AUDIO_OPUS_SUPPORT
+  OPUS,  // Opus in an Ogg container
+#endif
 };
 
 struct AudioFile {
@@ -127,7 +131,7 @@ struct AudioFile {
 /// @return const char pointer to the readable file type
 const char *audio_file_type_to_string(AudioFileType file_type);
 
-/// @brief Scales Q15 fixed point audio samples. Scales in place if audio_samples == output_buffer.
+/// @brief Scales Q15 fixed point audio samples with saturation. Scales in place if audio_samples == output_buffer.
 /// @param audio_samples PCM int16 audio samples
 /// @param output_buffer Buffer to store the scaled samples
 /// @param scale_factor Q15 fixed point scaling factor
@@ -0,0 +1,130 @@
+#include "audio_buffer_pool.h"
+
+#ifdef USE_ESP32
+
+namespace esphome {
+namespace audio {
+
+AudioBufferPool &AudioBufferPool::get() {
+  static AudioBufferPool pool;
+  return pool;
+}
+
+uint8_t AudioBufferPool::size_to_class_(size_t size) {
+  for (uint8_t size_class = 0; size_class < AUDIO_BUFFER_POOL_NUM_CLASSES; ++size_class) {
+    if (size <= class_to_size_(size_class)) {
+      return size_class;
+    }
+  }
+  return AUDIO_BUFFER_POOL_NUM_CLASSES;
+}
+
+size_t AudioBufferPool::class_to_size_(uint8_t size_class) {
+  // Even classes are powers of two; odd classes are halfway between them
+  const size_t power_of_two = AUDIO_BUFFER_POOL_MIN_CLASS_SIZE << (size_class / 2);
+  if (size_class % 2 == 0) {
+    return power_of_two;
+  }
+  return power_of_two + power_of_two / 2;
+}
+
+uint8_t *AudioBufferPool::acquire(size_t size) {
+  RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+
+  const uint8_t size_class = size_to_class_(size);
+  if (size_class == AUDIO_BUFFER_POOL_NUM_CLASSES) {
+    // Too large to pool
+    LockGuard guard(this->lock_);
+    ++this->bypasses_;
+    return allocator.allocate(size);
+  }
+
+  {
+    LockGuard guard(this->lock_);
+    if (this->cached_count_[size_class] > 0) {
+      ++this->hits_;
+      uint8_t *buffer = this->cached_[size_class][--this->cached_count_[size_class]];
+      this->cached_[size_class][this->cached_count_[size_class]] = nullptr;
+      this->cached_bytes_ -= class_to_size_(size_class);
+      return buffer;
+    }
+    ++this->misses_;
+  }
+
+  uint8_t *buffer = allocator.allocate(class_to_size_(size_class));
+  if (buffer == nullptr) {
+    // Cached buffers of other sizes may be what is preventing the allocation, so free them and try once more
+    this->trim();
+    buffer = allocator.allocate(class_to_size_(size_class));
+  }
+  return buffer;
+}
+
+void AudioBufferPool::release(uint8_t *buffer, size_t size) {
+  if (buffer == nullptr) {
+    return;
+  }
+
+  RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+
+  const uint8_t size_class = size_to_class_(size);
+  if (size_class == AUDIO_BUFFER_POOL_NUM_CLASSES) {
+    allocator.deallocate(buffer, size);
+    return;
+  }
+
+  const size_t class_size = class_to_size_(size_class);
+
+  {
+    LockGuard guard(this->lock_);
+    if ((this->cached_count_[size_class] < AUDIO_BUFFER_POOL_BLOCKS_PER_CLASS) &&
+        (this->cached_bytes_ + class_size <= this->max_cached_bytes_)) {
+      this->cached_[size_class][this->cached_count_[size_class]++] = buffer;
+      this->cached_bytes_ += class_size;
+      return;
+    }
+  }
+
+  allocator.deallocate(buffer, class_size);
+}
+
+void AudioBufferPool::trim() {
+  LockGuard guard(this->lock_);
+  this->trim_to_(0);
+}
+
+void AudioBufferPool::set_max_cached_bytes(size_t max_cached_bytes) {
+  LockGuard guard(this->lock_);
+  this->max_cached_bytes_ = max_cached_bytes;
+  this->trim_to_(max_cached_bytes);
+}
+
+AudioBufferPoolStats AudioBufferPool::get_stats() {
+  LockGuard guard(this->lock_);
+  return {
+      .hits = this->hits_,
+      .misses = this->misses_,
+      .bypasses = this->bypasses_,
+      .cached_bytes = this->cached_bytes_,
+  };
+}
+
+void AudioBufferPool::trim_to_(size_t max_cached_bytes) {
+  RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+
+  // Free the largest buffers first to release the most memory with the fewest frees
+  for (int16_t size_class = AUDIO_BUFFER_POOL_NUM_CLASSES - 1; size_class >= 0; --size_class) {
+    const size_t class_size = class_to_size_(size_class);
+    while ((this->cached_bytes_ > max_cached_bytes) && (this->cached_count_[size_class] > 0)) {
+      uint8_t *buffer = this->cached_[size_class][--this->cached_count_[size_class]];
+      this->cached_[size_class][this->cached_count_[size_class]] = nullptr;
+      allocator.deallocate(buffer, class_size);
+      this->cached_bytes_ -= class_size;
+    }
+  }
+}
+
+}  // namespace audio
+}  // namespace esphome
+
+#endif
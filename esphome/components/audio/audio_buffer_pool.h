@@ -0,0 +1,86 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "esphome/core/defines.h"
+#include "esphome/core/helpers.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace audio {
+
+#ifndef AUDIO_BUFFER_POOL_MAX_CACHED_BYTES
+#define AUDIO_BUFFER_POOL_MAX_CACHED_BYTES 98304
+#endif
+
+// Size classes grow by alternating factors of 1.5 and 4/3 (1 KiB, 1.5 KiB, 2 KiB, 3 KiB, 4 KiB, ...), so at most a third
+// of a pooled block is wasted. Requests larger than the largest class bypass the pool.
+static const size_t AUDIO_BUFFER_POOL_MIN_CLASS_SIZE = 1024;
+static const uint8_t AUDIO_BUFFER_POOL_NUM_CLASSES = 16;  // Largest class is 192 KiB
+static const uint8_t AUDIO_BUFFER_POOL_BLOCKS_PER_CLASS = 4;
+
+struct AudioBufferPoolStats {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t bypasses;
+  size_t cached_bytes;
+};
+
+class AudioBufferPool {
+  /*
+   * @brief Process-wide pool of audio buffers shared by the transfer buffers of every audio pipeline.
+   * Released buffers are cached by size class instead of being freed, so the next track reuses them instead of
+   * freeing and allocating the same large blocks again.
+   *   - Buffers are allocated in external memory if available, falling back to internal memory.
+   *   - The total size of cached (unused) buffers is capped; excess buffers are freed immediately.
+   *   - Thread safe; pipelines run in separate FreeRTOS tasks.
+   */
+ public:
+  /// @brief Returns the shared pool instance
+  static AudioBufferPool &get();
+
+  /// @brief Gets a buffer with at least the requested size, reusing a cached buffer if possible.
+  /// @param size Number of bytes required
+  /// @return Pointer to the buffer, or nullptr if it couldn't be allocated
+  uint8_t *acquire(size_t size);
+
+  /// @brief Returns a buffer to the pool. The buffer is cached for reuse if the cache budget allows it.
+  /// @param buffer Pointer returned by acquire()
+  /// @param size The size originally passed to acquire()
+  void release(uint8_t *buffer, size_t size);
+
+  /// @brief Frees every cached buffer
+  void trim();
+
+  /// @brief Sets the largest total size of cached buffers kept for reuse. Trims the cache if necessary.
+  void set_max_cached_bytes(size_t max_cached_bytes);
+
+  AudioBufferPoolStats get_stats();
+
+ protected:
+  /// @brief Returns the size class index for a request, or AUDIO_BUFFER_POOL_NUM_CLASSES if it is too large to pool
+  static uint8_t size_to_class_(size_t size);
+  static size_t class_to_size_(uint8_t size_class);
+
+  /// @brief Frees cached buffers until the cache fits the budget. The lock must be held.
+  void trim_to_(size_t max_cached_bytes);
+
+  Mutex lock_;
+
+  uint8_t *cached_[AUDIO_BUFFER_POOL_NUM_CLASSES][AUDIO_BUFFER_POOL_BLOCKS_PER_CLASS]{};
+  uint8_t cached_count_[AUDIO_BUFFER_POOL_NUM_CLASSES]{};
+
+  size_t cached_bytes_{0};
+  size_t max_cached_bytes_{AUDIO_BUFFER_POOL_MAX_CACHED_BYTES};
+
+  uint32_t hits_{0};
+  uint32_t misses_{0};
+  uint32_t bypasses_{0};
+};
+
+}  // namespace audio
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,128 @@
+#include "audio_channel_mixer.h"
+
+#include "audio.h"
+#include "audio_gain.h"
+
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace audio {
+
+bool ChannelMixer::configure(uint8_t input_channels, uint8_t output_channels) {
+  if ((input_channels == 0) || (output_channels == 0) || (input_channels > MAX_CHANNEL_MIXER_CHANNELS) ||
+      (output_channels > MAX_CHANNEL_MIXER_CHANNELS)) {
+    return false;
+  }
+
+  this->input_channels_ = input_channels;
+  this->output_channels_ = output_channels;
+
+  memset(this->matrix_, 0, sizeof(this->matrix_));
+
+  if (input_channels == 1) {
+    // Duplicate mono to every output channel
+    for (uint8_t out = 0; out < output_channels; ++out) {
+      this->matrix_[out] = Q15_UNITY_GAIN;
+    }
+  } else {
+    // Route input channel i to output channel i % output_channels, averaging any channels that share an output
+    for (uint8_t out = 0; out < output_channels; ++out) {
+      uint8_t sources = 0;
+      for (uint8_t in = out; in < input_channels; in += output_channels) {
+        ++sources;
+      }
+      for (uint8_t in = out; in < input_channels; in += output_channels) {
+        this->matrix_[out * input_channels + in] = Q15_UNITY_GAIN / sources;
+      }
+    }
+  }
+
+  this->duplicate_mono_ = (input_channels == 1);
+
+  return true;
+}
+
+bool ChannelMixer::set_matrix(const std::vector<int32_t> &q15_matrix) {
+  if (q15_matrix.size() != static_cast<size_t>(this->input_channels_) * this->output_channels_) {
+    return false;
+  }
+
+  std::copy(q15_matrix.begin(), q15_matrix.end(), this->matrix_);
+
+  this->duplicate_mono_ = (this->input_channels_ == 1);
+  for (uint8_t out = 0; out < this->output_channels_; ++out) {
+    if (this->input_channels_ == 1 && this->matrix_[out] != Q15_UNITY_GAIN) {
+      this->duplicate_mono_ = false;
+    }
+  }
+
+  return true;
+}
+
+bool ChannelMixer::is_identity() const {
+  if (this->input_channels_ != this->output_channels_) {
+    return false;
+  }
+
+  for (uint8_t out = 0; out < this->output_channels_; ++out) {
+    for (uint8_t in = 0; in < this->input_channels_; ++in) {
+      const int32_t expected = (in == out) ? Q15_UNITY_GAIN : 0;
+      if (this->matrix_[out * this->input_channels_ + in] != expected) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void ChannelMixer::mix_frame(const int32_t *input, int32_t *output) const {
+  const int32_t *weights = this->matrix_;
+  for (uint8_t out = 0; out < this->output_channels_; ++out) {
+    int64_t accumulator = 0;
+    for (uint8_t in = 0; in < this->input_channels_; ++in) {
+      accumulator += static_cast<int64_t>(input[in]) * weights[in];
+    }
+    weights += this->input_channels_;
+    output[out] = static_cast<int32_t>(clamp<int64_t>(accumulator >> 15, INT32_MIN, INT32_MAX));
+  }
+}
+
+void ChannelMixer::mix_frames(const uint8_t *input, size_t input_bytes_per_sample, uint8_t *output,
+                              size_t output_bytes_per_sample, uint32_t frames) const {
+  if (this->duplicate_mono_ && (input_bytes_per_sample == 2) && (output_bytes_per_sample == 2)) {
+    // Common case of playing a mono 16 bit stream on a multichannel output; no arithmetic required
+    const int16_t *input_s16 = reinterpret_cast<const int16_t *>(input);
+    int16_t *output_s16 = reinterpret_cast<int16_t *>(output);
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      const int16_t sample = input_s16[frame];
+      for (uint8_t out = 0; out < this->output_channels_; ++out) {
+        *output_s16++ = sample;
+      }
+    }
+    return;
+  }
+
+  int32_t input_frame[MAX_CHANNEL_MIXER_CHANNELS];
+  int32_t output_frame[MAX_CHANNEL_MIXER_CHANNELS];
+
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    for (uint8_t in = 0; in < this->input_channels_; ++in) {
+      input_frame[in] = unpack_audio_sample_to_q31(input, input_bytes_per_sample);
+      input += input_bytes_per_sample;
+    }
+
+    this->mix_frame(input_frame, output_frame);
+
+    for (uint8_t out = 0; out < this->output_channels_; ++out) {
+      pack_q31_as_audio_sample(output_frame[out], output, output_bytes_per_sample);
+      output += output_bytes_per_sample;
+    }
+  }
+}
+
+}  // namespace audio
+}  // namespace esphome
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace audio {
+
+static const uint8_t MAX_CHANNEL_MIXER_CHANNELS = 8;
+
+class ChannelMixer {
+  /*
+   * @brief Class that converts audio frames between channel counts with a Q15 fixed-point mixing matrix.
+   * Each output channel is a weighted sum of the input channels, saturated to the output range. By default:
+   *   - Matching channel counts pass through unchanged.
+   *   - Mono input is duplicated to every output channel.
+   *   - Multichannel input downmixed to mono averages all input channels.
+   *   - Otherwise, input channel i feeds output channel i % output channels, averaged when downmixing.
+   */
+ public:
+  /// @brief Sets the channel counts and resets the matrix to the default for them.
+  /// @param input_channels Number of channels in an input frame
+  /// @param output_channels Number of channels in an output frame
+  /// @return True if successful, false if either count is 0 or larger than MAX_CHANNEL_MIXER_CHANNELS
+  bool configure(uint8_t input_channels, uint8_t output_channels);
+
+  /// @brief Replaces the mixing matrix. Must be called after configure().
+  /// @param q15_matrix Row-major output_channels x input_channels matrix of Q15 fixed-point weights. 1 << 15 is unity.
+  /// @return True if successful, false if the matrix doesn't match the configured channel counts
+  bool set_matrix(const std::vector<int32_t> &q15_matrix);
+
+  uint8_t get_input_channels() const { return this->input_channels_; }
+  uint8_t get_output_channels() const { return this->output_channels_; }
+
+  /// @brief Returns true if the matrix passes matching channel counts through unchanged
+  bool is_identity() const;
+
+  /// @brief Mixes one frame of Q31 fixed-point samples.
+  /// @param input Pointer to input_channels samples
+  /// @param output Pointer to store output_channels samples. Must not overlap the input.
+  void mix_frame(const int32_t *input, int32_t *output) const;
+
+  /// @brief Mixes packed little-endian frames, converting bits per sample at the same time.
+  /// @param input Pointer to the input frames
+  /// @param input_bytes_per_sample 1, 2, 3, or 4 bytes per input sample
+  /// @param output Pointer to store the output frames. Must not overlap the input.
+  /// @param output_bytes_per_sample 1, 2, 3, or 4 bytes per output sample
+  /// @param frames Number of frames to mix
+  void mix_frames(const uint8_t *input, size_t input_bytes_per_sample, uint8_t *output, size_t output_bytes_per_sample,
+                  uint32_t frames) const;
+
+ protected:
+  // Row-major output_channels_ x input_channels_ matrix of Q15 weights
+  int32_t matrix_[MAX_CHANNEL_MIXER_CHANNELS * MAX_CHANNEL_MIXER_CHANNELS]{};
+
+  uint8_t input_channels_{1};
+  uint8_t output_channels_{1};
+
+  // True if the matrix is a plain mono to multichannel duplication, which allows a faster 16 bit path
+  bool duplicate_mono_{false};
+};
+
+}  // namespace audio
+}  // namespace esphome
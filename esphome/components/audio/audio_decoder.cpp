@@ -4,6 +4,12 @@
 
 #include "esphome/core/hal.h"
 
+#ifdef USE_AUDIO_OPUS_SUPPORT
+#include "audio_gain.h"
+
+#include <cmath>
+#endif
+
 namespace esphome {
 namespace audio {
 
@@ -12,6 +18,12 @@ static const uint32_t READ_WRITE_TIMEOUT_MS = 20;  // Timeout for transferring a
 
 static const uint32_t MAX_POTENTIALLY_FAILED_COUNT = 10;
 
+#ifdef USE_AUDIO_OPUS_SUPPORT
+// Opus always decodes at 48 kHz here; packets hold at most 120 ms of audio
+static const uint32_t OPUS_SAMPLE_RATE = 48000;
+static const uint32_t OPUS_MAX_FRAMES_PER_PACKET = 5760;
+#endif
+
 AudioDecoder::AudioDecoder(size_t input_buffer_size, size_t output_buffer_size) {
   this->input_transfer_buffer_ = AudioSourceTransferBuffer::create(input_buffer_size);
   this->output_transfer_buffer_ = AudioSinkTransferBuffer::create(output_buffer_size);
@@ -23,6 +35,9 @@ AudioDecoder::~AudioDecoder() {
     esp_audio_libs::helix_decoder::MP3FreeDecoder(this->mp3_decoder_);
   }
 #endif
+#ifdef USE_AUDIO_OPUS_SUPPORT
+  this->free_opus_decoder_();
+#endif
 }
 
 esp_err_t AudioDecoder::add_source(std::weak_ptr<RingBuffer> &input_ring_buffer) {
@@ -60,6 +75,9 @@ esp_err_t AudioDecoder::start(AudioFileType audio_file_type) {
 
   this->potentially_failed_count_ = 0;
   this->end_of_file_ = false;
+#ifdef USE_AUDIO_TRACE
+  this->trace_blocks_ = 0;
+#endif
 
   switch (this->audio_file_type_) {
 #ifdef USE_AUDIO_FLAC_SUPPORT
@@ -79,6 +97,18 @@ esp_err_t AudioDecoder::start(AudioFileType audio_file_type) {
       // Always reallocate the output transfer buffer to the smallest necessary size
       this->output_transfer_buffer_->reallocate(this->free_buffer_required_);
       break;
+#endif
+#ifdef USE_AUDIO_OPUS_SUPPORT
+    case AudioFileType::OPUS:
+      this->ogg_demuxer_ = make_unique<OggDemuxer>();
+      if (!this->ogg_demuxer_->is_allocated()) {
+        return ESP_ERR_NO_MEM;
+      }
+      this->free_opus_decoder_();
+      this->opus_samples_decoded_ = 0;
+      this->opus_tags_read_ = false;
+      this->free_buffer_required_ = this->output_transfer_buffer_->capacity();  // Reallocated after reading the header
+      break;
 #endif
     case AudioFileType::WAV:
       this->wav_decoder_ = make_unique<esp_audio_libs::wav_decoder::WAVDecoder>();
@@ -91,6 +121,9 @@ esp_err_t AudioDecoder::start(AudioFileType audio_file_type) {
         this->output_transfer_buffer_->reallocate(this->free_buffer_required_);
       }
       break;
+    case AudioFileType::PCM:
+      // Without a header, the stream info must be provided
+      return ESP_ERR_INVALID_ARG;
     case AudioFileType::NONE:
     default:
       return ESP_ERR_NOT_SUPPORTED;
@@ -100,6 +133,29 @@ esp_err_t AudioDecoder::start(AudioFileType audio_file_type) {
   return ESP_OK;
 }
 
+esp_err_t AudioDecoder::start(AudioFileType audio_file_type, const AudioStreamInfo &pcm_stream_info) {
+  if (audio_file_type != AudioFileType::PCM) {
+    return this->start(audio_file_type);
+  }
+
+  if ((this->input_transfer_buffer_ == nullptr) || (this->output_transfer_buffer_ == nullptr)) {
+    return ESP_ERR_NO_MEM;
+  }
+
+  this->audio_file_type_ = audio_file_type;
+  this->audio_stream_info_ = pcm_stream_info;
+
+  this->potentially_failed_count_ = 0;
+  this->end_of_file_ = false;
+#ifdef USE_AUDIO_TRACE
+  this->trace_blocks_ = 0;
+#endif
+
+  this->free_buffer_required_ = pcm_stream_info.frames_to_bytes(1);
+
+  return ESP_OK;
+}
+
 AudioDecoderState AudioDecoder::decode(bool stop_gracefully) {
   if (stop_gracefully) {
     if (this->output_transfer_buffer_->available() == 0) {
@@ -123,6 +179,12 @@ AudioDecoderState AudioDecoder::decode(bool stop_gracefully) {
     return AudioDecoderState::FAILED;
   }
 
+  if (this->audio_file_type_ == AudioFileType::PCM) {
+    return this->pass_through_pcm_();
+  }
+
+  AUDIO_TRACE_SCOPE(trace, DECODER, this, &this->trace_blocks_);
+
   FileDecoderState state = FileDecoderState::MORE_TO_PROCESS;
 
   uint32_t decoding_start = millis();
@@ -134,20 +196,7 @@ AudioDecoderState AudioDecoder::decode(bool stop_gracefully) {
 
   while (state == FileDecoderState::MORE_TO_PROCESS) {
     // Transfer decoded out
-    if (!this->pause_output_) {
-      // Never shift the data in the output transfer buffer to avoid unnecessary, slow data moves
-      size_t bytes_written =
-          this->output_transfer_buffer_->transfer_data_to_sink(pdMS_TO_TICKS(READ_WRITE_TIMEOUT_MS), false);
-
-      if (this->audio_stream_info_.has_value()) {
-        this->accumulated_frames_written_ += this->audio_stream_info_.value().bytes_to_frames(bytes_written);
-        this->playback_ms_ +=
-            this->audio_stream_info_.value().frames_to_milliseconds_with_remainder(&this->accumulated_frames_written_);
-      }
-    } else {
-      // If paused, block to avoid wasting CPU resources
-      delay(READ_WRITE_TIMEOUT_MS);
-    }
+    this->transfer_output_to_sink_();
 
     // Verify there is enough space to store more decoded audio and that the function hasn't been running too long
     if ((this->output_transfer_buffer_->free() < this->free_buffer_required_) ||
@@ -199,6 +248,11 @@ AudioDecoderState AudioDecoder::decode(bool stop_gracefully) {
         case AudioFileType::WAV:
           state = this->decode_wav_();
           break;
+#ifdef USE_AUDIO_OPUS_SUPPORT
+        case AudioFileType::OPUS:
+          state = this->decode_opus_();
+          break;
+#endif
         case AudioFileType::NONE:
         default:
           state = FileDecoderState::IDLE;
@@ -208,6 +262,7 @@ AudioDecoderState AudioDecoder::decode(bool stop_gracefully) {
 
     first_loop_iteration = false;
     bytes_processed = bytes_available_before_processing - this->input_transfer_buffer_->available();
+    AUDIO_TRACE_ADD_BYTES(trace, bytes_processed);
 
     if (state == FileDecoderState::POTENTIALLY_FAILED) {
       ++this->potentially_failed_count_;
@@ -222,6 +277,41 @@ AudioDecoderState AudioDecoder::decode(bool stop_gracefully) {
   return AudioDecoderState::DECODING;
 }
 
+void AudioDecoder::transfer_output_to_sink_() {
+  if (!this->pause_output_) {
+    // Never shift the data in the output transfer buffer to avoid unnecessary, slow data moves
+    size_t bytes_written =
+        this->output_transfer_buffer_->transfer_data_to_sink(pdMS_TO_TICKS(READ_WRITE_TIMEOUT_MS), false);
+
+    if (this->audio_stream_info_.has_value()) {
+      this->accumulated_frames_written_ += this->audio_stream_info_.value().bytes_to_frames(bytes_written);
+      this->playback_ms_ +=
+          this->audio_stream_info_.value().frames_to_milliseconds_with_remainder(&this->accumulated_frames_written_);
+    }
+  } else {
+    // If paused, block to avoid wasting CPU resources
+    delay(READ_WRITE_TIMEOUT_MS);
+  }
+}
+
+AudioDecoderState AudioDecoder::pass_through_pcm_() {
+  AUDIO_TRACE_SCOPE(trace, DECODER, this, &this->trace_blocks_);
+
+  this->transfer_output_to_sink_();
+
+  // Skip the input transfer buffer, as there is nothing to parse. Reading straight into the output transfer buffer
+  // saves a copy.
+  const size_t bytes_to_read = this->output_transfer_buffer_->free();
+  if (bytes_to_read >= this->free_buffer_required_) {
+    size_t bytes_read = this->input_transfer_buffer_->read_into(this->output_transfer_buffer_->get_buffer_end(),
+                                                                bytes_to_read, pdMS_TO_TICKS(READ_WRITE_TIMEOUT_MS));
+    this->output_transfer_buffer_->increase_buffer_length(bytes_read);
+    AUDIO_TRACE_ADD_BYTES(trace, bytes_read);
+  }
+
+  return AudioDecoderState::DECODING;
+}
+
 #ifdef USE_AUDIO_FLAC_SUPPORT
 FileDecoderState AudioDecoder::decode_flac_() {
   if (!this->audio_stream_info_.has_value()) {
@@ -387,6 +477,130 @@ FileDecoderState AudioDecoder::decode_wav_() {
   return FileDecoderState::END_OF_FILE;
 }
 
+#ifdef USE_AUDIO_OPUS_SUPPORT
+FileDecoderState AudioDecoder::decode_opus_() {
+  size_t bytes_consumed = 0;
+  OggDemuxerResult result = this->ogg_demuxer_->demux(this->input_transfer_buffer_->get_buffer_start(),
+                                                      this->input_transfer_buffer_->available(), &bytes_consumed);
+  this->input_transfer_buffer_->decrease_buffer_length(bytes_consumed);
+
+  switch (result) {
+    case OggDemuxerResult::NEED_MORE_DATA:
+      // The demuxer keeps partial packets, so everything was consumed; wait for more data
+      return FileDecoderState::IDLE;
+    case OggDemuxerResult::END_OF_STREAM:
+      return FileDecoderState::END_OF_FILE;
+    case OggDemuxerResult::LOST_SYNC:
+      return FileDecoderState::POTENTIALLY_FAILED;
+    case OggDemuxerResult::PACKET:
+    default:
+      break;
+  }
+
+  const uint8_t *packet = this->ogg_demuxer_->get_packet();
+  const size_t packet_length = this->ogg_demuxer_->get_packet_length();
+
+  if (!this->audio_stream_info_.has_value()) {
+    return this->read_opus_header_(packet, packet_length);
+  }
+
+  if (!this->opus_tags_read_) {
+    // The second packet is the OpusTags comment header; nothing in it affects playback
+    this->opus_tags_read_ = true;
+    return FileDecoderState::MORE_TO_PROCESS;
+  }
+
+  const uint8_t channels = this->audio_stream_info_.value().get_channels();
+  int16_t *output = reinterpret_cast<int16_t *>(this->output_transfer_buffer_->get_buffer_end());
+
+  int frames = opus_decode(this->opus_decoder_, packet, packet_length, output, OPUS_MAX_FRAMES_PER_PACKET, 0);
+  if (frames < 0) {
+    // Corrupt packet; continue with the next one
+    return FileDecoderState::POTENTIALLY_FAILED;
+  }
+
+  const int64_t packet_start = this->opus_samples_decoded_;
+  this->opus_samples_decoded_ += frames;
+
+  // The granule position of the stream's final page marks where the audio ends; drop any padding after it
+  int64_t end_trim = 0;
+  if (this->ogg_demuxer_->is_last_packet() && (this->ogg_demuxer_->get_granule_position() >= 0)) {
+    end_trim = std::max<int64_t>(0, this->opus_samples_decoded_ - this->ogg_demuxer_->get_granule_position());
+  }
+
+  // Drop the encoder's startup samples
+  int64_t start_trim = 0;
+  if (packet_start < this->opus_pre_skip_) {
+    start_trim = std::min<int64_t>(frames, this->opus_pre_skip_ - packet_start);
+  }
+
+  const int64_t frames_kept = std::max<int64_t>(0, frames - start_trim - end_trim);
+  if (frames_kept > 0) {
+    if (start_trim > 0) {
+      std::memmove(output, output + start_trim * channels, frames_kept * channels * sizeof(int16_t));
+    }
+    if (this->opus_output_gain_ != Q15_UNITY_GAIN) {
+      apply_q15_gain_s16(output, output, frames_kept * channels, this->opus_output_gain_);
+    }
+    this->output_transfer_buffer_->increase_buffer_length(frames_kept * channels * sizeof(int16_t));
+  }
+
+  if (this->ogg_demuxer_->is_last_packet()) {
+    return FileDecoderState::END_OF_FILE;
+  }
+
+  return FileDecoderState::MORE_TO_PROCESS;
+}
+
+FileDecoderState AudioDecoder::read_opus_header_(const uint8_t *packet, size_t packet_length) {
+  // OpusHead layout (RFC 7845): magic, version, channel count, pre-skip, input sample rate, output gain, mapping family
+  if ((packet_length < 19) || (std::memcmp(packet, "OpusHead", 8) != 0) || ((packet[8] & 0xF0) != 0)) {
+    return FileDecoderState::FAILED;
+  }
+
+  const uint8_t channels = packet[9];
+  const uint8_t mapping_family = packet[18];
+  if ((mapping_family != 0) || (channels == 0) || (channels > 2)) {
+    // Multistream (surround) files aren't supported
+    return FileDecoderState::FAILED;
+  }
+
+  this->opus_pre_skip_ = static_cast<uint16_t>(packet[10] | (packet[11] << 8));
+  const int16_t output_gain_q8 = static_cast<int16_t>(packet[16] | (packet[17] << 8));
+  const float output_gain = powf(10.0f, output_gain_q8 / (20.0f * 256.0f));
+  this->opus_output_gain_ = clamp<int32_t>(lroundf(output_gain * Q15_UNITY_GAIN), 0, Q15_MAX_GAIN);
+
+  this->free_opus_decoder_();
+  RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  this->opus_decoder_size_ = opus_decoder_get_size(channels);
+  this->opus_decoder_ = reinterpret_cast<OpusDecoder *>(allocator.allocate(this->opus_decoder_size_));
+  if (this->opus_decoder_ == nullptr) {
+    return FileDecoderState::FAILED;
+  }
+  if (opus_decoder_init(this->opus_decoder_, OPUS_SAMPLE_RATE, channels) != OPUS_OK) {
+    return FileDecoderState::FAILED;
+  }
+
+  // Reallocate the output transfer buffer to hold the longest possible packet
+  this->free_buffer_required_ = OPUS_MAX_FRAMES_PER_PACKET * channels * sizeof(int16_t);
+  if (!this->output_transfer_buffer_->reallocate(this->free_buffer_required_)) {
+    return FileDecoderState::FAILED;
+  }
+
+  this->audio_stream_info_ = audio::AudioStreamInfo(16, channels, OPUS_SAMPLE_RATE);
+
+  return FileDecoderState::MORE_TO_PROCESS;
+}
+
+void AudioDecoder::free_opus_decoder_() {
+  if (this->opus_decoder_ != nullptr) {
+    RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+    allocator.deallocate(reinterpret_cast<uint8_t *>(this->opus_decoder_), this->opus_decoder_size_);
+    this->opus_decoder_ = nullptr;
+  }
+}
+#endif
+
 }  // namespace audio
 }  // namespace esphome
 
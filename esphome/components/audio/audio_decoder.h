@@ -3,6 +3,7 @@
 #ifdef USE_ESP32
 
 #include "audio.h"
+#include "audio_trace.h"
 #include "audio_transfer_buffer.h"
 
 #include "esphome/core/defines.h"
@@ -24,6 +25,12 @@
 #endif
 #include <wav_decoder.h>
 
+#ifdef USE_AUDIO_OPUS_SUPPORT
+#include "audio_ogg_demuxer.h"
+
+#include <opus.h>
+#endif
+
 namespace esphome {
 namespace audio {
 
@@ -47,7 +54,8 @@ class AudioDecoder {
    * @brief Class that facilitates decoding an audio file.
    * The audio file is read from a ring buffer source, decoded, and sent to an audio sink (ring buffer or speaker
    * component).
-   * Supports wav, flac, and mp3 formats.
+   * Supports wav, flac, mp3, and Ogg/Opus formats. Headerless PCM is passed through from the source to the sink
+   * without parsing.
    */
  public:
   /// @brief Allocates the input and output transfer buffers
@@ -55,7 +63,7 @@ class AudioDecoder {
   /// @param output_buffer_size Size of the output transfer buffer in bytes.
   AudioDecoder(size_t input_buffer_size, size_t output_buffer_size);
 
-  /// @brief Deallocates the MP3 decoder (the flac and wav decoders are deallocated automatically)
+  /// @brief Deallocates the MP3 and Opus decoders (the flac and wav decoders are deallocated automatically)
   ~AudioDecoder();
 
   /// @brief Adds a source ring buffer for raw file data. Takes ownership of the ring buffer in a shared_ptr.
@@ -81,6 +89,13 @@ class AudioDecoder {
   /// the format isn't supported.
   esp_err_t start(AudioFileType audio_file_type);
 
+  /// @brief Sets up passing through headerless PCM audio, which has no header to read the stream info from
+  /// @param audio_file_type AudioFileType of the file. Any type other than PCM ignores the stream info.
+  /// @param pcm_stream_info Format of the PCM audio
+  /// @return ESP_OK if successful, ESP_ERR_NO_MEM if the transfer buffers fail to allocate, or ESP_ERR_NOT_SUPPORTED if
+  /// the format isn't supported.
+  esp_err_t start(AudioFileType audio_file_type, const AudioStreamInfo &pcm_stream_info);
+
   /// @brief Decodes audio from the ring buffer source and writes to the sink.
   /// @param stop_gracefully If true, it indicates the file source is finished. The decoder will decode all the
   /// reamining data and then finish.
@@ -100,6 +115,12 @@ class AudioDecoder {
   void set_pause_output_state(bool pause_state) { this->pause_output_ = pause_state; }
 
  protected:
+  /// @brief Writes decoded audio from the output transfer buffer to the sink, unless paused
+  void transfer_output_to_sink_();
+
+  /// @brief Reads PCM audio from the source directly into the output transfer buffer
+  AudioDecoderState pass_through_pcm_();
+
   std::unique_ptr<esp_audio_libs::wav_decoder::WAVDecoder> wav_decoder_;
 #ifdef USE_AUDIO_FLAC_SUPPORT
   FileDecoderState decode_flac_();
@@ -110,6 +131,22 @@ class AudioDecoder {
   esp_audio_libs::helix_decoder::HMP3Decoder mp3_decoder_;
 #endif
   FileDecoderState decode_wav_();
+#ifdef USE_AUDIO_OPUS_SUPPORT
+  FileDecoderState decode_opus_();
+
+  /// @brief Parses the OpusHead identification header and creates the Opus decoder
+  FileDecoderState read_opus_header_(const uint8_t *packet, size_t packet_length);
+
+  void free_opus_decoder_();
+
+  std::unique_ptr<OggDemuxer> ogg_demuxer_;
+  OpusDecoder *opus_decoder_{nullptr};
+  size_t opus_decoder_size_{0};
+  uint32_t opus_pre_skip_{0};        // Samples to discard at the start of the stream
+  int32_t opus_output_gain_{0};      // Q15 gain from the header's output gain field
+  int64_t opus_samples_decoded_{0};  // 48 kHz samples per channel decoded so far, including pre-skip
+  bool opus_tags_read_{false};
+#endif
 
   std::unique_ptr<AudioSourceTransferBuffer> input_transfer_buffer_;
   std::unique_ptr<AudioSinkTransferBuffer> output_transfer_buffer_;
@@ -128,6 +165,10 @@ class AudioDecoder {
 
   uint32_t accumulated_frames_written_{0};
   uint32_t playback_ms_{0};
+
+#ifdef USE_AUDIO_TRACE
+  uint32_t trace_blocks_{0};
+#endif
 };
 }  // namespace audio
 }  // namespace esphome
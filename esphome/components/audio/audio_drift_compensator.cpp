@@ -0,0 +1,274 @@
+#include "audio_drift_compensator.h"
+
+#ifdef USE_ESP32
+
+#include "audio_filter_design.h"
+
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace audio {
+
+static const float MAX_CORRECTION = DRIFT_COMPENSATION_MAX_PPM * 1e-6f;
+
+// Time constant of the low-pass filter that smooths the fill level. The sink drains in DMA sized chunks, so the raw
+// fill level jumps around far more than it drifts.
+static const float FILL_LEVEL_FILTER_SECONDS = 2.0f;
+
+// PI servo gains, with the error measured in seconds of audio so the loop behaves the same for any sink buffer size.
+// The loop is close to critically damped with a natural frequency of 0.05 rad/s; a 1 ms error initially corrects the
+// ratio by 70 ppm.
+static const float PROPORTIONAL_GAIN = 0.07f;
+static const float INTEGRAL_GAIN = 0.0025f;
+
+// The interpolation filter has 2^7 phases; the next 15 bits of the fractional position interpolate between phases
+static const uint8_t PHASE_BITS = 7;
+static const uint16_t PHASES = 1 << PHASE_BITS;
+
+// Kaiser window beta and cutoff (cycles per sample) of the interpolation filter. The passband is flat to about 0.39
+// times the sample rate, with about 65 dB of stopband attenuation.
+static constexpr double KAISER_BETA = 6.5;
+static constexpr double CUTOFF = 0.47;
+
+struct FractionalDelayFilter {
+  // Row p holds the taps for a read position p / PHASES past the older middle history frame. The extra row lets the
+  // last phase interpolate toward a full frame of delay.
+  int16_t phases[PHASES + 1][DRIFT_COMPENSATOR_TAPS];
+};
+
+static constexpr FractionalDelayFilter design_fractional_delay_filter() {
+  FractionalDelayFilter filter{};
+
+  const double half_length = DRIFT_COMPENSATOR_TAPS / 2;
+  for (uint16_t phase = 0; phase <= PHASES; ++phase) {
+    const double fraction = static_cast<double>(phase) / PHASES;
+
+    double taps[DRIFT_COMPENSATOR_TAPS]{};
+    double sum = 0.0;
+    for (uint8_t tap = 0; tap < DRIFT_COMPENSATOR_TAPS; ++tap) {
+      // Tap 0 multiplies the oldest history sample
+      const double t = tap - (half_length - 1) - fraction;
+      taps[tap] = filter_design::kaiser_sinc(t, CUTOFF, half_length, KAISER_BETA);
+      sum += taps[tap];
+    }
+
+    // Normalize every phase to unity gain at DC
+    for (uint8_t tap = 0; tap < DRIFT_COMPENSATOR_TAPS; ++tap) {
+      filter.phases[phase][tap] = filter_design::to_q15(taps[tap] / sum);
+    }
+  }
+
+  return filter;
+}
+
+static constexpr FractionalDelayFilter FRACTIONAL_DELAY_FILTER = design_fractional_delay_filter();
+
+bool DriftCompensator::initialize(const AudioStreamInfo &input_stream_info,
+                                  const AudioStreamInfo &output_stream_info, const ChannelMixer *channel_mixer) {
+  this->input_channels_ = input_stream_info.get_channels();
+  this->output_channels_ = output_stream_info.get_channels();
+  this->channel_mixer_ = channel_mixer;
+
+  if (input_stream_info.get_sample_rate() != output_stream_info.get_sample_rate()) {
+    return false;
+  }
+
+  if (channel_mixer != nullptr) {
+    if ((channel_mixer->get_input_channels() != this->input_channels_) ||
+        (channel_mixer->get_output_channels() != this->output_channels_)) {
+      return false;
+    }
+  } else if ((this->input_channels_ != this->output_channels_) ||
+             (this->input_channels_ > MAX_DRIFT_COMPENSATOR_CHANNELS)) {
+    return false;
+  }
+
+  // Filter the smaller number of channels
+  this->mix_on_input_ = this->output_channels_ <= this->input_channels_;
+  this->channels_ = this->mix_on_input_ ? this->output_channels_ : this->input_channels_;
+
+  this->input_bytes_per_sample_ = input_stream_info.samples_to_bytes(1);
+  this->output_bytes_per_sample_ = output_stream_info.samples_to_bytes(1);
+  this->sample_rate_ = input_stream_info.get_sample_rate();
+
+  // The mixer works with Q31 samples, so mixing always uses the wide path
+  this->narrow_ = (this->input_bytes_per_sample_ == 2) && (this->output_bytes_per_sample_ == 2) &&
+                  (this->channel_mixer_ == nullptr);
+
+  memset(this->history_, 0, sizeof(this->history_));
+  this->history_index_ = 0;
+
+  // Consume one input frame before generating the first output frame
+  this->position_ = 1ULL << 32;
+  this->step_ = 1ULL << 32;
+
+  this->filtered_error_ = 0.0f;
+  this->integral_ = 0.0f;
+  this->correction_ = 0.0f;
+  this->servo_primed_ = false;
+  this->frames_since_update_ = 0;
+
+  return true;
+}
+
+void DriftCompensator::update_buffer_level(uint32_t buffered_frames, uint32_t capacity_frames) {
+  if (capacity_frames == 0) {
+    return;
+  }
+
+  const float target_frames = this->target_fill_level_ * capacity_frames;
+  const float error = (std::min(buffered_frames, capacity_frames) - target_frames) / this->sample_rate_;
+
+  if (!this->servo_primed_) {
+    // The sink starts empty or with whatever is left over, so start the filter at the first real measurement
+    this->filtered_error_ = error;
+    this->servo_primed_ = true;
+    this->frames_since_update_ = 0;
+    return;
+  }
+
+  if (this->frames_since_update_ == 0) {
+    // No audio was generated since the last update, e.g., the sink is full and blocking. Don't integrate stale errors.
+    return;
+  }
+
+  const float elapsed_seconds = static_cast<float>(this->frames_since_update_) / this->sample_rate_;
+  this->frames_since_update_ = 0;
+
+  const float alpha = std::min(1.0f, elapsed_seconds / FILL_LEVEL_FILTER_SECONDS);
+  this->filtered_error_ += (error - this->filtered_error_) * alpha;
+
+  // Limit the integral so it never requests more than the maximum correction on its own (anti-windup)
+  const float max_integral = MAX_CORRECTION / INTEGRAL_GAIN;
+  this->integral_ =
+      clamp<float>(this->integral_ + this->filtered_error_ * elapsed_seconds, -max_integral, max_integral);
+
+  this->correction_ = clamp<float>(PROPORTIONAL_GAIN * this->filtered_error_ + INTEGRAL_GAIN * this->integral_,
+                                   -MAX_CORRECTION, MAX_CORRECTION);
+
+  // A fuller sink consumes input faster than nominal, generating fewer output frames per input frame
+  this->step_ = (1ULL << 32) + static_cast<int64_t>(this->correction_ * 4294967296.0f);
+}
+
+DriftCompensatorResults DriftCompensator::resample(const uint8_t *input, uint8_t *output, uint32_t input_frames,
+                                                   uint32_t output_frames) {
+  DriftCompensatorResults results = {.frames_used = 0, .frames_generated = 0};
+
+  const size_t input_frame_size = this->input_bytes_per_sample_ * this->input_channels_;
+  const size_t output_frame_size = this->output_bytes_per_sample_ * this->output_channels_;
+
+  while (true) {
+    // Consume input frames until the read position lies between the two middle history frames
+    while (this->position_ >= (1ULL << 32)) {
+      if (results.frames_used >= input_frames) {
+        this->frames_since_update_ += results.frames_generated;
+        return results;
+      }
+      this->push_frame_(input);
+      input += input_frame_size;
+      ++results.frames_used;
+      this->position_ -= (1ULL << 32);
+    }
+
+    if (results.frames_generated >= output_frames) {
+      break;
+    }
+
+    this->compute_frame_(static_cast<uint32_t>(this->position_), output);
+    output += output_frame_size;
+    ++results.frames_generated;
+    this->position_ += this->step_;
+  }
+
+  this->frames_since_update_ += results.frames_generated;
+  return results;
+}
+
+void DriftCompensator::push_frame_(const uint8_t *frame) {
+  this->history_index_ = (this->history_index_ + 1 == DRIFT_COMPENSATOR_TAPS) ? 0 : this->history_index_ + 1;
+
+  int32_t mixed_frame[MAX_CHANNEL_MIXER_CHANNELS];
+  if ((this->channel_mixer_ != nullptr) && this->mix_on_input_) {
+    int32_t input_frame[MAX_CHANNEL_MIXER_CHANNELS];
+    for (uint8_t channel = 0; channel < this->input_channels_; ++channel) {
+      input_frame[channel] = unpack_audio_sample_to_q31(frame + channel * this->input_bytes_per_sample_,
+                                                        this->input_bytes_per_sample_);
+    }
+    this->channel_mixer_->mix_frame(input_frame, mixed_frame);
+  }
+
+  for (uint8_t channel = 0; channel < this->channels_; ++channel) {
+    int32_t sample;
+    if ((this->channel_mixer_ != nullptr) && this->mix_on_input_) {
+      sample = mixed_frame[channel];
+    } else if (this->narrow_) {
+      sample = reinterpret_cast<const int16_t *>(frame)[channel];
+    } else {
+      sample = unpack_audio_sample_to_q31(frame + channel * this->input_bytes_per_sample_,
+                                          this->input_bytes_per_sample_);
+    }
+
+    this->history_[channel][this->history_index_] = sample;
+    this->history_[channel][this->history_index_ + DRIFT_COMPENSATOR_TAPS] = sample;
+  }
+}
+
+void DriftCompensator::compute_frame_(uint32_t fraction, uint8_t *output) {
+  const uint32_t phase = fraction >> (32 - PHASE_BITS);
+  const int32_t phase_fraction = (fraction >> (32 - PHASE_BITS - 15)) & 0x7FFF;
+
+  // Linearly interpolate the coefficients between the two nearest phases once for all channels
+  const int16_t *lower = FRACTIONAL_DELAY_FILTER.phases[phase];
+  const int16_t *upper = FRACTIONAL_DELAY_FILTER.phases[phase + 1];
+  int32_t coefficients[DRIFT_COMPENSATOR_TAPS];
+  for (uint8_t tap = 0; tap < DRIFT_COMPENSATOR_TAPS; ++tap) {
+    coefficients[tap] = lower[tap] + (((upper[tap] - lower[tap]) * phase_fraction) >> 15);
+  }
+
+  const bool mix_on_output = (this->channel_mixer_ != nullptr) && !this->mix_on_input_;
+  int32_t filtered_frame[MAX_CHANNEL_MIXER_CHANNELS];
+
+  for (uint8_t channel = 0; channel < this->channels_; ++channel) {
+    // Oldest sample; newer samples are at increasing addresses
+    const int32_t *oldest = this->history_[channel] + this->history_index_ + 1;
+
+    if (this->narrow_) {
+      // 16 bit samples times Q15 coefficients; the filter's absolute sum is below 2, so 32 bits never overflow
+      int32_t accumulator = 1 << 14;  // Rounding
+      for (uint8_t tap = 0; tap < DRIFT_COMPENSATOR_TAPS; ++tap) {
+        accumulator += oldest[tap] * coefficients[tap];
+      }
+      reinterpret_cast<int16_t *>(output)[channel] =
+          static_cast<int16_t>(clamp<int32_t>(accumulator >> 15, INT16_MIN, INT16_MAX));
+    } else {
+      int64_t accumulator = 1 << 14;  // Rounding
+      for (uint8_t tap = 0; tap < DRIFT_COMPENSATOR_TAPS; ++tap) {
+        accumulator += static_cast<int64_t>(oldest[tap]) * coefficients[tap];
+      }
+      const int32_t sample = static_cast<int32_t>(clamp<int64_t>(accumulator >> 15, INT32_MIN, INT32_MAX));
+      if (mix_on_output) {
+        filtered_frame[channel] = sample;
+      } else {
+        pack_q31_as_audio_sample(sample, output + channel * this->output_bytes_per_sample_,
+                                 this->output_bytes_per_sample_);
+      }
+    }
+  }
+
+  if (mix_on_output) {
+    int32_t mixed_frame[MAX_CHANNEL_MIXER_CHANNELS];
+    this->channel_mixer_->mix_frame(filtered_frame, mixed_frame);
+    for (uint8_t channel = 0; channel < this->output_channels_; ++channel) {
+      pack_q31_as_audio_sample(mixed_frame[channel], output + channel * this->output_bytes_per_sample_,
+                               this->output_bytes_per_sample_);
+    }
+  }
+}
+
+}  // namespace audio
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,117 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "audio.h"
+#include "audio_channel_mixer.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace audio {
+
+// Largest correction the servo applies to the conversion ratio. Inaudible as a pitch change (under 1 cent), but covers
+// the tolerance of typical crystal oscillators on both ends of a stream.
+static const float DRIFT_COMPENSATION_MAX_PPM = 500.0f;
+
+static const uint8_t MAX_DRIFT_COMPENSATOR_CHANNELS = MAX_CHANNEL_MIXER_CHANNELS;
+
+// Number of FIR taps used to interpolate each output sample
+static const uint8_t DRIFT_COMPENSATOR_TAPS = 24;
+
+struct DriftCompensatorResults {
+  uint32_t frames_used;
+  uint32_t frames_generated;
+};
+
+class DriftCompensator {
+  /*
+   * @brief Asynchronous sample rate converter that compensates for clock drift between an audio source and sink with
+   * the same nominal sample rate (e.g., a network stream on the sender's clock and the local I2S clock).
+   *   - The sink's buffer fill level is fed to a PI servo that slowly adjusts the conversion ratio, keeping the fill
+   *     level near a target instead of letting the buffer overflow or underrun.
+   *   - Samples are interpolated at the fractional read position with a Kaiser windowed-sinc filter. The filter has 128
+   *     phases generated at compile time, and the coefficients are linearly interpolated between adjacent phases.
+   * Also converts bits per sample. 16 bit to 16 bit conversions use 32 bit accumulators; wider samples use 64 bit.
+   * An optional channel mixer is fused into the filter, so only the smaller number of channels is ever filtered.
+   */
+ public:
+  /// @brief Resets the servo and interpolation state.
+  /// @param input_stream_info The incoming stream information
+  /// @param output_stream_info The outgoing stream information. Must have the same sample rate.
+  /// @param channel_mixer Optional mixer that converts between the input and output channels. Must outlive this object.
+  ///                      Required if the channel counts differ.
+  /// @return True if successful, false if the streams can't be converted
+  bool initialize(const AudioStreamInfo &input_stream_info, const AudioStreamInfo &output_stream_info,
+                  const ChannelMixer *channel_mixer = nullptr);
+
+  /// @brief Sets the sink fill level the servo holds, as a fraction of the sink's capacity. Defaults to 0.5.
+  void set_target_fill_level(float target_fill_level) { this->target_fill_level_ = target_fill_level; }
+
+  /// @brief Runs one servo update using the sink's current fill level. Call once per processed block.
+  /// @param buffered_frames Number of frames currently buffered in the sink
+  /// @param capacity_frames Number of frames the sink can buffer
+  void update_buffer_level(uint32_t buffered_frames, uint32_t capacity_frames);
+
+  /// @brief Returns the current ratio correction in parts per million. Positive values consume input faster.
+  float get_correction_ppm() const { return this->correction_ * 1e6f; }
+
+  /// @brief Converts as many frames as possible without overflowing the output buffer.
+  /// @param input Pointer to the input audio frames
+  /// @param output Pointer to the output buffer
+  /// @param input_frames Number of frames available in the input
+  /// @param output_frames Number of frames that fit in the output buffer
+  /// @return DriftCompensatorResults with the number of frames used and generated
+  DriftCompensatorResults resample(const uint8_t *input, uint8_t *output, uint32_t input_frames,
+                                   uint32_t output_frames);
+
+ protected:
+  /// @brief Stores the input frame as the newest frame in the interpolation history
+  void push_frame_(const uint8_t *frame);
+
+  /// @brief Interpolates one output frame between the two middle history frames
+  /// @param fraction Q32 fixed point read position past the older of the two middle history frames
+  /// @param output Pointer to store the packed output frame
+  void compute_frame_(uint32_t fraction, uint8_t *output);
+
+  // History of recent input samples. Each channel stores every sample twice, so the newest DRIFT_COMPENSATOR_TAPS
+  // samples are always contiguous.
+  int32_t history_[MAX_DRIFT_COMPENSATOR_CHANNELS][2 * DRIFT_COMPENSATOR_TAPS];
+  uint8_t history_index_{0};
+
+  // If true, the history stores 16 bit samples and uses 32 bit accumulators; otherwise Q31 samples and 64 bit
+  bool narrow_{true};
+
+  // Read position in Q32 fixed point. The integer part counts input frames to consume before the next output frame.
+  uint64_t position_{0};
+  // Q32 fixed point input frames consumed per output frame
+  uint64_t step_{1ULL << 32};
+
+  float target_fill_level_{0.5f};
+  // Low-pass filtered difference between the buffered and target durations, in seconds
+  float filtered_error_{0.0f};
+  float integral_{0.0f};
+  float correction_{0.0f};
+  bool servo_primed_{false};
+
+  // Output frames generated since the last servo update; used to measure elapsed time
+  uint32_t frames_since_update_{0};
+  uint32_t sample_rate_{16000};
+
+  const ChannelMixer *channel_mixer_{nullptr};
+  // If true, the mixer runs on input frames before filtering; otherwise on filtered frames before packing
+  bool mix_on_input_{false};
+
+  // Number of channels stored in the history and filtered
+  uint8_t channels_{1};
+  uint8_t input_channels_{1};
+  uint8_t output_channels_{1};
+  size_t input_bytes_per_sample_{2};
+  size_t output_bytes_per_sample_{2};
+};
+
+}  // namespace audio
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,355 @@
+#include "audio_file_cache.h"
+
+#ifdef USE_ESP32
+
+#include "esphome/core/log.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace esphome {
+namespace audio {
+
+static const char *const TAG = "audio.file_cache";
+
+static const char *const STORE_FILE_EXTENSION = ".acf";
+static const char *const STORE_TEMPORARY_EXTENSION = ".tmp";
+static const uint32_t STORE_FILE_MAGIC = 0x31464341;  // "ACF1"
+
+struct StoredFileHeader {
+  uint32_t magic;
+  uint32_t data_length;
+  uint32_t checksum;
+  uint16_t url_length;
+  uint16_t etag_length;
+  uint8_t file_type;
+  uint8_t reserved[3];
+};
+
+// FNV-1a; cheap enough to check every load and catches truncated or flipped data
+static uint32_t fnv1a_hash(const uint8_t *data, size_t length, uint32_t hash = 2166136261UL) {
+  for (size_t i = 0; i < length; ++i) {
+    hash = (hash ^ data[i]) * 16777619UL;
+  }
+  return hash;
+}
+
+static bool ends_with(const char *name, const char *suffix) {
+  const size_t name_length = strlen(name);
+  const size_t suffix_length = strlen(suffix);
+  return (name_length >= suffix_length) && (strcmp(name + name_length - suffix_length, suffix) == 0);
+}
+
+std::string AudioFileStore::path_for_(const std::string &url) const {
+  char name[16];
+  snprintf(name, sizeof(name), "/%08x",
+           (unsigned) fnv1a_hash(reinterpret_cast<const uint8_t *>(url.data()), url.size()));
+  return this->directory_ + name + STORE_FILE_EXTENSION;
+}
+
+void AudioFileStore::scan_() {
+  this->scanned_ = true;
+
+  DIR *dir = opendir(this->directory_.c_str());
+  if (dir == nullptr) {
+    ESP_LOGW(TAG, "Can't open %s", this->directory_.c_str());
+    return;
+  }
+  struct dirent *dir_entry;
+  while ((dir_entry = readdir(dir)) != nullptr) {
+    const std::string path = this->directory_ + "/" + dir_entry->d_name;
+    if (ends_with(dir_entry->d_name, STORE_TEMPORARY_EXTENSION)) {
+      // Left over from an interrupted write
+      std::remove(path.c_str());
+    } else if (ends_with(dir_entry->d_name, STORE_FILE_EXTENSION)) {
+      struct stat file_stat;
+      if (stat(path.c_str(), &file_stat) == 0) {
+        // Recency isn't persisted, so files from before the scan are evicted first, in directory order
+        this->files_.push_back({path, static_cast<size_t>(file_stat.st_size), 0});
+        this->stored_bytes_ += file_stat.st_size;
+      }
+    }
+  }
+  closedir(dir);
+}
+
+void AudioFileStore::remove_(const std::string &path) {
+  std::remove(path.c_str());
+  for (auto it = this->files_.begin(); it != this->files_.end(); ++it) {
+    if (it->path == path) {
+      this->stored_bytes_ -= it->size;
+      this->files_.erase(it);
+      return;
+    }
+  }
+}
+
+bool AudioFileStore::save(const std::string &url, const std::string &etag, AudioFileType file_type,
+                          const uint8_t *data, size_t length) {
+  if (!this->scanned_) {
+    this->scan_();
+  }
+
+  const size_t file_size = sizeof(StoredFileHeader) + url.size() + etag.size() + length;
+  if ((file_size > this->max_bytes_) || (url.size() > UINT16_MAX) || (etag.size() > UINT16_MAX)) {
+    return false;
+  }
+
+  const std::string path = this->path_for_(url);
+  this->remove_(path);
+  while ((this->stored_bytes_ + file_size > this->max_bytes_) && !this->files_.empty()) {
+    auto oldest = std::min_element(this->files_.begin(), this->files_.end(),
+                                   [](const StoredFile &a, const StoredFile &b) { return a.last_used < b.last_used; });
+    this->remove_(oldest->path);
+  }
+
+  StoredFileHeader header{};
+  header.magic = STORE_FILE_MAGIC;
+  header.data_length = length;
+  header.checksum = fnv1a_hash(data, length);
+  header.url_length = url.size();
+  header.etag_length = etag.size();
+  header.file_type = static_cast<uint8_t>(file_type);
+
+  const std::string temporary_path = path + STORE_TEMPORARY_EXTENSION;
+  FILE *file = fopen(temporary_path.c_str(), "wb");
+  if (file == nullptr) {
+    ESP_LOGW(TAG, "Can't create %s", temporary_path.c_str());
+    return false;
+  }
+  bool written = (fwrite(&header, sizeof(header), 1, file) == 1) &&
+                 (fwrite(url.data(), 1, url.size(), file) == url.size()) &&
+                 (fwrite(etag.data(), 1, etag.size(), file) == etag.size()) &&
+                 (fwrite(data, 1, length, file) == length);
+  written = (fclose(file) == 0) && written;
+  if (!written || (std::rename(temporary_path.c_str(), path.c_str()) != 0)) {
+    ESP_LOGW(TAG, "Failed to write %s", path.c_str());
+    std::remove(temporary_path.c_str());
+    return false;
+  }
+
+  this->files_.push_back({path, file_size, ++this->use_counter_});
+  this->stored_bytes_ += file_size;
+  return true;
+}
+
+uint8_t *AudioFileStore::load(const std::string &url, size_t max_length, std::string &etag, AudioFileType &file_type,
+                              size_t &length) {
+  if (!this->scanned_) {
+    this->scan_();
+  }
+
+  const std::string path = this->path_for_(url);
+  auto stored = std::find_if(this->files_.begin(), this->files_.end(),
+                             [&path](const StoredFile &file) { return file.path == path; });
+  if (stored == this->files_.end()) {
+    return nullptr;
+  }
+
+  FILE *file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    this->remove_(path);
+    return nullptr;
+  }
+
+  StoredFileHeader header{};
+  std::string stored_url;
+  bool valid = (fread(&header, sizeof(header), 1, file) == 1) && (header.magic == STORE_FILE_MAGIC) &&
+               (sizeof(header) + header.url_length + header.etag_length + header.data_length == stored->size);
+  if (valid) {
+    stored_url.resize(header.url_length);
+    etag.resize(header.etag_length);
+    valid = (fread(&stored_url[0], 1, header.url_length, file) == header.url_length) &&
+            (fread(&etag[0], 1, header.etag_length, file) == header.etag_length);
+  }
+
+  RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  uint8_t *data = nullptr;
+  if (valid) {
+    if ((stored_url != url) || (header.data_length > max_length)) {
+      // A different url with the same hash, or too large to load; leave it stored
+      fclose(file);
+      return nullptr;
+    }
+    data = allocator.allocate(header.data_length);
+    if (data == nullptr) {
+      fclose(file);
+      return nullptr;
+    }
+    valid = (fread(data, 1, header.data_length, file) == header.data_length) &&
+            (fnv1a_hash(data, header.data_length) == header.checksum);
+  }
+  fclose(file);
+
+  if (!valid) {
+    ESP_LOGW(TAG, "Deleting truncated or corrupt %s", path.c_str());
+    if (data != nullptr) {
+      allocator.deallocate(data, header.data_length);
+    }
+    this->remove_(path);
+    return nullptr;
+  }
+
+  stored->last_used = ++this->use_counter_;
+  file_type = static_cast<AudioFileType>(header.file_type);
+  length = header.data_length;
+  return data;
+}
+
+AudioCacheEntry::AudioCacheEntry(const std::string &url, const std::string &etag, AudioFileType file_type,
+                                 uint8_t *data, size_t length)
+    : etag_(etag) {
+  this->file_.data = data;
+  this->file_.length = length;
+  this->file_.file_type = file_type;
+  this->urls_.push_back(url);
+}
+
+AudioCacheEntry::~AudioCacheEntry() {
+  RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  allocator.deallocate(const_cast<uint8_t *>(this->file_.data), this->file_.length);
+}
+
+bool AudioCacheEntry::matches_url(const std::string &url) const {
+  return std::find(this->urls_.begin(), this->urls_.end(), url) != this->urls_.end();
+}
+
+AudioFileCache &AudioFileCache::get() {
+  static AudioFileCache cache;
+#ifdef AUDIO_FILE_STORE_PATH
+  static const bool store_set = [] {
+    cache.set_store(make_unique<AudioFileStore>(AUDIO_FILE_STORE_PATH, AUDIO_FILE_STORE_MAX_BYTES));
+    return true;
+  }();
+  (void) store_set;
+#endif
+  return cache;
+}
+
+std::shared_ptr<AudioCacheEntry> AudioFileCache::lookup(const std::string &url) {
+  LockGuard guard(this->lock_);
+  for (auto &entry : this->entries_) {
+    if (entry->matches_url(url)) {
+      entry->last_used_ = ++this->use_counter_;
+      return entry;
+    }
+  }
+
+  if (this->store_ != nullptr) {
+    std::string etag;
+    AudioFileType file_type;
+    size_t length;
+    uint8_t *data = this->store_->load(url, this->max_bytes_, etag, file_type, length);
+    if (data != nullptr) {
+      return this->insert_(url, etag, file_type, data, length);
+    }
+  }
+  return nullptr;
+}
+
+uint8_t *AudioFileCache::allocate(size_t length) {
+  if (!this->can_cache(length)) {
+    return nullptr;
+  }
+  RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  return allocator.allocate(length);
+}
+
+void AudioFileCache::deallocate(uint8_t *data, size_t length) {
+  if (data != nullptr) {
+    RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+    allocator.deallocate(data, length);
+  }
+}
+
+void AudioFileCache::insert(const std::string &url, const std::string &etag, AudioFileType file_type, uint8_t *data,
+                            size_t length) {
+  LockGuard guard(this->lock_);
+  auto entry = this->insert_(url, etag, file_type, data, length);
+  if ((entry != nullptr) && (this->store_ != nullptr)) {
+    this->store_->save(url, etag, file_type, entry->file_.data, length);
+  }
+}
+
+std::shared_ptr<AudioCacheEntry> AudioFileCache::insert_(const std::string &url, const std::string &etag,
+                                                         AudioFileType file_type, uint8_t *data, size_t length) {
+  if (!this->can_cache(length)) {
+    this->deallocate(data, length);
+    return nullptr;
+  }
+
+  for (auto &entry : this->entries_) {
+    if (!etag.empty() && (entry->etag_ == etag) && (entry->file_.length == length)) {
+      // Same content served from another url; share the existing copy
+      if (!entry->matches_url(url)) {
+        entry->urls_.push_back(url);
+      }
+      entry->last_used_ = ++this->use_counter_;
+      this->deallocate(data, length);
+      return entry;
+    }
+  }
+
+  // Drop any stale copy stored under this url
+  for (auto it = this->entries_.begin(); it != this->entries_.end(); ++it) {
+    if ((*it)->matches_url(url)) {
+      (*it)->urls_.erase(std::find((*it)->urls_.begin(), (*it)->urls_.end(), url));
+      if ((*it)->urls_.empty()) {
+        this->cached_bytes_ -= (*it)->file_.length;
+        this->entries_.erase(it);
+      }
+      break;
+    }
+  }
+
+  this->evict_to_(this->max_bytes_ - length);
+
+  auto entry = std::make_shared<AudioCacheEntry>(url, etag, file_type, data, length);
+  entry->last_used_ = ++this->use_counter_;
+  this->entries_.push_back(entry);
+  this->cached_bytes_ += length;
+  return entry;
+}
+
+void AudioFileCache::clear() {
+  LockGuard guard(this->lock_);
+  this->evict_to_(0);
+}
+
+void AudioFileCache::set_max_bytes(size_t max_bytes) {
+  LockGuard guard(this->lock_);
+  this->max_bytes_ = max_bytes;
+  this->evict_to_(max_bytes);
+}
+
+size_t AudioFileCache::get_cached_bytes() {
+  LockGuard guard(this->lock_);
+  return this->cached_bytes_;
+}
+
+void AudioFileCache::set_store(std::unique_ptr<AudioFileStore> store) {
+  LockGuard guard(this->lock_);
+  this->store_ = std::move(store);
+}
+
+void AudioFileCache::evict_to_(size_t max_bytes) {
+  while ((this->cached_bytes_ > max_bytes) && !this->entries_.empty()) {
+    auto oldest = std::min_element(
+        this->entries_.begin(), this->entries_.end(),
+        [](const std::shared_ptr<AudioCacheEntry> &a, const std::shared_ptr<AudioCacheEntry> &b) {
+          return a->last_used_ < b->last_used_;
+        });
+    this->cached_bytes_ -= (*oldest)->file_.length;
+    // Only frees the data now if no reader is still playing it
+    this->entries_.erase(oldest);
+  }
+}
+
+}  // namespace audio
+}  // namespace esphome
+
+#endif
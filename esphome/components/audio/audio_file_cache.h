@@ -0,0 +1,188 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "audio.h"
+
+#include "esphome/core/defines.h"
+#include "esphome/core/helpers.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace audio {
+
+#ifndef AUDIO_FILE_CACHE_MAX_BYTES
+#define AUDIO_FILE_CACHE_MAX_BYTES 0
+#endif
+
+#ifndef AUDIO_FILE_STORE_MAX_BYTES
+#define AUDIO_FILE_STORE_MAX_BYTES 0
+#endif
+
+class AudioCacheEntry {
+  /*
+   * @brief A downloaded audio file held in the cache. Owns the file data and frees it when the last user releases the
+   * entry, so an entry evicted while it is playing stays valid until the reader finishes.
+   */
+ public:
+  AudioCacheEntry(const std::string &url, const std::string &etag, AudioFileType file_type, uint8_t *data,
+                  size_t length);
+  ~AudioCacheEntry();
+
+  AudioCacheEntry(const AudioCacheEntry &) = delete;
+  AudioCacheEntry &operator=(const AudioCacheEntry &) = delete;
+
+  /// @brief Tests if the entry was downloaded from the url or another url that served the same ETag
+  bool matches_url(const std::string &url) const;
+
+  /// @brief The file in a form that AudioReader can read like a file embedded in flash
+  AudioFile *get_audio_file() { return &this->file_; }
+
+ protected:
+  friend class AudioFileCache;
+
+  AudioFile file_;
+  std::vector<std::string> urls_;
+  std::string etag_;
+  uint32_t last_used_{0};
+};
+
+class AudioFileStore {
+  /*
+   * @brief Persists cached files in a directory so they survive a reboot. Works on any filesystem mounted in the VFS
+   * (e.g., LittleFS or an SD card) and on the host.
+   *   - Each file is stored in its own file named after a hash of its url. A header holds the url, ETag, file type,
+   *     length, and a checksum of the data; files that are truncated or fail the checksum are deleted when loaded.
+   *   - Files are written under a temporary name and renamed once complete, so an interrupted write never appears as
+   *     a valid file. Leftover temporary files are deleted when the directory is first scanned.
+   *   - The total size of stored files is capped; the least recently used files are deleted first.
+   * Not thread safe; AudioFileCache serializes access.
+   */
+ public:
+  /// @brief Constructs a store. The directory is scanned on first use, so its filesystem can be mounted later.
+  /// @param directory Existing directory to store the files in, without a trailing slash
+  /// @param max_bytes Largest total size of the stored files, including their headers
+  AudioFileStore(std::string directory, size_t max_bytes) : directory_(std::move(directory)), max_bytes_(max_bytes) {}
+
+  /// @brief Writes a file, replacing any stored copy of the url and deleting least recently used files to fit.
+  /// @return True if the file was stored
+  bool save(const std::string &url, const std::string &etag, AudioFileType file_type, const uint8_t *data,
+            size_t length);
+
+  /// @brief Reads a stored file into a newly allocated buffer. Deletes the file if it is truncated or corrupt.
+  /// @param url Url the file was downloaded from
+  /// @param max_length Largest file to load; larger files are left in the store
+  /// @param etag Set to the file's ETag
+  /// @param file_type Set to the file's type
+  /// @param length Set to the file's size in bytes
+  /// @return Buffer holding the file, allocated like AudioFileCache::allocate(), or nullptr if it isn't stored or is
+  ///         invalid
+  uint8_t *load(const std::string &url, size_t max_length, std::string &etag, AudioFileType &file_type,
+                size_t &length);
+
+  size_t get_stored_bytes() const { return this->stored_bytes_; }
+
+ protected:
+  struct StoredFile {
+    std::string path;
+    size_t size;
+    uint32_t last_used;
+  };
+
+  /// @brief Indexes the files already in the directory and deletes leftover temporary files. Runs once.
+  void scan_();
+
+  std::string path_for_(const std::string &url) const;
+
+  /// @brief Deletes a stored file and drops it from the index
+  void remove_(const std::string &path);
+
+  std::string directory_;
+  size_t max_bytes_;
+
+  std::vector<StoredFile> files_;
+  size_t stored_bytes_{0};
+  uint32_t use_counter_{0};
+  bool scanned_{false};
+};
+
+class AudioFileCache {
+  /*
+   * @brief Process-wide LRU cache of downloaded audio files, for short sounds that play repeatedly such as TTS phrases,
+   * timer alarms, and notification sounds.
+   *   - Entries are keyed by url. Files served with the same ETag are stored once and shared by every url.
+   *   - File data is stored in external memory if available, falling back to internal memory.
+   *   - The total size of cached files is capped; the least recently used files are evicted first.
+   *   - With an AudioFileStore, files are also written to a filesystem and loaded from it after a reboot or eviction.
+   *   - Thread safe; pipelines run in separate FreeRTOS tasks.
+   */
+ public:
+  /// @brief Returns the shared cache instance
+  static AudioFileCache &get();
+
+  /// @brief Finds a cached file and marks it as the most recently used. Falls back to loading it from the store.
+  /// @param url Url the file was downloaded from
+  /// @return shared_ptr to the entry, or nullptr on a cache miss
+  std::shared_ptr<AudioCacheEntry> lookup(const std::string &url);
+
+  /// @brief Tests if a file of the given size fits in the cache budget
+  bool can_cache(size_t length) const { return (length > 0) && (length <= this->max_bytes_); }
+
+  /// @brief Allocates a buffer to download a file into before inserting it
+  /// @param length File size in bytes
+  /// @return Pointer to the buffer, or nullptr if the file can't be cached
+  uint8_t *allocate(size_t length);
+
+  /// @brief Frees a buffer from allocate() that won't be inserted, e.g., because the download failed
+  void deallocate(uint8_t *data, size_t length);
+
+  /// @brief Adds a downloaded file, evicting least recently used files to fit, and saves it to the store. Takes
+  /// ownership of the data.
+  /// @param url Url the file was downloaded from
+  /// @param etag ETag header the server sent with the file; may be empty
+  /// @param file_type Type of the audio file
+  /// @param data Buffer from allocate() holding the file
+  /// @param length File size in bytes
+  void insert(const std::string &url, const std::string &etag, AudioFileType file_type, uint8_t *data, size_t length);
+
+  /// @brief Evicts every cached file
+  void clear();
+
+  /// @brief Sets the largest total size of cached files. Evicts files if necessary.
+  void set_max_bytes(size_t max_bytes);
+
+  size_t get_cached_bytes();
+
+  /// @brief Sets the store that files are persisted to and loaded from
+  void set_store(std::unique_ptr<AudioFileStore> store);
+
+ protected:
+  /// @brief Adds a file to memory only. The lock must be held.
+  /// @return The entry now holding the file, or nullptr if it doesn't fit
+  std::shared_ptr<AudioCacheEntry> insert_(const std::string &url, const std::string &etag, AudioFileType file_type,
+                                           uint8_t *data, size_t length);
+
+  /// @brief Evicts least recently used entries until the cached files fit the budget. The lock must be held.
+  void evict_to_(size_t max_bytes);
+
+  Mutex lock_;
+
+  std::vector<std::shared_ptr<AudioCacheEntry>> entries_;
+  std::unique_ptr<AudioFileStore> store_;
+
+  size_t cached_bytes_{0};
+  size_t max_bytes_{AUDIO_FILE_CACHE_MAX_BYTES};
+
+  // Incremented on every access to order entries by recency
+  uint32_t use_counter_{0};
+};
+
+}  // namespace audio
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace audio {
+namespace filter_design {
+
+// Constant-expression math used to design FIR filters at compile time. These are only accurate enough for filter
+// design and are not meant to be called at run time.
+
+static constexpr double PI = 3.14159265358979323846;
+
+constexpr double sin(double x) {
+  while (x > PI) {
+    x -= 2.0 * PI;
+  }
+  while (x < -PI) {
+    x += 2.0 * PI;
+  }
+  double term = x;
+  double sum = x;
+  for (int n = 1; n < 14; ++n) {
+    term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double sqrt(double x) {
+  if (x <= 0.0) {
+    return 0.0;
+  }
+  double guess = x > 1.0 ? x : 1.0;
+  for (int i = 0; i < 40; ++i) {
+    guess = 0.5 * (guess + x / guess);
+  }
+  return guess;
+}
+
+// Zeroth order modified Bessel function of the first kind
+constexpr double bessel_i0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 32; ++k) {
+    const double factor = x / (2.0 * k);
+    term *= factor * factor;
+    sum += term;
+  }
+  return sum;
+}
+
+/// @brief Kaiser windowed-sinc lowpass impulse response evaluated at an arbitrary (fractional) time.
+/// @param t Time in samples relative to the filter's center
+/// @param cutoff Cutoff frequency in cycles per sample
+/// @param half_length Half of the window's length in samples; the response is 0 outside [-half_length, half_length]
+/// @param beta Kaiser window beta
+constexpr double kaiser_sinc(double t, double cutoff, double half_length, double beta) {
+  if ((t < -half_length) || (t > half_length)) {
+    return 0.0;
+  }
+  const double sinc = (t == 0.0) ? 2.0 * cutoff : sin(2.0 * PI * cutoff * t) / (PI * t);
+  const double ratio = t / half_length;
+  return sinc * bessel_i0(beta * sqrt(1.0 - ratio * ratio)) / bessel_i0(beta);
+}
+
+constexpr int16_t to_q15(double value) {
+  const double scaled = value * 32768.0;
+  const double rounded = scaled >= 0.0 ? scaled + 0.5 : scaled - 0.5;
+  return static_cast<int16_t>(rounded > 32767.0 ? 32767.0 : (rounded < -32768.0 ? -32768.0 : rounded));
+}
+
+}  // namespace filter_design
+}  // namespace audio
+}  // namespace esphome
@@ -0,0 +1,271 @@
+#include "audio_gain.h"
+
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace esphome {
+namespace audio {
+
+// An exponential ramp covers this many time constants over the configured ramp duration (~99.3% of the change)
+static const float EXPONENTIAL_RAMP_TIME_CONSTANTS = 5.0f;
+// An exponential ramp snaps to the target once the remaining difference is this small (about -54 dBFS)
+static const int32_t EXPONENTIAL_RAMP_SNAP_THRESHOLD = 64;
+
+// Fractional bits used for the per-frame gain increment in ramps
+static const uint8_t RAMP_FRACTIONAL_BITS = 8;
+
+static inline int16_t saturate_s16(int32_t value) {
+  return static_cast<int16_t>(clamp<int32_t>(value, INT16_MIN, INT16_MAX));
+}
+
+static inline int32_t saturate_s32(int64_t value) {
+  return static_cast<int32_t>(clamp<int64_t>(value, INT32_MIN, INT32_MAX));
+}
+
+// Scales one packed sample in place. Only used for 24 and 32 bits per sample, where a 64 bit product is required.
+static inline void scale_packed_sample(uint8_t *data, size_t bytes_per_sample, int32_t q15_gain) {
+  const int32_t sample = unpack_audio_sample_to_q31(data, bytes_per_sample);
+  pack_q31_as_audio_sample(saturate_s32((static_cast<int64_t>(sample) * q15_gain) >> 15), data, bytes_per_sample);
+}
+
+void apply_q15_gain_s16(const int16_t *input, int16_t *output, size_t samples, int32_t q15_gain) {
+  // Note the assembly dsps_mulc function has audio glitches if the input and output buffers are the same, so a
+  // portable kernel is used instead. Gains are limited to Q15_MAX_GAIN, so the products always fit in 32 bits.
+  size_t i = 0;
+
+  // Unrolled by four so the multiplies can be pipelined; the gain stays in a register for the whole block
+  for (; i + 4 <= samples; i += 4) {
+    const int32_t s0 = (input[i] * q15_gain) >> 15;
+    const int32_t s1 = (input[i + 1] * q15_gain) >> 15;
+    const int32_t s2 = (input[i + 2] * q15_gain) >> 15;
+    const int32_t s3 = (input[i + 3] * q15_gain) >> 15;
+    output[i] = saturate_s16(s0);
+    output[i + 1] = saturate_s16(s1);
+    output[i + 2] = saturate_s16(s2);
+    output[i + 3] = saturate_s16(s3);
+  }
+
+  for (; i < samples; ++i) {
+    output[i] = saturate_s16((input[i] * q15_gain) >> 15);
+  }
+}
+
+void apply_q15_gain(uint8_t *data, size_t samples, size_t bytes_per_sample, int32_t q15_gain) {
+  q15_gain = clamp<int32_t>(q15_gain, 0, Q15_MAX_GAIN);
+
+  if (bytes_per_sample == 2) {
+    int16_t *samples_s16 = reinterpret_cast<int16_t *>(data);
+    apply_q15_gain_s16(samples_s16, samples_s16, samples, q15_gain);
+  } else if (bytes_per_sample == 4) {
+    int32_t *samples_s32 = reinterpret_cast<int32_t *>(data);
+    for (size_t i = 0; i < samples; ++i) {
+      samples_s32[i] = saturate_s32((static_cast<int64_t>(samples_s32[i]) * q15_gain) >> 15);
+    }
+  } else if (bytes_per_sample == 3) {
+    for (size_t i = 0; i < samples; ++i) {
+      scale_packed_sample(data + i * bytes_per_sample, bytes_per_sample, q15_gain);
+    }
+  }
+}
+
+void apply_q15_gain_ramp(uint8_t *data, uint32_t frames, uint8_t channels, size_t bytes_per_sample,
+                         int32_t start_gain, int32_t end_gain) {
+  if (frames == 0) {
+    return;
+  }
+
+  start_gain = clamp<int32_t>(start_gain, 0, Q15_MAX_GAIN);
+  end_gain = clamp<int32_t>(end_gain, 0, Q15_MAX_GAIN);
+
+  // The gain is tracked with extra fractional bits so short blocks with small gain changes still move smoothly
+  int32_t gain_accumulator = start_gain << RAMP_FRACTIONAL_BITS;
+  const int32_t gain_step = ((end_gain - start_gain) * (1 << RAMP_FRACTIONAL_BITS)) / static_cast<int32_t>(frames);
+
+  if (bytes_per_sample == 2) {
+    int16_t *samples_s16 = reinterpret_cast<int16_t *>(data);
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      const int32_t gain = gain_accumulator >> RAMP_FRACTIONAL_BITS;
+      for (uint8_t channel = 0; channel < channels; ++channel) {
+        *samples_s16 = saturate_s16((*samples_s16 * gain) >> 15);
+        ++samples_s16;
+      }
+      gain_accumulator += gain_step;
+    }
+  } else if (bytes_per_sample == 4) {
+    int32_t *samples_s32 = reinterpret_cast<int32_t *>(data);
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      const int32_t gain = gain_accumulator >> RAMP_FRACTIONAL_BITS;
+      for (uint8_t channel = 0; channel < channels; ++channel) {
+        *samples_s32 = saturate_s32((static_cast<int64_t>(*samples_s32) * gain) >> 15);
+        ++samples_s32;
+      }
+      gain_accumulator += gain_step;
+    }
+  } else if (bytes_per_sample == 3) {
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      const int32_t gain = gain_accumulator >> RAMP_FRACTIONAL_BITS;
+      for (uint8_t channel = 0; channel < channels; ++channel) {
+        scale_packed_sample(data, bytes_per_sample, gain);
+        data += bytes_per_sample;
+      }
+      gain_accumulator += gain_step;
+    }
+  }
+}
+
+void apply_q15_gain_widen_s16_to_s32(const int16_t *input, int32_t *output, size_t samples, int32_t q15_gain) {
+  // The product of a sample and a gain below 2^16 fits in 32 bits. Clamping it to half the int32 range before the
+  // shift into the upper bits saturates instead of wrapping for gains above unity.
+  static const int32_t PRODUCT_MAX = INT32_MAX >> 1;
+  static const int32_t PRODUCT_MIN = INT32_MIN >> 1;
+
+  size_t i = 0;
+
+  // Unrolled by four like the other gain kernels
+  for (; i + 4 <= samples; i += 4) {
+    const int32_t s0 = input[i] * q15_gain;
+    const int32_t s1 = input[i + 1] * q15_gain;
+    const int32_t s2 = input[i + 2] * q15_gain;
+    const int32_t s3 = input[i + 3] * q15_gain;
+    output[i] = clamp<int32_t>(s0, PRODUCT_MIN, PRODUCT_MAX) * 2;
+    output[i + 1] = clamp<int32_t>(s1, PRODUCT_MIN, PRODUCT_MAX) * 2;
+    output[i + 2] = clamp<int32_t>(s2, PRODUCT_MIN, PRODUCT_MAX) * 2;
+    output[i + 3] = clamp<int32_t>(s3, PRODUCT_MIN, PRODUCT_MAX) * 2;
+  }
+
+  for (; i < samples; ++i) {
+    output[i] = clamp<int32_t>(input[i] * q15_gain, PRODUCT_MIN, PRODUCT_MAX) * 2;
+  }
+}
+
+void widen_audio_samples(const uint8_t *input, size_t input_bytes_per_sample, uint8_t *output,
+                         size_t output_bytes_per_sample, size_t samples, int32_t q15_gain) {
+  q15_gain = clamp<int32_t>(q15_gain, 0, Q15_MAX_GAIN);
+
+  if ((input_bytes_per_sample == 2) && (output_bytes_per_sample == 4)) {
+    apply_q15_gain_widen_s16_to_s32(reinterpret_cast<const int16_t *>(input), reinterpret_cast<int32_t *>(output),
+                                    samples, q15_gain);
+    return;
+  }
+
+  for (size_t i = 0; i < samples; ++i) {
+    int32_t sample = unpack_audio_sample_to_q31(input, input_bytes_per_sample);
+    if (q15_gain != Q15_UNITY_GAIN) {
+      sample = saturate_s32((static_cast<int64_t>(sample) * q15_gain) >> 15);
+    }
+    pack_q31_as_audio_sample(sample, output, output_bytes_per_sample);
+    input += input_bytes_per_sample;
+    output += output_bytes_per_sample;
+  }
+}
+
+void mix_audio_s16(const int16_t *input, uint8_t input_channels, int16_t *output, uint8_t output_channels,
+                   uint32_t frames) {
+  if (input_channels == output_channels) {
+    const size_t samples = static_cast<size_t>(frames) * output_channels;
+    size_t i = 0;
+
+    // Unrolled by four like the gain kernel; the sums are formed in 32 bits and saturated once
+    for (; i + 4 <= samples; i += 4) {
+      const int32_t s0 = output[i] + input[i];
+      const int32_t s1 = output[i + 1] + input[i + 1];
+      const int32_t s2 = output[i + 2] + input[i + 2];
+      const int32_t s3 = output[i + 3] + input[i + 3];
+      output[i] = saturate_s16(s0);
+      output[i + 1] = saturate_s16(s1);
+      output[i + 2] = saturate_s16(s2);
+      output[i + 3] = saturate_s16(s3);
+    }
+
+    for (; i < samples; ++i) {
+      output[i] = saturate_s16(output[i] + input[i]);
+    }
+  } else if (input_channels == 1) {
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      const int32_t sample = input[frame];
+      for (uint8_t channel = 0; channel < output_channels; ++channel) {
+        *output = saturate_s16(*output + sample);
+        ++output;
+      }
+    }
+  } else if (output_channels == 1) {
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      int32_t sum = 0;
+      for (uint8_t channel = 0; channel < input_channels; ++channel) {
+        sum += *input;
+        ++input;
+      }
+      output[frame] = saturate_s16(output[frame] + sum / input_channels);
+    }
+  }
+}
+
+int32_t decibels_to_q15_gain(float decibels) {
+  const float gain = powf(10.0f, decibels / 20.0f) * static_cast<float>(Q15_UNITY_GAIN);
+  return clamp<int32_t>(static_cast<int32_t>(gain + 0.5f), 0, Q15_MAX_GAIN);
+}
+
+void GainRamp::set_target(int32_t q15_gain) {
+  this->target_gain_.store(clamp<int32_t>(q15_gain, 0, Q15_MAX_GAIN), std::memory_order_relaxed);
+}
+
+void GainRamp::set_current(int32_t q15_gain) { this->current_gain_ = clamp<int32_t>(q15_gain, 0, Q15_MAX_GAIN); }
+
+void GainRamp::apply(uint8_t *data, size_t length, const AudioStreamInfo &stream_info) {
+  const size_t bytes_per_sample = stream_info.samples_to_bytes(1);
+  if ((bytes_per_sample < 2) || (bytes_per_sample > 4)) {
+    // 8 bit audio isn't supported
+    return;
+  }
+
+  const int32_t target = this->get_target();
+
+  if (this->current_gain_ == target) {
+    if (target == Q15_UNITY_GAIN) {
+      return;
+    }
+    apply_q15_gain(data, stream_info.bytes_to_samples(length), bytes_per_sample, target);
+    return;
+  }
+
+  const uint32_t frames = stream_info.bytes_to_frames(length);
+  if (frames == 0) {
+    return;
+  }
+
+  const int32_t end_gain = this->compute_block_end_gain_(frames, stream_info.get_sample_rate(), target);
+  apply_q15_gain_ramp(data, frames, stream_info.get_channels(), bytes_per_sample, this->current_gain_, end_gain);
+  this->current_gain_ = end_gain;
+}
+
+int32_t GainRamp::compute_block_end_gain_(uint32_t frames, uint32_t sample_rate, int32_t target) const {
+  const uint32_t ramp_frames = this->ramp_duration_ms_ * sample_rate / 1000;
+  if (ramp_frames == 0) {
+    return target;
+  }
+
+  const int32_t current = this->current_gain_;
+
+  if (this->ramp_type_ == GainRampType::EXPONENTIAL) {
+    const float remaining = expf(-EXPONENTIAL_RAMP_TIME_CONSTANTS * static_cast<float>(frames) / ramp_frames);
+    const int32_t end_gain = target + static_cast<int32_t>(static_cast<float>(current - target) * remaining);
+    if (std::abs(end_gain - target) <= EXPONENTIAL_RAMP_SNAP_THRESHOLD) {
+      return target;
+    }
+    return end_gain;
+  }
+
+  // Linear ramp; a full scale change takes the entire ramp duration
+  const int32_t max_step =
+      std::max<int32_t>(1, static_cast<int32_t>((static_cast<uint64_t>(Q15_UNITY_GAIN) * frames) / ramp_frames));
+  if (target > current) {
+    return std::min(target, current + max_step);
+  }
+  return std::max(target, current - max_step);
+}
+
+}  // namespace audio
+}  // namespace esphome
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "audio.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace audio {
+
+// Q15 fixed-point gain that represents 0 dB
+static const int32_t Q15_UNITY_GAIN = 1 << 15;
+// Largest supported Q15 gain (just under +6 dB). Keeps 16 bit products within 32 bits.
+static const int32_t Q15_MAX_GAIN = (1 << 16) - 1;
+
+enum class GainRampType : uint8_t {
+  LINEAR = 0,   // Gain changes by a constant amount per frame; reaches the target after the ramp duration
+  EXPONENTIAL,  // Gain approaches the target with a one-pole smoothing curve; settles within the ramp duration
+};
+
+/// @brief Scales int16 samples by a Q15 gain with saturation. Scales in place if input == output.
+/// @param input PCM int16 audio samples
+/// @param output Buffer to store the scaled samples
+/// @param samples Number of samples to scale
+/// @param q15_gain Q15 fixed-point gain in [0, Q15_MAX_GAIN]
+void apply_q15_gain_s16(const int16_t *input, int16_t *output, size_t samples, int32_t q15_gain);
+
+/// @brief Scales packed little-endian samples in place by a Q15 gain with saturation.
+/// @param data Pointer to the audio samples
+/// @param samples Number of samples to scale
+/// @param bytes_per_sample 2, 3, or 4 bytes per sample
+/// @param q15_gain Q15 fixed-point gain in [0, Q15_MAX_GAIN]
+void apply_q15_gain(uint8_t *data, size_t samples, size_t bytes_per_sample, int32_t q15_gain);
+
+/// @brief Scales packed little-endian frames in place by a gain that linearly moves from start_gain to end_gain over
+/// the block. Every sample in a frame is scaled by the same gain.
+/// @param data Pointer to the audio frames
+/// @param frames Number of frames to scale
+/// @param channels Number of samples per frame
+/// @param bytes_per_sample 2, 3, or 4 bytes per sample
+/// @param start_gain Q15 fixed-point gain applied to the first frame
+/// @param end_gain Q15 fixed-point gain reached after the last frame
+void apply_q15_gain_ramp(uint8_t *data, uint32_t frames, uint8_t channels, size_t bytes_per_sample,
+                         int32_t start_gain, int32_t end_gain);
+
+/// @brief Widens int16 samples to int32 while scaling them by a Q15 gain with saturation, e.g., to write 16 bit audio
+/// to a 32 bit I2S bus without a separate volume pass.
+/// @param input PCM int16 audio samples
+/// @param output Buffer to store the widened samples. Must not overlap the input.
+/// @param samples Number of samples to convert
+/// @param q15_gain Q15 fixed-point gain in [0, Q15_MAX_GAIN]
+void apply_q15_gain_widen_s16_to_s32(const int16_t *input, int32_t *output, size_t samples, int32_t q15_gain);
+
+/// @brief Converts packed little-endian samples to a wider sample size while scaling them by a Q15 gain. The samples
+/// keep their full scale range, and the new low bytes are zero at unity gain.
+/// @param input Pointer to the input samples
+/// @param input_bytes_per_sample 2, 3, or 4 bytes per sample
+/// @param output Buffer to store the converted samples. Must not overlap the input.
+/// @param output_bytes_per_sample 2, 3, or 4 bytes per sample; at least input_bytes_per_sample
+/// @param samples Number of samples to convert
+/// @param q15_gain Q15 fixed-point gain in [0, Q15_MAX_GAIN]
+void widen_audio_samples(const uint8_t *input, size_t input_bytes_per_sample, uint8_t *output,
+                         size_t output_bytes_per_sample, size_t samples, int32_t q15_gain);
+
+/// @brief Adds int16 frames to the frames in the output buffer with saturation, e.g., to mix several streams into one.
+/// Mono input is added to every output channel, and stereo input is averaged for mono output.
+/// @param input PCM int16 audio frames to add
+/// @param input_channels Number of channels in the input frames
+/// @param output PCM int16 audio frames to add to
+/// @param output_channels Number of channels in the output frames. Must equal input_channels unless either is mono.
+/// @param frames Number of frames to mix
+void mix_audio_s16(const int16_t *input, uint8_t input_channels, int16_t *output, uint8_t output_channels,
+                   uint32_t frames);
+
+/// @brief Converts a gain in decibels to a Q15 fixed-point gain
+/// @param decibels Gain in dB; negative values attenuate
+/// @return Q15 fixed-point gain clamped to [0, Q15_MAX_GAIN]
+int32_t decibels_to_q15_gain(float decibels);
+
+class GainRamp {
+  /*
+   * @brief Class that applies a software gain that ramps toward a target gain one audio block at a time.
+   * Avoids zipper noise and clicks when the volume jumps between steps. The target may be set from a different task
+   * than the one processing audio.
+   */
+ public:
+  /// @brief Sets the shape and duration of the ramp used when the target changes.
+  /// @param ramp_type GainRampType::LINEAR or GainRampType::EXPONENTIAL
+  /// @param duration_ms Time to reach a new target from silence or full scale. 0 changes the gain instantly.
+  void set_ramp(GainRampType ramp_type, uint32_t duration_ms) {
+    this->ramp_type_ = ramp_type;
+    this->ramp_duration_ms_ = duration_ms;
+  }
+
+  /// @brief Sets the gain to ramp toward. Thread safe.
+  /// @param q15_gain Q15 fixed-point gain. Clamped to [0, Q15_MAX_GAIN]
+  void set_target(int32_t q15_gain);
+  int32_t get_target() const { return this->target_gain_.load(std::memory_order_relaxed); }
+
+  /// @brief Returns the gain applied to the last processed frame
+  int32_t get_current() const { return this->current_gain_; }
+
+  /// @brief Immediately sets the current gain to the target, e.g., when starting a new stream.
+  void jump_to_target() { this->current_gain_ = this->get_target(); }
+
+  /// @brief Immediately sets the current gain, leaving the target untouched. Used to start a fade from a given gain.
+  void set_current(int32_t q15_gain);
+
+  bool is_ramping() const { return this->current_gain_ != this->get_target(); }
+
+  /// @brief Returns the gain apply() scales by while the gain isn't ramping
+  int32_t get_steady_gain() const { return this->current_gain_; }
+
+  /// @brief Scales a block of audio in place, moving the gain toward the target. Does nothing at unity gain.
+  /// @param data Pointer to the audio data
+  /// @param length Length of the audio data in bytes
+  /// @param stream_info Stream info describing the audio data. Supports 16, 24, and 32 bits per sample.
+  void apply(uint8_t *data, size_t length, const AudioStreamInfo &stream_info);
+
+ protected:
+  /// @brief Computes the gain at the end of a block with the given number of frames
+  int32_t compute_block_end_gain_(uint32_t frames, uint32_t sample_rate, int32_t target) const;
+
+  std::atomic<int32_t> target_gain_{Q15_UNITY_GAIN};
+  int32_t current_gain_{Q15_UNITY_GAIN};
+
+  uint32_t ramp_duration_ms_{0};
+  GainRampType ramp_type_{GainRampType::LINEAR};
+};
+
+}  // namespace audio
+}  // namespace esphome
@@ -0,0 +1,157 @@
+#include "audio_hls_playlist.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace esphome {
+namespace audio {
+
+static const char *const HLS_HEADER_TAG = "#EXTM3U";
+static const char *const HLS_SEGMENT_TAG = "#EXTINF:";
+static const char *const HLS_VARIANT_TAG = "#EXT-X-STREAM-INF:";
+static const char *const HLS_TARGET_DURATION_TAG = "#EXT-X-TARGETDURATION:";
+static const char *const HLS_MEDIA_SEQUENCE_TAG = "#EXT-X-MEDIA-SEQUENCE:";
+static const char *const HLS_KEY_TAG = "#EXT-X-KEY:";
+static const char *const HLS_END_LIST_TAG = "#EXT-X-ENDLIST";
+
+static bool starts_with(const std::string &line, const char *prefix) {
+  return line.compare(0, strlen(prefix), prefix) == 0;
+}
+
+/// @brief Returns the value of an attribute in a tag's attribute list, e.g., BANDWIDTH in
+/// "#EXT-X-STREAM-INF:BANDWIDTH=64000,CODECS="mp4a.40.2"", or an empty string if it isn't present
+static std::string get_attribute(const std::string &line, const char *name) {
+  const size_t name_length = strlen(name);
+  size_t position = line.find(':');
+  while (position != std::string::npos) {
+    ++position;
+    if ((line.compare(position, name_length, name) == 0) && (line[position + name_length] == '=')) {
+      const size_t value_start = position + name_length + 1;
+      if (line[value_start] == '"') {
+        return line.substr(value_start + 1, line.find('"', value_start + 1) - value_start - 1);
+      }
+      return line.substr(value_start, line.find(',', value_start) - value_start);
+    }
+
+    // Skip to the next attribute, ignoring commas in quoted strings
+    bool quoted = false;
+    while ((position < line.size()) && (quoted || (line[position] != ','))) {
+      quoted ^= (line[position] == '"');
+      ++position;
+    }
+    if (position >= line.size()) {
+      break;
+    }
+  }
+  return std::string();
+}
+
+bool HlsPlaylist::parse(const std::string &text, const std::string &playlist_url) {
+  this->variant_url_.clear();
+  this->segments_.clear();
+  this->target_duration_ms_ = 0;
+  this->ended_ = false;
+
+  uint64_t sequence = 0;
+  uint32_t segment_duration_ms = 0;
+  uint32_t lowest_bandwidth = UINT32_MAX;
+  bool next_is_variant = false;
+  uint32_t variant_bandwidth = 0;
+  bool header_found = false;
+
+  size_t line_start = 0;
+  while (line_start < text.size()) {
+    size_t line_end = text.find('\n', line_start);
+    if (line_end == std::string::npos) {
+      line_end = text.size();
+    }
+
+    // Trim whitespace, including the carriage return of CRLF line endings
+    size_t first = line_start;
+    size_t last = line_end;
+    while ((first < last) && isspace(static_cast<unsigned char>(text[first]))) {
+      ++first;
+    }
+    while ((last > first) && isspace(static_cast<unsigned char>(text[last - 1]))) {
+      --last;
+    }
+    const std::string line = text.substr(first, last - first);
+    line_start = line_end + 1;
+
+    if (line.empty()) {
+      continue;
+    }
+
+    if (!header_found) {
+      if (!starts_with(line, HLS_HEADER_TAG)) {
+        return false;
+      }
+      header_found = true;
+    } else if (starts_with(line, HLS_SEGMENT_TAG)) {
+      segment_duration_ms = static_cast<uint32_t>(strtof(line.c_str() + strlen(HLS_SEGMENT_TAG), nullptr) * 1000.0f);
+    } else if (starts_with(line, HLS_VARIANT_TAG)) {
+      next_is_variant = true;
+      variant_bandwidth = strtoul(get_attribute(line, "BANDWIDTH").c_str(), nullptr, 10);
+    } else if (starts_with(line, HLS_TARGET_DURATION_TAG)) {
+      this->target_duration_ms_ = strtoul(line.c_str() + strlen(HLS_TARGET_DURATION_TAG), nullptr, 10) * 1000;
+    } else if (starts_with(line, HLS_MEDIA_SEQUENCE_TAG)) {
+      sequence = strtoull(line.c_str() + strlen(HLS_MEDIA_SEQUENCE_TAG), nullptr, 10);
+    } else if (starts_with(line, HLS_KEY_TAG)) {
+      if (get_attribute(line, "METHOD") != "NONE") {
+        // Encrypted segments can't be decoded
+        return false;
+      }
+    } else if (starts_with(line, HLS_END_LIST_TAG)) {
+      this->ended_ = true;
+    } else if (line[0] != '#') {
+      // A url line belongs to the preceding #EXT-X-STREAM-INF or #EXTINF tag
+      if (next_is_variant) {
+        if (variant_bandwidth < lowest_bandwidth) {
+          lowest_bandwidth = variant_bandwidth;
+          this->variant_url_ = resolve_url(playlist_url, line);
+        }
+        next_is_variant = false;
+      } else {
+        this->segments_.push_back({resolve_url(playlist_url, line), sequence++, segment_duration_ms});
+        segment_duration_ms = 0;
+      }
+    }
+  }
+
+  return header_found && (this->is_master() || !this->segments_.empty() || !this->ended_);
+}
+
+std::string HlsPlaylist::resolve_url(const std::string &base_url, const std::string &reference) {
+  if (reference.find("://") != std::string::npos) {
+    return reference;
+  }
+
+  const size_t scheme_end = base_url.find("://");
+  if (scheme_end == std::string::npos) {
+    return reference;
+  }
+
+  if (reference.compare(0, 2, "//") == 0) {
+    // Network-path reference, keep the scheme
+    return base_url.substr(0, scheme_end + 1) + reference;
+  }
+
+  if (reference[0] == '/') {
+    // Absolute path, keep the scheme and host
+    const size_t host_end = base_url.find('/', scheme_end + 3);
+    return base_url.substr(0, host_end) + reference;
+  }
+
+  // Relative path, replace the last path segment. Ignore any query when looking for it.
+  const size_t path_end = base_url.find_first_of("?#", scheme_end + 3);
+  const size_t directory_end = base_url.rfind('/', path_end);
+  if ((directory_end == std::string::npos) || (directory_end < scheme_end + 3)) {
+    // The base has no path
+    return base_url.substr(0, path_end) + "/" + reference;
+  }
+  return base_url.substr(0, directory_end + 1) + reference;
+}
+
+}  // namespace audio
+}  // namespace esphome
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace audio {
+
+struct HlsSegment {
+  std::string url;       // Absolute url of the segment
+  uint64_t sequence;     // Media sequence number
+  uint32_t duration_ms;  // Duration from the #EXTINF tag
+};
+
+class HlsPlaylist {
+  /*
+   * @brief Parser for HLS (RFC 8216) m3u8 playlists.
+   * Handles both master playlists, which list variant streams, and media playlists, which list the segments of one
+   * stream. Only the tags needed to play audio segments back to back are interpreted; others are ignored.
+   *   - Segment and variant urls are resolved against the playlist's url.
+   *   - Encrypted playlists (#EXT-X-KEY with a method other than NONE) are rejected.
+   */
+ public:
+  /// @brief Parses a playlist, replacing the result of any previous parse
+  /// @param text Playlist contents
+  /// @param playlist_url Url the playlist was fetched from, after redirects
+  /// @return True if the text is a playlist that can be played, false otherwise
+  bool parse(const std::string &text, const std::string &playlist_url);
+
+  /// @brief Returns true if the playlist lists variant streams instead of segments
+  bool is_master() const { return !this->variant_url_.empty(); }
+
+  /// @brief Url of the variant stream with the lowest bandwidth. Only valid for a master playlist.
+  const std::string &get_variant_url() const { return this->variant_url_; }
+
+  /// @brief Segments of a media playlist in playback order
+  const std::vector<HlsSegment> &get_segments() const { return this->segments_; }
+
+  /// @brief Maximum segment duration from #EXT-X-TARGETDURATION, which sets how often a live playlist is reloaded
+  uint32_t get_target_duration_ms() const { return this->target_duration_ms_; }
+
+  /// @brief Returns true if the playlist has #EXT-X-ENDLIST, i.e., no segments will be added to it
+  bool is_ended() const { return this->ended_; }
+
+  /// @brief Resolves a possibly relative url against a base url
+  /// @param base_url Absolute url of the referencing document
+  /// @param reference Absolute url, network-path ("//host/path"), absolute path, or relative path
+  /// @return Absolute url
+  static std::string resolve_url(const std::string &base_url, const std::string &reference);
+
+ protected:
+  std::string variant_url_;
+  std::vector<HlsSegment> segments_;
+  uint32_t target_duration_ms_{0};
+  bool ended_{false};
+};
+
+}  // namespace audio
+}  // namespace esphome
@@ -0,0 +1,199 @@
+#include "audio_ogg_demuxer.h"
+
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace audio {
+
+static const size_t OGG_PAGE_HEADER_SIZE = 27;
+static const uint8_t OGG_CAPTURE_PATTERN[4] = {'O', 'g', 'g', 'S'};
+
+enum OggHeaderType : uint8_t {
+  OGG_HEADER_CONTINUED = 0x01,  // The page starts with the continuation of a packet from the previous page
+  OGG_HEADER_BOS = 0x02,        // First page of a logical stream
+  OGG_HEADER_EOS = 0x04,        // Last page of a logical stream
+};
+
+static uint32_t read_le32(const uint8_t *data) {
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+OggDemuxer::OggDemuxer() {
+  RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  this->packet_ = allocator.allocate(OGG_MAX_PACKET_SIZE);
+}
+
+OggDemuxer::~OggDemuxer() {
+  if (this->packet_ != nullptr) {
+    RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+    allocator.deallocate(this->packet_, OGG_MAX_PACKET_SIZE);
+  }
+}
+
+void OggDemuxer::reset() {
+  this->discard_packet_();
+  this->packet_complete_ = false;
+  this->segment_count_ = 0;
+  this->segment_index_ = 0;
+  this->segment_bytes_left_ = 0;
+  this->serial_number_known_ = false;
+  this->skip_page_ = false;
+  this->in_page_body_ = false;
+  this->end_of_stream_page_ = false;
+  this->last_packet_ = false;
+  this->page_granule_position_ = -1;
+  this->granule_position_ = -1;
+}
+
+void OggDemuxer::discard_packet_() {
+  this->packet_length_ = 0;
+  this->packet_overflowed_ = false;
+}
+
+OggDemuxerResult OggDemuxer::demux(const uint8_t *data, size_t length, size_t *bytes_consumed) {
+  *bytes_consumed = 0;
+
+  if (this->packet_complete_) {
+    // The caller is done with the previous packet
+    this->discard_packet_();
+    this->packet_complete_ = false;
+  }
+
+  while (true) {
+    if (!this->in_page_body_) {
+      if (this->end_of_stream_page_) {
+        return OggDemuxerResult::END_OF_STREAM;
+      }
+
+      size_t header_bytes = 0;
+      OggDemuxerResult result;
+      const bool parsed =
+          this->parse_page_header_(data + *bytes_consumed, length - *bytes_consumed, &header_bytes, &result);
+      *bytes_consumed += header_bytes;
+      if (!parsed) {
+        return result;
+      }
+      continue;
+    }
+
+    if (this->segment_index_ == this->segment_count_) {
+      // Finished the page
+      this->in_page_body_ = false;
+      continue;
+    }
+
+    if (this->segment_bytes_left_ > 0) {
+      const size_t bytes_to_copy = std::min(this->segment_bytes_left_, length - *bytes_consumed);
+      if (bytes_to_copy == 0) {
+        return OggDemuxerResult::NEED_MORE_DATA;
+      }
+
+      if (!this->skip_page_ && !this->packet_overflowed_) {
+        if (this->packet_length_ + bytes_to_copy <= OGG_MAX_PACKET_SIZE) {
+          std::memcpy(this->packet_ + this->packet_length_, data + *bytes_consumed, bytes_to_copy);
+          this->packet_length_ += bytes_to_copy;
+        } else {
+          this->packet_overflowed_ = true;
+        }
+      }
+
+      *bytes_consumed += bytes_to_copy;
+      this->segment_bytes_left_ -= bytes_to_copy;
+      if (this->segment_bytes_left_ > 0) {
+        return OggDemuxerResult::NEED_MORE_DATA;
+      }
+    }
+
+    // The current segment is complete; a lacing value below 255 ends the packet
+    const uint8_t lacing_value = this->lacing_values_[this->segment_index_++];
+    if (this->segment_index_ < this->segment_count_) {
+      this->segment_bytes_left_ = this->lacing_values_[this->segment_index_];
+    }
+
+    if ((lacing_value < 255) && !this->skip_page_) {
+      const bool last_segment = (this->segment_index_ == this->segment_count_);
+      if (last_segment) {
+        this->in_page_body_ = false;
+      }
+
+      if (this->packet_overflowed_) {
+        // Too large to reassemble, or the start of the packet was lost
+        this->discard_packet_();
+        continue;
+      }
+
+      this->granule_position_ = this->page_granule_position_;
+      this->last_packet_ = this->end_of_stream_page_ && last_segment;
+      this->packet_complete_ = true;
+      return OggDemuxerResult::PACKET;
+    }
+  }
+}
+
+bool OggDemuxer::parse_page_header_(const uint8_t *data, size_t length, size_t *bytes_consumed,
+                                    OggDemuxerResult *result) {
+  *bytes_consumed = 0;
+
+  const size_t pattern_bytes = std::min(length, sizeof(OGG_CAPTURE_PATTERN));
+  if ((std::memcmp(data, OGG_CAPTURE_PATTERN, pattern_bytes) != 0) || ((length >= 5) && (data[4] != 0))) {
+    // Not at a page boundary (or an unsupported version); skip to the next capture pattern. Keep a possibly partial
+    // pattern at the end of the input.
+    const uint8_t *search_start = data + 1;
+    const uint8_t *found = std::search(search_start, data + length, OGG_CAPTURE_PATTERN,
+                                       OGG_CAPTURE_PATTERN + sizeof(OGG_CAPTURE_PATTERN));
+    if (found == data + length) {
+      *bytes_consumed = (length > sizeof(OGG_CAPTURE_PATTERN) - 1) ? length - (sizeof(OGG_CAPTURE_PATTERN) - 1) : 1;
+    } else {
+      *bytes_consumed = found - data;
+    }
+    *bytes_consumed = std::min(*bytes_consumed, length);
+    *result = OggDemuxerResult::LOST_SYNC;
+    return false;
+  }
+
+  if ((length < OGG_PAGE_HEADER_SIZE) || (length < OGG_PAGE_HEADER_SIZE + data[26])) {
+    *result = OggDemuxerResult::NEED_MORE_DATA;
+    return false;
+  }
+
+  const uint8_t header_type = data[5];
+  const int64_t granule_position = static_cast<int64_t>(static_cast<uint64_t>(read_le32(data + 6)) |
+                                                        (static_cast<uint64_t>(read_le32(data + 10)) << 32));
+  const uint32_t serial_number = read_le32(data + 14);
+
+  if (!this->serial_number_known_) {
+    // Follow the first logical stream
+    this->serial_number_ = serial_number;
+    this->serial_number_known_ = true;
+  }
+  this->skip_page_ = (serial_number != this->serial_number_);
+
+  if (!this->skip_page_) {
+    const bool packet_in_progress = (this->packet_length_ > 0) || this->packet_overflowed_;
+    if ((header_type & OGG_HEADER_CONTINUED) && !packet_in_progress) {
+      // The start of the continued packet was lost, so drop the rest of it
+      this->packet_overflowed_ = true;
+    } else if (!(header_type & OGG_HEADER_CONTINUED) && packet_in_progress) {
+      // A page was lost mid-packet
+      this->discard_packet_();
+    }
+    this->end_of_stream_page_ = (header_type & OGG_HEADER_EOS);
+    this->page_granule_position_ = granule_position;
+  }
+
+  this->segment_count_ = data[26];
+  std::memcpy(this->lacing_values_, data + OGG_PAGE_HEADER_SIZE, this->segment_count_);
+  this->segment_index_ = 0;
+  this->segment_bytes_left_ = (this->segment_count_ > 0) ? this->lacing_values_[0] : 0;
+  this->in_page_body_ = true;
+
+  *bytes_consumed = OGG_PAGE_HEADER_SIZE + this->segment_count_;
+  return true;
+}
+
+}  // namespace audio
+}  // namespace esphome
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace audio {
+
+// Largest packet the demuxer reassembles. Opus audio packets are at most a few KiB; larger packets, such as comment
+// headers with embedded cover art, are skipped.
+static const size_t OGG_MAX_PACKET_SIZE = 8 * 1024;
+
+enum class OggDemuxerResult : uint8_t {
+  PACKET = 0,      // A complete packet is available
+  NEED_MORE_DATA,  // All input was consumed without completing a packet
+  END_OF_STREAM,   // The last page of the logical stream was processed
+  LOST_SYNC,       // Input wasn't a valid page; skipped ahead to the next capture pattern
+};
+
+class OggDemuxer {
+  /*
+   * @brief Streaming demuxer for Ogg containers (RFC 3533).
+   * Reassembles the packets of the first logical stream from pages that arrive in arbitrary chunks, so it works
+   * directly on a transfer buffer without needing whole pages in memory. Pages of other logical streams are skipped.
+   * Page CRCs aren't verified; corrupt data is detected by the codec.
+   */
+ public:
+  OggDemuxer();
+  ~OggDemuxer();
+
+  OggDemuxer(const OggDemuxer &) = delete;
+  OggDemuxer &operator=(const OggDemuxer &) = delete;
+
+  /// @brief Returns true if the packet buffer was allocated
+  bool is_allocated() const { return this->packet_ != nullptr; }
+
+  /// @brief Resets the demuxer to the start of a new stream
+  void reset();
+
+  /// @brief Consumes input until a packet is complete.
+  /// @param data Pointer to the input data
+  /// @param length Number of input bytes available
+  /// @param bytes_consumed Pointer to store how many input bytes were consumed. The caller discards them from its buffer.
+  /// @return OggDemuxerResult
+  OggDemuxerResult demux(const uint8_t *data, size_t length, size_t *bytes_consumed);
+
+  /// @brief The packet completed by the last demux() call that returned PACKET
+  const uint8_t *get_packet() const { return this->packet_; }
+  size_t get_packet_length() const { return this->packet_length_; }
+
+  /// @brief Returns true if the last packet is the final packet of the stream
+  bool is_last_packet() const { return this->last_packet_; }
+
+  /// @brief Granule position of the page the last packet ended on. For Opus, the number of 48 kHz samples (including
+  /// pre-skip) decoded up to the end of that page.
+  int64_t get_granule_position() const { return this->granule_position_; }
+
+ protected:
+  /// @brief Parses a page header once it is entirely available, resynchronizing on the capture pattern if necessary
+  /// @param data Pointer to the input data
+  /// @param length Number of input bytes available
+  /// @param bytes_consumed Pointer to store how many input bytes were consumed
+  /// @param result Pointer to store why parsing stopped if it returns false
+  /// @return True if a header was parsed, false otherwise
+  bool parse_page_header_(const uint8_t *data, size_t length, size_t *bytes_consumed, OggDemuxerResult *result);
+
+  /// @brief Discards the partially assembled packet
+  void discard_packet_();
+
+  uint8_t *packet_{nullptr};
+  size_t packet_length_{0};
+  bool packet_overflowed_{false};
+  bool packet_complete_{false};
+
+  uint8_t lacing_values_[255];
+  uint8_t segment_count_{0};
+  uint8_t segment_index_{0};
+  size_t segment_bytes_left_{0};
+
+  uint32_t serial_number_{0};
+  bool serial_number_known_{false};
+  bool skip_page_{false};
+  bool in_page_body_{false};
+  bool end_of_stream_page_{false};
+  bool last_packet_{false};
+
+  int64_t page_granule_position_{-1};
+  int64_t granule_position_{-1};
+};
+
+}  // namespace audio
+}  // namespace esphome
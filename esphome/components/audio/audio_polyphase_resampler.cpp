@@ -0,0 +1,277 @@
+#include "audio_polyphase_resampler.h"
+
+#ifdef USE_ESP32
+
+#include "audio_filter_design.h"
+
+#include "esphome/core/helpers.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace audio {
+
+// Kaiser window beta; gives about 60 dB of stopband attenuation
+static constexpr double KAISER_BETA = 5.65;
+
+// Cutoff frequency as a fraction of the lower sample rate's Nyquist frequency. The transition band is centered just
+// below Nyquist so that very little energy aliases into the audible band.
+static constexpr double CUTOFF_RATIO = 0.92;
+
+// Reduce the gain by -3 dB to avoid clipping, matching the generic resampler's gain
+static constexpr double FILTER_GAIN = 0.7079457843841379;
+
+template<uint8_t FACTOR> struct PolyphaseFilter {
+  static constexpr uint16_t TAPS = FACTOR * POLYPHASE_TAPS_PER_PHASE;
+  // Each phase sums to FILTER_GAIN, so the zero-stuffed signal's lost energy is restored
+  int16_t interpolation[TAPS];
+  // The whole filter sums to FILTER_GAIN
+  int16_t decimation[TAPS];
+};
+
+template<uint8_t FACTOR> static constexpr PolyphaseFilter<FACTOR> design_polyphase_filter() {
+  PolyphaseFilter<FACTOR> filter{};
+
+  const uint16_t taps = PolyphaseFilter<FACTOR>::TAPS;
+  const double center = (taps - 1) / 2.0;
+  const double cutoff = CUTOFF_RATIO * 0.5 / FACTOR;  // Cycles per sample at the higher sample rate
+
+  double prototype[PolyphaseFilter<FACTOR>::TAPS]{};
+  double sum = 0.0;
+  for (uint16_t n = 0; n < taps; ++n) {
+    prototype[n] = filter_design::kaiser_sinc(n - center, cutoff, center, KAISER_BETA);
+    sum += prototype[n];
+  }
+
+  for (uint16_t n = 0; n < taps; ++n) {
+    filter.interpolation[n] = filter_design::to_q15(prototype[n] * FACTOR * FILTER_GAIN / sum);
+    filter.decimation[n] = filter_design::to_q15(prototype[n] * FILTER_GAIN / sum);
+  }
+
+  return filter;
+}
+
+static constexpr PolyphaseFilter<2> FILTER_FACTOR_2 = design_polyphase_filter<2>();
+static constexpr PolyphaseFilter<3> FILTER_FACTOR_3 = design_polyphase_filter<3>();
+static constexpr PolyphaseFilter<4> FILTER_FACTOR_4 = design_polyphase_filter<4>();
+static constexpr PolyphaseFilter<6> FILTER_FACTOR_6 = design_polyphase_filter<6>();
+
+static const int16_t *get_coefficients(uint8_t factor, bool upsample) {
+  switch (factor) {
+    case 2:
+      return upsample ? FILTER_FACTOR_2.interpolation : FILTER_FACTOR_2.decimation;
+    case 3:
+      return upsample ? FILTER_FACTOR_3.interpolation : FILTER_FACTOR_3.decimation;
+    case 4:
+      return upsample ? FILTER_FACTOR_4.interpolation : FILTER_FACTOR_4.decimation;
+    case 6:
+      return upsample ? FILTER_FACTOR_6.interpolation : FILTER_FACTOR_6.decimation;
+    default:
+      return nullptr;
+  }
+}
+
+static uint8_t get_factor(uint32_t input_sample_rate, uint32_t output_sample_rate) {
+  const uint32_t high_rate = std::max(input_sample_rate, output_sample_rate);
+  const uint32_t low_rate = std::min(input_sample_rate, output_sample_rate);
+
+  if ((low_rate == 0) || (high_rate % low_rate != 0)) {
+    return 0;
+  }
+
+  const uint32_t factor = high_rate / low_rate;
+  if (factor > UINT8_MAX) {
+    return 0;
+  }
+  return factor;
+}
+
+PolyphaseResampler::~PolyphaseResampler() { this->deallocate_history_(); }
+
+bool PolyphaseResampler::is_supported(uint32_t input_sample_rate, uint32_t output_sample_rate) {
+  return get_coefficients(get_factor(input_sample_rate, output_sample_rate), true) != nullptr;
+}
+
+bool PolyphaseResampler::initialize(const AudioStreamInfo &input_stream_info,
+                                    const AudioStreamInfo &output_stream_info, const ChannelMixer *channel_mixer) {
+  this->deallocate_history_();
+
+  this->input_channels_ = input_stream_info.get_channels();
+  this->output_channels_ = output_stream_info.get_channels();
+  this->channel_mixer_ = channel_mixer;
+
+  if (channel_mixer != nullptr) {
+    if ((channel_mixer->get_input_channels() != this->input_channels_) ||
+        (channel_mixer->get_output_channels() != this->output_channels_)) {
+      return false;
+    }
+  } else if (this->input_channels_ != this->output_channels_) {
+    return false;
+  }
+
+  this->factor_ = get_factor(input_stream_info.get_sample_rate(), output_stream_info.get_sample_rate());
+  this->upsample_ = output_stream_info.get_sample_rate() > input_stream_info.get_sample_rate();
+  this->coefficients_ = get_coefficients(this->factor_, this->upsample_);
+
+  if (this->coefficients_ == nullptr) {
+    return false;
+  }
+
+  // Filter the smaller number of channels
+  this->mix_on_input_ = this->output_channels_ <= this->input_channels_;
+  this->channels_ = this->mix_on_input_ ? this->output_channels_ : this->input_channels_;
+
+  this->input_bytes_per_sample_ = input_stream_info.samples_to_bytes(1);
+  this->output_bytes_per_sample_ = output_stream_info.samples_to_bytes(1);
+  // The mixer works with Q31 samples, so mixing always uses the wide path
+  this->narrow_ = (this->input_bytes_per_sample_ == 2) && (this->output_bytes_per_sample_ == 2) &&
+                  (this->channel_mixer_ == nullptr);
+
+  // Upsampling filters each phase over POLYPHASE_TAPS_PER_PHASE input samples, while downsampling filters over the
+  // full filter length
+  this->history_length_ = this->upsample_ ? POLYPHASE_TAPS_PER_PHASE : this->factor_ * POLYPHASE_TAPS_PER_PHASE;
+  this->history_index_ = 0;
+  this->decimation_phase_ = 0;
+
+  // Keep the history in internal memory, as every output sample reads through it
+  this->history_size_ = 2 * this->history_length_ * this->channels_;
+  RAMAllocator<int32_t> allocator(RAMAllocator<int32_t>::ALLOC_INTERNAL);
+  this->history_ = allocator.allocate(this->history_size_);
+  if (this->history_ == nullptr) {
+    this->history_size_ = 0;
+    return false;
+  }
+  memset(this->history_, 0, this->history_size_ * sizeof(int32_t));
+
+  return true;
+}
+
+PolyphaseResamplerResults PolyphaseResampler::resample(const uint8_t *input, uint8_t *output, uint32_t input_frames,
+                                                       uint32_t output_frames) {
+  PolyphaseResamplerResults results = {.frames_used = 0, .frames_generated = 0};
+
+  const size_t input_frame_size = this->input_bytes_per_sample_ * this->input_channels_;
+  const size_t output_frame_size = this->output_bytes_per_sample_ * this->output_channels_;
+
+  if (this->upsample_) {
+    while ((results.frames_used < input_frames) && (results.frames_generated + this->factor_ <= output_frames)) {
+      this->push_frame_(input);
+      input += input_frame_size;
+      ++results.frames_used;
+
+      for (uint8_t phase = 0; phase < this->factor_; ++phase) {
+        this->compute_frame_(phase, this->factor_, POLYPHASE_TAPS_PER_PHASE, output);
+        output += output_frame_size;
+      }
+      results.frames_generated += this->factor_;
+    }
+  } else {
+    while (results.frames_used < input_frames) {
+      if ((this->decimation_phase_ + 1 == this->factor_) && (results.frames_generated >= output_frames)) {
+        // The next input frame produces an output frame, but there is no space to store it
+        break;
+      }
+
+      this->push_frame_(input);
+      input += input_frame_size;
+      ++results.frames_used;
+
+      if (++this->decimation_phase_ == this->factor_) {
+        this->decimation_phase_ = 0;
+        this->compute_frame_(0, 1, this->history_length_, output);
+        output += output_frame_size;
+        ++results.frames_generated;
+      }
+    }
+  }
+
+  return results;
+}
+
+void PolyphaseResampler::push_frame_(const uint8_t *frame) {
+  this->history_index_ = (this->history_index_ + 1 == this->history_length_) ? 0 : this->history_index_ + 1;
+
+  int32_t mixed_frame[MAX_CHANNEL_MIXER_CHANNELS];
+  if ((this->channel_mixer_ != nullptr) && this->mix_on_input_) {
+    int32_t input_frame[MAX_CHANNEL_MIXER_CHANNELS];
+    for (uint8_t channel = 0; channel < this->input_channels_; ++channel) {
+      input_frame[channel] = unpack_audio_sample_to_q31(frame + channel * this->input_bytes_per_sample_,
+                                                        this->input_bytes_per_sample_);
+    }
+    this->channel_mixer_->mix_frame(input_frame, mixed_frame);
+  }
+
+  for (uint8_t channel = 0; channel < this->channels_; ++channel) {
+    int32_t sample;
+    if ((this->channel_mixer_ != nullptr) && this->mix_on_input_) {
+      sample = mixed_frame[channel];
+    } else if (this->narrow_) {
+      sample = reinterpret_cast<const int16_t *>(frame)[channel];
+    } else {
+      sample = unpack_audio_sample_to_q31(frame + channel * this->input_bytes_per_sample_,
+                                          this->input_bytes_per_sample_);
+    }
+
+    int32_t *channel_history = this->history_ + channel * 2 * this->history_length_;
+    channel_history[this->history_index_] = sample;
+    channel_history[this->history_index_ + this->history_length_] = sample;
+  }
+}
+
+void PolyphaseResampler::compute_frame_(uint16_t coefficient_offset, uint16_t coefficient_stride, uint16_t taps,
+                                        uint8_t *output) {
+  const int16_t *coefficients = this->coefficients_ + coefficient_offset;
+  const bool mix_on_output = (this->channel_mixer_ != nullptr) && !this->mix_on_input_;
+  int32_t filtered_frame[MAX_CHANNEL_MIXER_CHANNELS];
+
+  for (uint8_t channel = 0; channel < this->channels_; ++channel) {
+    // Newest sample; older samples are at decreasing addresses
+    const int32_t *newest =
+        this->history_ + channel * 2 * this->history_length_ + this->history_index_ + this->history_length_;
+
+    if (this->narrow_) {
+      // 16 bit samples times Q15 coefficients; the filter's absolute sum is below 1, so 32 bits never overflow
+      int32_t accumulator = 1 << 14;  // Rounding
+      for (uint16_t tap = 0; tap < taps; ++tap) {
+        accumulator += newest[-tap] * coefficients[tap * coefficient_stride];
+      }
+      reinterpret_cast<int16_t *>(output)[channel] =
+          static_cast<int16_t>(clamp<int32_t>(accumulator >> 15, INT16_MIN, INT16_MAX));
+    } else {
+      int64_t accumulator = 1 << 14;  // Rounding
+      for (uint16_t tap = 0; tap < taps; ++tap) {
+        accumulator += static_cast<int64_t>(newest[-tap]) * coefficients[tap * coefficient_stride];
+      }
+      const int32_t sample = static_cast<int32_t>(clamp<int64_t>(accumulator >> 15, INT32_MIN, INT32_MAX));
+      if (mix_on_output) {
+        filtered_frame[channel] = sample;
+      } else {
+        pack_q31_as_audio_sample(sample, output + channel * this->output_bytes_per_sample_,
+                                 this->output_bytes_per_sample_);
+      }
+    }
+  }
+
+  if (mix_on_output) {
+    int32_t mixed_frame[MAX_CHANNEL_MIXER_CHANNELS];
+    this->channel_mixer_->mix_frame(filtered_frame, mixed_frame);
+    for (uint8_t channel = 0; channel < this->output_channels_; ++channel) {
+      pack_q31_as_audio_sample(mixed_frame[channel], output + channel * this->output_bytes_per_sample_,
+                               this->output_bytes_per_sample_);
+    }
+  }
+}
+
+void PolyphaseResampler::deallocate_history_() {
+  if (this->history_ != nullptr) {
+    RAMAllocator<int32_t> allocator(RAMAllocator<int32_t>::ALLOC_INTERNAL);
+    allocator.deallocate(this->history_, this->history_size_);
+    this->history_ = nullptr;
+  }
+  this->history_size_ = 0;
+}
+
+}  // namespace audio
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,105 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "audio.h"
+#include "audio_channel_mixer.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace audio {
+
+// Number of FIR taps used to compute each output sample when upsampling. Downsampling by a factor of N uses N times as
+// many taps per output sample, as it must filter at the higher input rate.
+static const uint16_t POLYPHASE_TAPS_PER_PHASE = 32;
+
+struct PolyphaseResamplerResults {
+  uint32_t frames_used;
+  uint32_t frames_generated;
+};
+
+class PolyphaseResampler {
+  /*
+   * @brief Fixed-point polyphase FIR resampler for sample rates that differ by an integer factor (e.g., 16 kHz <-> 48
+   * kHz or 24 kHz <-> 48 kHz). The Kaiser windowed-sinc filter coefficients are generated at compile time.
+   *   - Upsampling by L evaluates only the L filter phases, so no zero-stuffed samples are ever multiplied.
+   *   - Downsampling by M computes only the kept output samples.
+   * Also converts bits per sample. 16 bit to 16 bit conversions use 32 bit accumulators; wider samples use 64 bit.
+   * An optional channel mixer is fused into the filter: downmixes happen before filtering and upmixes after, so only
+   * the smaller number of channels is ever filtered.
+   */
+ public:
+  ~PolyphaseResampler();
+
+  /// @brief Determines whether the fast path supports converting between the sample rates
+  /// @param input_sample_rate Incoming sample rate
+  /// @param output_sample_rate Outgoing sample rate
+  /// @return True if the rates differ by a supported integer factor
+  static bool is_supported(uint32_t input_sample_rate, uint32_t output_sample_rate);
+
+  /// @brief Selects the filter and allocates the filter history.
+  /// @param input_stream_info The incoming stream information
+  /// @param output_stream_info The outgoing stream information
+  /// @param channel_mixer Optional mixer that converts between the input and output channels. Must outlive this object.
+  ///                      Required if the channel counts differ.
+  /// @return True if successful, false if the conversion isn't supported or the history failed to allocate
+  bool initialize(const AudioStreamInfo &input_stream_info, const AudioStreamInfo &output_stream_info,
+                  const ChannelMixer *channel_mixer = nullptr);
+
+  /// @brief Resamples as many frames as possible without overflowing the output buffer.
+  /// @param input Pointer to the input audio frames
+  /// @param output Pointer to the output buffer
+  /// @param input_frames Number of frames available in the input
+  /// @param output_frames Number of frames that fit in the output buffer
+  /// @return PolyphaseResamplerResults with the number of frames used and generated
+  PolyphaseResamplerResults resample(const uint8_t *input, uint8_t *output, uint32_t input_frames,
+                                     uint32_t output_frames);
+
+ protected:
+  /// @brief Stores the input frame in the history of every channel
+  void push_frame_(const uint8_t *frame);
+
+  /// @brief Computes one output frame using the filter phase and the history
+  /// @param coefficient_offset Index of the first filter coefficient to use
+  /// @param coefficient_stride Distance between successive filter coefficients
+  /// @param taps Number of taps to compute
+  /// @param output Pointer to store the packed output frame
+  void compute_frame_(uint16_t coefficient_offset, uint16_t coefficient_stride, uint16_t taps, uint8_t *output);
+
+  void deallocate_history_();
+
+  const int16_t *coefficients_{nullptr};
+
+  // History of recent input samples. Each channel has a buffer of 2 * history_length_ samples, where every sample is
+  // stored twice so the newest history_length_ samples are always contiguous.
+  int32_t *history_{nullptr};
+  size_t history_size_{0};
+  uint16_t history_length_{0};
+  uint16_t history_index_{0};
+
+  uint8_t factor_{1};
+  bool upsample_{true};
+  // Number of input frames received since the last output frame when downsampling
+  uint8_t decimation_phase_{0};
+
+  // If true, the history stores 16 bit samples and uses 32 bit accumulators; otherwise Q31 samples and 64 bit
+  bool narrow_{true};
+
+  const ChannelMixer *channel_mixer_{nullptr};
+  // If true, the mixer runs on input frames before filtering; otherwise on filtered frames before packing
+  bool mix_on_input_{false};
+
+  // Number of channels stored in the history and filtered
+  uint8_t channels_{1};
+  uint8_t input_channels_{1};
+  uint8_t output_channels_{1};
+  size_t input_bytes_per_sample_{2};
+  size_t output_bytes_per_sample_{2};
+};
+
+}  // namespace audio
+}  // namespace esphome
+
+#endif
@@ -10,6 +10,11 @@
 #include "esp_crt_bundle.h"
 #endif
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
 namespace esphome {
 namespace audio {
 
@@ -24,6 +29,21 @@ static const size_t HTTP_STREAM_BUFFER_SIZE = 2048;
 
 static const uint8_t MAX_REDIRECTION = 5;
 
+// Number of times to try restoring a dropped http connection before failing
+static const uint8_t MAX_RECONNECT_ATTEMPTS = 5;
+// Delay before the first reconnect attempt; doubles with each failed attempt
+static const uint32_t RECONNECT_BASE_DELAY_MS = 250;
+
+static const size_t MAX_URL_LENGTH = 500;
+
+// Playlists are read completely before parsing; large live playlists with a long history are rejected
+static const size_t HLS_MAX_PLAYLIST_SIZE = 32 * 1024;
+static const size_t HLS_PLAYLIST_READ_SIZE = 1024;
+// Number of segments before the end of a live playlist to start playing from, as RFC 8216 recommends
+static const size_t HLS_LIVE_START_SEGMENTS = 3;
+// Reload a live playlist when this many segments or fewer are queued
+static const size_t HLS_LIVE_REFILL_SEGMENTS = 1;
+
 // Some common HTTP status codes - borrowed from http_request component accessed 20241224
 enum HttpStatus {
   HTTP_STATUS_OK = 200,
@@ -47,12 +67,18 @@ enum HttpStatus {
   HTTP_STATUS_METHOD_NOT_ALLOWED = 405,
   HTTP_STATUS_NOT_ACCEPTABLE = 406,
   HTTP_STATUS_LENGTH_REQUIRED = 411,
+  HTTP_STATUS_RANGE_NOT_SATISFIABLE = 416,
 
   /* 5xx - Server Error */
   HTTP_STATUS_INTERNAL_ERROR = 500
 };
 
-AudioReader::~AudioReader() { this->cleanup_connection_(); }
+AudioReader::~AudioReader() {
+  this->cleanup_connection_();
+#ifdef USE_AUDIO_FILE_CACHE
+  this->release_cache_buffer_();
+#endif
+}
 
 esp_err_t AudioReader::add_sink(const std::weak_ptr<RingBuffer> &output_ring_buffer) {
   if (current_audio_file_ != nullptr) {
@@ -72,6 +98,10 @@ esp_err_t AudioReader::add_sink(const std::weak_ptr<RingBuffer> &output_ring_buf
 esp_err_t AudioReader::start(AudioFile *audio_file, AudioFileType &file_type) {
   file_type = AudioFileType::NONE;
 
+#ifdef USE_AUDIO_TRACE
+  this->trace_blocks_ = 0;
+#endif
+
   this->current_audio_file_ = audio_file;
 
   this->file_current_ = audio_file->data;
@@ -81,6 +111,20 @@ esp_err_t AudioReader::start(AudioFile *audio_file, AudioFileType &file_type) {
 }
 
 esp_err_t AudioReader::start(const std::string &uri, AudioFileType &file_type) {
+  return this->start_(uri, file_type, nullptr);
+}
+
+esp_err_t AudioReader::start(const std::string &uri, AudioFileType &file_type, const AudioStreamInfo &pcm_stream_info) {
+  return this->start_(uri, file_type, &pcm_stream_info);
+}
+
+esp_err_t AudioReader::start_(const std::string &uri, AudioFileType &file_type,
+                              const AudioStreamInfo *pcm_stream_info) {
+  AUDIO_TRACE_START_SCOPE(trace, READER_START, this);
+#ifdef USE_AUDIO_TRACE
+  this->trace_blocks_ = 0;
+#endif
+
   file_type = AudioFileType::NONE;
 
   this->cleanup_connection_();
@@ -89,9 +133,87 @@ esp_err_t AudioReader::start(const std::string &uri, AudioFileType &file_type) {
     return ESP_ERR_INVALID_ARG;
   }
 
+#ifdef USE_AUDIO_FILE_CACHE
+  this->release_cache_buffer_();
+  this->cache_entry_ = (pcm_stream_info == nullptr) ? AudioFileCache::get().lookup(uri) : nullptr;
+  if (this->cache_entry_ != nullptr) {
+    // Cache hit, so read it from memory without connecting
+    return this->start(this->cache_entry_->get_audio_file(), file_type);
+  }
+  this->etag_.clear();
+#endif
+  this->current_audio_file_ = nullptr;
+
+  this->url_ = uri;
+  this->byte_offset_ = 0;
+  this->content_length_ = 0;
+  this->audio_file_type_ = AudioFileType::NONE;
+  this->content_type_.clear();
+  this->hls_active_ = false;
+  this->pcm_stream_info_ = AudioStreamInfo();
+
+  esp_err_t err = this->connect_(0);
+  if (err != ESP_OK) {
+    return err;
+  }
+
+  const std::string url_string = str_lower_case(this->get_client_url_());
+  const std::string url_path = url_string.substr(0, url_string.find('?'));
+
+  if (pcm_stream_info != nullptr) {
+    file_type = AudioFileType::PCM;
+    this->pcm_stream_info_ = *pcm_stream_info;
+  } else if ((str_lower_case(this->content_type_).find("mpegurl") != std::string::npos) ||
+             str_endswith(url_path, ".m3u8")) {
+    // An HLS playlist, e.g., "application/vnd.apple.mpegurl" or "audio/x-mpegurl"
+    err = this->start_hls_(file_type);
+    if (err != ESP_OK) {
+      this->cleanup_connection_();
+      return err;
+    }
+  } else if (this->audio_file_type_ == AudioFileType::NONE) {
+    // Failed to determine the file type from the header, fallback to using the url
+    file_type = get_audio_type_from_url(url_string);
+    if (file_type == AudioFileType::NONE) {
+      this->cleanup_connection_();
+      return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (file_type == AudioFileType::PCM) {
+      this->pcm_stream_info_ = parse_pcm_parameters(url_string.c_str(), this->pcm_stream_info_);
+    }
+  } else {
+    file_type = this->audio_file_type_;
+    if (file_type == AudioFileType::PCM) {
+      // Parameters in the Content-Type override those in the url
+      const std::string content_type = str_lower_case(this->content_type_);
+      this->pcm_stream_info_ = parse_pcm_parameters(str_lower_case(this->url_).c_str(), this->pcm_stream_info_);
+      this->pcm_stream_info_ = parse_pcm_parameters(content_type.c_str(), this->pcm_stream_info_);
+    }
+  }
+
+  this->last_data_read_ms_ = millis();
+
+  this->output_transfer_buffer_ = AudioSinkTransferBuffer::create(this->buffer_size_);
+  if (this->output_transfer_buffer_ == nullptr) {
+    return ESP_ERR_NO_MEM;
+  }
+
+#ifdef USE_AUDIO_FILE_CACHE
+  if ((file_type != AudioFileType::PCM) && !this->hls_active_) {
+    // A cached file can't carry the PCM format; raw PCM and HLS streams are usually live anyway
+    this->start_caching_(file_type);
+  }
+#endif
+
+  return ESP_OK;
+}
+
+esp_err_t AudioReader::connect_(size_t byte_offset) {
+  this->cleanup_connection_();
+
   esp_http_client_config_t client_config = {};
 
-  client_config.url = uri.c_str();
+  client_config.url = this->url_.c_str();
   client_config.cert_pem = nullptr;
   client_config.disable_auto_redirect = false;
   client_config.max_redirection_count = 10;
@@ -102,7 +224,7 @@ esp_err_t AudioReader::start(const std::string &uri, AudioFileType &file_type) {
   client_config.timeout_ms = CONNECTION_TIMEOUT_MS;  // Shouldn't trigger watchdog resets if caller runs in a task
 
 #if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
-  if (uri.find("https:") != std::string::npos) {
+  if (this->url_.find("https:") != std::string::npos) {
     client_config.crt_bundle_attach = esp_crt_bundle_attach;
   }
 #endif
@@ -113,6 +235,22 @@ esp_err_t AudioReader::start(const std::string &uri, AudioFileType &file_type) {
     return ESP_FAIL;
   }
 
+  return this->request_(byte_offset);
+}
+
+esp_err_t AudioReader::request_(size_t byte_offset) {
+  this->bytes_to_skip_ = 0;
+
+  if (byte_offset > 0) {
+    // The header is kept when following redirects
+    char range[32];
+    snprintf(range, sizeof(range), "bytes=%zu-", byte_offset);
+    esp_http_client_set_header(this->client_, "Range", range);
+  } else {
+    // Don't carry over a Range header from a previous request on the same connection
+    esp_http_client_delete_header(this->client_, "Range");
+  }
+
   esp_err_t err = esp_http_client_open(this->client_, 0);
 
   if (err != ESP_OK) {
@@ -130,7 +268,7 @@ esp_err_t AudioReader::start(const std::string &uri, AudioFileType &file_type) {
 
   if ((status_code < HTTP_STATUS_OK) || (status_code > HTTP_STATUS_PERMANENT_REDIRECT)) {
     this->cleanup_connection_();
-    return ESP_FAIL;
+    return (status_code == HTTP_STATUS_RANGE_NOT_SATISFIABLE) ? ESP_ERR_INVALID_ARG : ESP_FAIL;
   }
 
   ssize_t redirect_count = 0;
@@ -152,55 +290,274 @@ esp_err_t AudioReader::start(const std::string &uri, AudioFileType &file_type) {
 
     if ((status_code < HTTP_STATUS_OK) || (status_code > HTTP_STATUS_PERMANENT_REDIRECT)) {
       this->cleanup_connection_();
-      return ESP_FAIL;
+      return (status_code == HTTP_STATUS_RANGE_NOT_SATISFIABLE) ? ESP_ERR_INVALID_ARG : ESP_FAIL;
     }
 
     ++redirect_count;
   }
 
-  if (this->audio_file_type_ == AudioFileType::NONE) {
-    // Failed to determine the file type from the header, fallback to using the url
-    char url[500];
-    err = esp_http_client_get_url(this->client_, url, 500);
+  const int64_t response_length = esp_http_client_get_content_length(this->client_);
+
+  if ((byte_offset > 0) && (status_code != HTTP_STATUS_PARTIAL_CONTENT)) {
+    // The server ignored the Range request and is sending the whole file, so discard everything before the offset
+    this->bytes_to_skip_ = byte_offset;
+  }
+
+  if (response_length > 0) {
+    // A partial response's length excludes the bytes before the offset
+    this->content_length_ = response_length + ((status_code == HTTP_STATUS_PARTIAL_CONTENT) ? byte_offset : 0);
+  }
+
+  return ESP_OK;
+}
+
+bool AudioReader::reconnect_() {
+  // Files of unknown length are usually live streams, where resuming at an offset is meaningless
+  const size_t resume_offset = (this->content_length_ > 0) ? this->byte_offset_ : 0;
+
+  for (uint8_t attempt = 0; attempt < MAX_RECONNECT_ATTEMPTS; ++attempt) {
+    delay(RECONNECT_BASE_DELAY_MS << attempt);
+
+    if (this->connect_(resume_offset) == ESP_OK) {
+      this->last_data_read_ms_ = millis();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::string AudioReader::get_client_url_() {
+  char url[MAX_URL_LENGTH];
+  if (esp_http_client_get_url(this->client_, url, sizeof(url)) != ESP_OK) {
+    return std::string();
+  }
+  return std::string(url);
+}
+
+esp_err_t AudioReader::start_hls_(AudioFileType &file_type) {
+  this->hls_active_ = true;
+  this->hls_segments_.clear();
+  this->hls_next_sequence_ = 0;
+  this->hls_last_reload_ms_ = 0;
+  this->hls_ended_ = false;
+
+  esp_err_t err = this->load_hls_playlist_();
+  if (err != ESP_OK) {
+    return err;
+  }
+
+  if (this->hls_segments_.empty()) {
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  const HlsSegment segment = this->hls_segments_.front();
+  this->hls_segments_.pop_front();
+
+  this->audio_file_type_ = AudioFileType::NONE;
+  err = this->request_hls_url_(segment.url);
+  if (err != ESP_OK) {
+    return err;
+  }
+
+  // Every segment is assumed to have the same format as the first
+  file_type = this->audio_file_type_;
+  if (file_type == AudioFileType::NONE) {
+    file_type = get_audio_type_from_url(str_lower_case(segment.url));
+  }
+  if ((file_type == AudioFileType::NONE) || (file_type == AudioFileType::PCM)) {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+
+  return ESP_OK;
+}
+
+esp_err_t AudioReader::load_hls_playlist_() {
+  HlsPlaylist playlist;
+  std::string text;
+
+  for (uint8_t depth = 0;; ++depth) {
+    // Read the whole playlist response
+    text.clear();
+    while (!esp_http_client_is_complete_data_received(this->client_)) {
+      if (text.size() >= HLS_MAX_PLAYLIST_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+      }
+      const size_t length = text.size();
+      text.resize(length + HLS_PLAYLIST_READ_SIZE);
+      const int received_len = esp_http_client_read(this->client_, &text[length], HLS_PLAYLIST_READ_SIZE);
+      if (received_len < 0) {
+        return ESP_FAIL;
+      }
+      text.resize(length + received_len);
+      if (received_len == 0) {
+        // The server closed a response without a length, or timed out
+        break;
+      }
+    }
+
+    const std::string playlist_url = this->get_client_url_();
+    if (!playlist.parse(text, playlist_url)) {
+      return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if (!playlist.is_master()) {
+      this->hls_playlist_url_ = playlist_url;
+      break;
+    }
+
+    if (depth > 0) {
+      // A variant must be a media playlist
+      return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    esp_err_t err = this->request_hls_url_(playlist.get_variant_url());
     if (err != ESP_OK) {
-      this->cleanup_connection_();
       return err;
     }
+  }
 
-    std::string url_string = str_lower_case(url);
-
-    if (str_endswith(url_string, ".wav")) {
-      file_type = AudioFileType::WAV;
+  const std::vector<HlsSegment> &segments = playlist.get_segments();
+  size_t first_segment = 0;
+  if ((this->hls_last_reload_ms_ == 0) && !playlist.is_ended() && (segments.size() > HLS_LIVE_START_SEGMENTS)) {
+    // Join a live stream near its live edge rather than at the oldest segment still listed
+    first_segment = segments.size() - HLS_LIVE_START_SEGMENTS;
+  }
+  for (size_t i = first_segment; i < segments.size(); ++i) {
+    if (segments[i].sequence >= this->hls_next_sequence_) {
+      this->hls_segments_.push_back(segments[i]);
+      this->hls_next_sequence_ = segments[i].sequence + 1;
     }
-#ifdef USE_AUDIO_MP3_SUPPORT
-    else if (str_endswith(url_string, ".mp3")) {
-      file_type = AudioFileType::MP3;
+  }
+
+  this->hls_target_duration_ms_ = playlist.get_target_duration_ms();
+  this->hls_ended_ = playlist.is_ended();
+  this->hls_last_reload_ms_ = millis();
+  if (this->hls_last_reload_ms_ == 0) {
+    // Zero marks a playlist that hasn't been loaded yet
+    this->hls_last_reload_ms_ = 1;
+  }
+
+  return ESP_OK;
+}
+
+esp_err_t AudioReader::request_hls_url_(const std::string &url) {
+  this->url_ = url;
+  this->byte_offset_ = 0;
+  this->content_length_ = 0;
+
+  if (this->client_ != nullptr) {
+    // Reuse the keep-alive connection to skip a new TCP and TLS handshake. The client reconnects by itself if the
+    // host differs.
+    if ((esp_http_client_set_url(this->client_, this->url_.c_str()) == ESP_OK) && (this->request_(0) == ESP_OK)) {
+      return ESP_OK;
     }
-#endif
-#ifdef USE_AUDIO_FLAC_SUPPORT
-    else if (str_endswith(url_string, ".flac")) {
-      file_type = AudioFileType::FLAC;
+  }
+
+  // The server may have closed the connection, so retry on a fresh one
+  return this->connect_(0);
+}
+
+AudioReaderState AudioReader::next_hls_segment_() {
+  const bool reload_due = (millis() - this->hls_last_reload_ms_) >= (this->hls_target_duration_ms_ / 2);
+  if (!this->hls_ended_ && (this->hls_segments_.size() <= HLS_LIVE_REFILL_SEGMENTS) && reload_due) {
+    // Reload the live playlist before the queued segments run out
+    const size_t queued_segments = this->hls_segments_.size();
+    if ((this->request_hls_url_(this->hls_playlist_url_) != ESP_OK) || (this->load_hls_playlist_() != ESP_OK)) {
+      if (queued_segments == 0) {
+        this->cleanup_connection_();
+        return AudioReaderState::FAILED;
+      }
+      // Play the queued segments and try again later
+      this->hls_last_reload_ms_ = millis();
     }
-#endif
-    else {
-      file_type = AudioFileType::NONE;
-      this->cleanup_connection_();
-      return ESP_ERR_NOT_SUPPORTED;
+  }
+
+  if (this->hls_segments_.empty()) {
+    if (this->hls_ended_) {
+      if (this->output_transfer_buffer_->available() == 0) {
+        this->cleanup_connection_();
+        return AudioReaderState::FINISHED;
+      }
+    } else {
+      // Wait for the live playlist to list new segments
+      delay(READ_WRITE_TIMEOUT_MS);
     }
-  } else {
-    file_type = this->audio_file_type_;
+    return AudioReaderState::READING;
   }
 
+  const HlsSegment segment = this->hls_segments_.front();
+  this->hls_segments_.pop_front();
+
+  if (this->request_hls_url_(segment.url) != ESP_OK) {
+    this->cleanup_connection_();
+    return AudioReaderState::FAILED;
+  }
   this->last_data_read_ms_ = millis();
 
-  this->output_transfer_buffer_ = AudioSinkTransferBuffer::create(this->buffer_size_);
-  if (this->output_transfer_buffer_ == nullptr) {
-    return ESP_ERR_NO_MEM;
+  return AudioReaderState::READING;
+}
+
+esp_err_t AudioReader::seek(size_t byte_offset) {
+  if (this->hls_active_) {
+    // Segments aren't byte addressable as one stream
+    return ESP_ERR_NOT_SUPPORTED;
   }
 
+  if ((this->client_ == nullptr) || (this->output_transfer_buffer_ == nullptr)) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  if ((this->content_length_ > 0) && (byte_offset >= this->content_length_)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  this->output_transfer_buffer_->clear_buffered_data();
+
+#ifdef USE_AUDIO_FILE_CACHE
+  // The stored download would have a gap, so don't cache it
+  this->release_cache_buffer_();
+#endif
+
+  esp_err_t err = this->connect_(byte_offset);
+  if (err != ESP_OK) {
+    return err;
+  }
+
+  this->byte_offset_ = byte_offset;
+  this->last_data_read_ms_ = millis();
+
   return ESP_OK;
 }
 
+#ifdef USE_AUDIO_FILE_CACHE
+void AudioReader::start_caching_(AudioFileType file_type) {
+  this->release_cache_buffer_();
+
+  this->cache_buffer_ = AudioFileCache::get().allocate(this->content_length_);
+  if (this->cache_buffer_ != nullptr) {
+    this->cache_buffer_size_ = this->content_length_;
+    this->cache_file_type_ = file_type;
+  }
+}
+
+void AudioReader::finish_caching_() {
+  if ((this->cache_buffer_ != nullptr) && (this->byte_offset_ == this->cache_buffer_size_)) {
+    AudioFileCache::get().insert(this->url_, this->etag_, this->cache_file_type_, this->cache_buffer_,
+                                 this->cache_buffer_size_);
+    this->cache_buffer_ = nullptr;
+    this->cache_buffer_size_ = 0;
+  }
+  this->release_cache_buffer_();
+}
+
+void AudioReader::release_cache_buffer_() {
+  AudioFileCache::get().deallocate(this->cache_buffer_, this->cache_buffer_size_);
+  this->cache_buffer_ = nullptr;
+  this->cache_buffer_size_ = 0;
+}
+#endif
+
 AudioReaderState AudioReader::read() {
   if (this->client_ != nullptr) {
     return this->http_read_();
@@ -221,14 +578,95 @@ AudioFileType AudioReader::get_audio_type(const char *content_type) {
   if (strcasecmp(content_type, "audio/wav") == 0) {
     return AudioFileType::WAV;
   }
+  // PCM types usually carry format parameters, e.g., "audio/pcm; rate=16000; channels=1"
+  if (strncasecmp(content_type, "audio/pcm", 9) == 0 || strncasecmp(content_type, "audio/x-pcm", 11) == 0 ||
+      strncasecmp(content_type, "audio/raw", 9) == 0) {
+    return AudioFileType::PCM;
+  }
 #ifdef USE_AUDIO_FLAC_SUPPORT
   if (strcasecmp(content_type, "audio/flac") == 0 || strcasecmp(content_type, "audio/x-flac") == 0) {
     return AudioFileType::FLAC;
   }
+#endif
+#ifdef USE_AUDIO_OPUS_SUPPORT
+  // Ogg types often carry a codecs parameter, e.g., "audio/ogg; codecs=opus"
+  if (strncasecmp(content_type, "audio/ogg", 9) == 0 || strncasecmp(content_type, "audio/opus", 10) == 0 ||
+      strncasecmp(content_type, "application/ogg", 15) == 0) {
+    return AudioFileType::OPUS;
+  }
 #endif
   return AudioFileType::NONE;
 }
 
+AudioFileType AudioReader::get_audio_type_from_url(const std::string &url) {
+  const std::string path = url.substr(0, url.find('?'));
+
+  if (str_endswith(path, ".wav")) {
+    return AudioFileType::WAV;
+  }
+  if (str_endswith(path, ".pcm") || str_endswith(path, ".raw")) {
+    return AudioFileType::PCM;
+  }
+#ifdef USE_AUDIO_MP3_SUPPORT
+  if (str_endswith(path, ".mp3")) {
+    return AudioFileType::MP3;
+  }
+#endif
+#ifdef USE_AUDIO_FLAC_SUPPORT
+  if (str_endswith(path, ".flac")) {
+    return AudioFileType::FLAC;
+  }
+#endif
+#ifdef USE_AUDIO_OPUS_SUPPORT
+  if (str_endswith(path, ".opus") || str_endswith(path, ".ogg")) {
+    return AudioFileType::OPUS;
+  }
+#endif
+  return AudioFileType::NONE;
+}
+
+AudioStreamInfo AudioReader::parse_pcm_parameters(const char *parameters, const AudioStreamInfo &stream_info) {
+  uint32_t sample_rate = stream_info.get_sample_rate();
+  uint32_t channels = stream_info.get_channels();
+  uint32_t bits_per_sample = stream_info.get_bits_per_sample();
+
+  const char *key = parameters;
+  while ((key = strpbrk(key, ";&?")) != nullptr) {
+    ++key;
+    while (*key == ' ') {
+      ++key;
+    }
+
+    const char *equals = strchr(key, '=');
+    if (equals == nullptr) {
+      break;
+    }
+    const size_t key_length = equals - key;
+
+    char *value_end;
+    const uint32_t value = strtoul(equals + 1, &value_end, 10);
+    if (value_end == equals + 1) {
+      // Not a number
+      continue;
+    }
+
+    auto key_is = [key, key_length](const char *name) {
+      return (strlen(name) == key_length) && (strncasecmp(key, name, key_length) == 0);
+    };
+
+    if ((key_is("rate") || key_is("sample_rate")) && (value > 0)) {
+      sample_rate = value;
+    } else if (key_is("channels") && (value > 0) && (value <= 2)) {
+      channels = value;
+    } else if ((key_is("bits") || key_is("width")) &&
+               ((value == 8) || (value == 16) || (value == 24) || (value == 32))) {
+      bits_per_sample = value;
+    }
+  }
+
+  return AudioStreamInfo(bits_per_sample, channels, sample_rate);
+}
+
 esp_err_t AudioReader::http_event_handler(esp_http_client_event_t *evt) {
   // Based on https://github.com/maroc81/WeatherLily/tree/main/main/net accessed 20241224
   AudioReader *this_reader = (AudioReader *) evt->user_data;
@@ -237,7 +675,13 @@ esp_err_t AudioReader::http_event_handler(esp_http_client_event_t *evt) {
     case HTTP_EVENT_ON_HEADER:
       if (strcasecmp(evt->header_key, "Content-Type") == 0) {
         this_reader->audio_file_type_ = get_audio_type(evt->header_value);
+        this_reader->content_type_ = evt->header_value;
+      }
+#ifdef USE_AUDIO_FILE_CACHE
+      else if (strcasecmp(evt->header_key, "ETag") == 0) {
+        this_reader->etag_ = evt->header_value;
       }
+#endif
       break;
     default:
       break;
@@ -246,11 +690,14 @@ esp_err_t AudioReader::http_event_handler(esp_http_client_event_t *evt) {
 }
 
 AudioReaderState AudioReader::file_read_() {
+  AUDIO_TRACE_SCOPE(trace, READER, this, &this->trace_blocks_);
+
   size_t remaining_bytes = this->current_audio_file_->length - (this->file_current_ - this->current_audio_file_->data);
   if (remaining_bytes > 0) {
     size_t bytes_written = this->file_ring_buffer_->write_without_replacement(this->file_current_, remaining_bytes,
                                                                               pdMS_TO_TICKS(READ_WRITE_TIMEOUT_MS));
     this->file_current_ += bytes_written;
+    AUDIO_TRACE_ADD_BYTES(trace, bytes_written);
 
     return AudioReaderState::READING;
   }
@@ -259,11 +706,20 @@ AudioReaderState AudioReader::file_read_() {
 }
 
 AudioReaderState AudioReader::http_read_() {
+  AUDIO_TRACE_SCOPE(trace, READER, this, &this->trace_blocks_);
+
   this->output_transfer_buffer_->transfer_data_to_sink(pdMS_TO_TICKS(READ_WRITE_TIMEOUT_MS), false);
 
-  if (esp_http_client_is_complete_data_received(this->client_)) {
+  if (esp_http_client_is_complete_data_received(this->client_) ||
+      ((this->content_length_ > 0) && (this->byte_offset_ >= this->content_length_))) {
+    if (this->hls_active_) {
+      return this->next_hls_segment_();
+    }
     if (this->output_transfer_buffer_->available() == 0) {
       this->cleanup_connection_();
+#ifdef USE_AUDIO_FILE_CACHE
+      this->finish_caching_();
+#endif
       return AudioReaderState::FINISHED;
     }
   } else if (this->output_transfer_buffer_->free() > 0) {
@@ -272,21 +728,42 @@ AudioReaderState AudioReader::http_read_() {
         esp_http_client_read(this->client_, (char *) this->output_transfer_buffer_->get_buffer_end(), bytes_to_read);
 
     if (received_len > 0) {
-      this->output_transfer_buffer_->increase_buffer_length(received_len);
+      size_t bytes_kept = received_len;
+      if (this->bytes_to_skip_ > 0) {
+        // Resuming on a server that ignored the Range request; drop the bytes the sink already has
+        const size_t bytes_skipped = std::min(this->bytes_to_skip_, bytes_kept);
+        this->bytes_to_skip_ -= bytes_skipped;
+        bytes_kept -= bytes_skipped;
+        memmove(this->output_transfer_buffer_->get_buffer_end(),
+                this->output_transfer_buffer_->get_buffer_end() + bytes_skipped, bytes_kept);
+      }
+#ifdef USE_AUDIO_FILE_CACHE
+      if ((this->cache_buffer_ != nullptr) && (this->byte_offset_ + bytes_kept <= this->cache_buffer_size_)) {
+        memcpy(this->cache_buffer_ + this->byte_offset_, this->output_transfer_buffer_->get_buffer_end(), bytes_kept);
+      }
+#endif
+      this->output_transfer_buffer_->increase_buffer_length(bytes_kept);
+      this->byte_offset_ += bytes_kept;
       this->last_data_read_ms_ = millis();
+      AUDIO_TRACE_ADD_BYTES(trace, bytes_kept);
     } else if (received_len < 0) {
-      // HTTP read error
-      this->cleanup_connection_();
-      return AudioReaderState::FAILED;
+      // HTTP read error, likely a dropped connection
+      if (!this->reconnect_()) {
+        this->cleanup_connection_();
+        return AudioReaderState::FAILED;
+      }
     } else {
       if (bytes_to_read > 0) {
         // Read timed out
         if ((millis() - this->last_data_read_ms_) > CONNECTION_TIMEOUT_MS) {
-          this->cleanup_connection_();
-          return AudioReaderState::FAILED;
+          // The connection stalled, so try a fresh one
+          if (!this->reconnect_()) {
+            this->cleanup_connection_();
+            return AudioReaderState::FAILED;
+          }
+        } else {
+          delay(READ_WRITE_TIMEOUT_MS);
         }
-
-        delay(READ_WRITE_TIMEOUT_MS);
       }
     }
   }
@@ -3,6 +3,9 @@
 #ifdef USE_ESP_IDF
 
 #include "audio.h"
+#include "audio_file_cache.h"
+#include "audio_hls_playlist.h"
+#include "audio_trace.h"
 #include "audio_transfer_buffer.h"
 
 #include "esphome/core/ring_buffer.h"
@@ -11,6 +14,9 @@
 
 #include <esp_http_client.h>
 
+#include <deque>
+#include <string>
+
 namespace esphome {
 namespace audio {
 
@@ -25,6 +31,16 @@ class AudioReader {
    * @brief Class that facilitates reading a raw audio file.
    * Files can be read from flash (stored in a AudioFile struct) or from an http source.
    * The file data is sent to a ring buffer sink.
+   * If an http connection drops, it reconnects and resumes at the same byte offset using a Range request, so the sink
+   * receives a seamless stream. Servers that ignore Range requests are resumed by discarding the already received
+   * bytes. Streams of unknown length (e.g., internet radio) simply reconnect and continue.
+   * If the file cache is enabled, http files that fit the cache are stored while downloading, and later requests for
+   * the same url are read from memory like a file in flash, skipping the network.
+   * Headerless PCM streams take their format from Content-Type parameters (e.g., "audio/pcm;rate=16000;channels=1"),
+   * url query parameters (e.g., "tts.pcm?rate=22050&bits=16"), or the caller.
+   * HLS playlists (m3u8) are followed segment by segment, sending the segments to the sink as one contiguous stream.
+   * Segments are requested on the same keep-alive connection, and live playlists are reloaded before the queued
+   * segments run out. The segments must be in a supported format; MPEG-TS and AAC segments aren't.
    */
  public:
   /// @brief Constructs an AudioReader object.
@@ -38,12 +54,21 @@ class AudioReader {
   /// @return  ESP_OK if successful, ESP_ERR_INVALID_STATE otherwise
   esp_err_t add_sink(const std::weak_ptr<RingBuffer> &output_ring_buffer);
 
-  /// @brief Starts reading an audio file from an http source. The transfer buffer is allocated here.
+  /// @brief Starts reading an audio file from an http source. The transfer buffer is allocated here. If the file is
+  /// cached, it is read from memory instead and no transfer buffer is allocated.
   /// @param uri Web url to the http file.
   /// @param file_type AudioFileType variable passed-by-reference indicating the type of file being read.
   /// @return ESP_OK if successful, an ESP_ERR* code otherwise.
   esp_err_t start(const std::string &uri, AudioFileType &file_type);
 
+  /// @brief Starts reading a headerless PCM stream from an http source, with the format supplied by the caller rather
+  /// than detected from the Content-Type or url.
+  /// @param uri Web url to the http stream.
+  /// @param file_type AudioFileType variable passed-by-reference; set to AudioFileType::PCM if successful.
+  /// @param pcm_stream_info Format of the PCM audio
+  /// @return ESP_OK if successful, an ESP_ERR* code otherwise.
+  esp_err_t start(const std::string &uri, AudioFileType &file_type, const AudioStreamInfo &pcm_stream_info);
+
   /// @brief Starts reading an audio file from flash. No transfer buffer is allocated.
   /// @param audio_file AudioFile struct containing the file.
   /// @param file_type AudioFileType variable passed-by-reference indicating the type of file being read.
@@ -54,6 +79,24 @@ class AudioReader {
   /// @return AudioReaderState
   AudioReaderState read();
 
+  /// @brief Moves an http source to a byte offset by reconnecting with a Range request. Discards data buffered in the
+  /// transfer buffer and the sink ring buffer, so the caller must restart any decoder reading from the sink.
+  /// @param byte_offset Offset from the start of the file in bytes
+  /// @return ESP_OK if successful, ESP_ERR_INVALID_STATE if not reading an http source,
+  ///         ESP_ERR_INVALID_ARG if the offset is past the end of the file, or an ESP_ERR* code if reconnecting failed
+  esp_err_t seek(size_t byte_offset);
+
+  /// @brief Returns the offset of the next byte the http source will send to the sink. For HLS, within the current
+  /// segment.
+  size_t get_byte_offset() const { return this->byte_offset_; }
+
+  /// @brief Returns the length of the http source in bytes, or 0 if unknown (e.g., a live stream). For HLS, the length
+  /// of the current segment.
+  size_t get_content_length() const { return this->content_length_; }
+
+  /// @brief Returns the format of a headerless PCM stream. Only valid if start set the file type to PCM.
+  const AudioStreamInfo &get_pcm_stream_info() const { return this->pcm_stream_info_; }
+
  protected:
   /// @brief Monitors the http client events to attempt determining the file type from the Content-Type header
   static esp_err_t http_event_handler(esp_http_client_event_t *evt);
@@ -63,9 +106,78 @@ class AudioReader {
   /// @return AudioFileType of the url, if it can be determined. If not, return AudioFileType::NONE.
   static AudioFileType get_audio_type(const char *content_type);
 
+  /// @brief Determines the audio file type from a url's file extension
+  /// @param url Lower case url
+  /// @return AudioFileType of the url, if it can be determined. If not, return AudioFileType::NONE.
+  static AudioFileType get_audio_type_from_url(const std::string &url);
+
+  /// @brief Reads the PCM format from "key=value" parameters separated by ';', '&', or '?'. Recognizes "rate" (or
+  /// "sample_rate"), "channels", and "bits" (or "width"); other keys and invalid values are ignored.
+  /// @param parameters String containing the parameters, e.g., a Content-Type value or url
+  /// @param stream_info Format to use for any parameter that isn't present
+  /// @return AudioStreamInfo with the parsed format
+  static AudioStreamInfo parse_pcm_parameters(const char *parameters, const AudioStreamInfo &stream_info);
+
+  /// @brief Starts reading from an http source
+  /// @param pcm_stream_info Caller supplied PCM format that forces the PCM file type, or nullptr to detect the type
+  esp_err_t start_(const std::string &uri, AudioFileType &file_type, const AudioStreamInfo *pcm_stream_info);
+
   AudioReaderState file_read_();
   AudioReaderState http_read_();
 
+  /// @brief Opens an http connection to url_, following redirects, and requests data starting at the byte offset.
+  /// @param byte_offset Offset from the start of the file in bytes. Sends a Range header if non-zero.
+  /// @return ESP_OK if successful, an ESP_ERR* code otherwise.
+  esp_err_t connect_(size_t byte_offset);
+
+  /// @brief Requests url_ starting at the byte offset on the current connection, following redirects. Sends a Range
+  /// header if the offset is non-zero.
+  /// @return ESP_OK if successful, an ESP_ERR* code otherwise. The connection is closed on failure.
+  esp_err_t request_(size_t byte_offset);
+
+  /// @brief Attempts to restore a dropped http connection at the current byte offset, backing off between attempts.
+  /// @return True if reconnected, false if all attempts failed
+  bool reconnect_();
+
+  /// @brief Returns the url of the current http request after redirects, or an empty string if unavailable
+  std::string get_client_url_();
+
+  /// @brief Starts following the HLS playlist whose response is open on the connection, and opens its first segment
+  /// @param file_type AudioFileType variable passed-by-reference indicating the type of the segments.
+  /// @return ESP_OK if successful, an ESP_ERR* code otherwise.
+  esp_err_t start_hls_(AudioFileType &file_type);
+
+  /// @brief Reads the playlist response open on the connection, following a master playlist to its variant, and
+  /// queues any new segments
+  esp_err_t load_hls_playlist_();
+
+  /// @brief Requests a url, reusing the connection if possible
+  esp_err_t request_hls_url_(const std::string &url);
+
+  /// @brief Moves on to the next segment once the current one is complete, reloading a live playlist if necessary
+  AudioReaderState next_hls_segment_();
+
+#ifdef USE_AUDIO_TRACE
+  uint32_t trace_blocks_{0};
+#endif
+
+#ifdef USE_AUDIO_FILE_CACHE
+  /// @brief Allocates a buffer to store the download in, if the file has a known size that fits in the cache
+  void start_caching_(AudioFileType file_type);
+
+  /// @brief Adds the downloaded file to the cache if it was stored completely, otherwise discards it
+  void finish_caching_();
+
+  void release_cache_buffer_();
+
+  // Keeps a cached file alive while it is being read, even if the cache evicts it
+  std::shared_ptr<AudioCacheEntry> cache_entry_;
+  uint8_t *cache_buffer_{nullptr};
+  size_t cache_buffer_size_{0};
+  AudioFileType cache_file_type_{AudioFileType::NONE};
+  std::string etag_;
+#endif
+
   std::shared_ptr<RingBuffer> file_ring_buffer_;
   std::unique_ptr<AudioSinkTransferBuffer> output_transfer_buffer_;
   void cleanup_connection_();
@@ -75,8 +187,27 @@ class AudioReader {
 
   esp_http_client_handle_t client_{nullptr};
 
+  std::string url_;
+  // Absolute offset of the next byte to send to the sink
+  size_t byte_offset_{0};
+  // Total file length in bytes, or 0 if unknown
+  size_t content_length_{0};
+  // Bytes to discard after reconnecting to a server that ignored the Range request
+  size_t bytes_to_skip_{0};
+
+  bool hls_active_{false};
+  std::string hls_playlist_url_;
+  std::deque<HlsSegment> hls_segments_;
+  // Media sequence number of the next segment to queue from a reloaded playlist
+  uint64_t hls_next_sequence_{0};
+  uint32_t hls_target_duration_ms_{0};
+  uint32_t hls_last_reload_ms_{0};
+  bool hls_ended_{false};
+
   AudioFile *current_audio_file_{nullptr};
   AudioFileType audio_file_type_{AudioFileType::NONE};
+  AudioStreamInfo pcm_stream_info_{};
+  std::string content_type_;
   const uint8_t *file_current_{nullptr};
 };
 }  // namespace audio
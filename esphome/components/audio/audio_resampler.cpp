@@ -2,6 +2,8 @@
 
 #ifdef USE_ESP32
 
+#include "audio_buffer_pool.h"
+
 #include "esphome/core/hal.h"
 
 #include <cstring>
@@ -17,6 +19,8 @@ AudioResampler::AudioResampler(size_t input_buffer_size, size_t output_buffer_si
   this->output_transfer_buffer_ = AudioSinkTransferBuffer::create(output_buffer_size);
 }
 
+AudioResampler::~AudioResampler() { this->deallocate_channel_scratch_(); }
+
 esp_err_t AudioResampler::add_source(std::weak_ptr<RingBuffer> &input_ring_buffer) {
   if (this->input_transfer_buffer_ != nullptr) {
     this->input_transfer_buffer_->set_source(input_ring_buffer);
@@ -47,21 +51,63 @@ esp_err_t AudioResampler::start(AudioStreamInfo &input_stream_info, AudioStreamI
                                 uint16_t number_of_taps, uint16_t number_of_filters) {
   this->input_stream_info_ = input_stream_info;
   this->output_stream_info_ = output_stream_info;
+#ifdef USE_AUDIO_TRACE
+  this->trace_blocks_ = 0;
+#endif
 
   if ((this->input_transfer_buffer_ == nullptr) || (this->output_transfer_buffer_ == nullptr)) {
     return ESP_ERR_NO_MEM;
   }
 
-  if ((input_stream_info.get_bits_per_sample() > 32) || (output_stream_info.get_bits_per_sample() > 32) ||
-      (input_stream_info_.get_channels() != output_stream_info.get_channels())) {
+  if ((input_stream_info.get_bits_per_sample() > 32) || (output_stream_info.get_bits_per_sample() > 32)) {
     return ESP_ERR_NOT_SUPPORTED;
   }
 
-  if ((input_stream_info.get_sample_rate() != output_stream_info.get_sample_rate()) ||
-      (input_stream_info.get_bits_per_sample() != output_stream_info.get_bits_per_sample())) {
-    this->resampler_ = make_unique<esp_audio_libs::resampler::Resampler>(
-        input_stream_info.bytes_to_samples(this->input_buffer_size_),
-        output_stream_info.bytes_to_samples(this->output_buffer_size_));
+  if (!this->channel_mixer_.configure(input_stream_info.get_channels(), output_stream_info.get_channels())) {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  this->mix_channels_ = !this->channel_mixer_.is_identity();
+  const ChannelMixer *channel_mixer = this->mix_channels_ ? &this->channel_mixer_ : nullptr;
+
+  this->resampler_.reset();
+  this->polyphase_resampler_.reset();
+  this->deallocate_channel_scratch_();
+
+  if ((input_stream_info.get_sample_rate() != output_stream_info.get_sample_rate()) &&
+      PolyphaseResampler::is_supported(input_stream_info.get_sample_rate(), output_stream_info.get_sample_rate())) {
+    // The sample rates differ by an integer factor, so use the cheaper fixed-point polyphase filter
+    this->polyphase_resampler_ = make_unique<PolyphaseResampler>();
+    if (!this->polyphase_resampler_->initialize(input_stream_info, output_stream_info, channel_mixer)) {
+      // Failed to allocate the filter history
+      return ESP_ERR_NO_MEM;
+    }
+  } else if ((input_stream_info.get_sample_rate() != output_stream_info.get_sample_rate()) ||
+             ((input_stream_info.get_bits_per_sample() != output_stream_info.get_bits_per_sample()) &&
+              !this->mix_channels_)) {
+    // The generic resampler only filters the smaller number of channels; the channels are mixed in a scratch buffer
+    // before downsampling or after upsampling
+    const uint8_t resampler_channels = std::min(input_stream_info.get_channels(), output_stream_info.get_channels());
+    const uint32_t input_frames = input_stream_info.bytes_to_frames(this->input_buffer_size_);
+    const uint32_t output_frames = output_stream_info.bytes_to_frames(this->output_buffer_size_);
+
+    if (this->mix_channels_) {
+      if (output_stream_info.get_channels() <= input_stream_info.get_channels()) {
+        this->channel_scratch_frames_ = input_frames;
+        this->channel_scratch_size_ = input_frames * resampler_channels * input_stream_info.samples_to_bytes(1);
+      } else {
+        this->channel_scratch_frames_ = output_frames;
+        this->channel_scratch_size_ = output_frames * resampler_channels * output_stream_info.samples_to_bytes(1);
+      }
+
+      this->channel_scratch_ = AudioBufferPool::get().acquire(this->channel_scratch_size_);
+      if (this->channel_scratch_ == nullptr) {
+        this->channel_scratch_size_ = 0;
+        return ESP_ERR_NO_MEM;
+      }
+    }
+
+    this->resampler_ = make_unique<esp_audio_libs::resampler::Resampler>(input_frames * resampler_channels,
+                                                                         output_frames * resampler_channels);
 
     // Use cascaded biquad filters when downsampling to avoid aliasing
     bool use_pre_filter = output_stream_info.get_sample_rate() < input_stream_info.get_sample_rate();
@@ -71,7 +117,7 @@ esp_err_t AudioResampler::start(AudioStreamInfo &input_stream_info, AudioStreamI
         .target_sample_rate = static_cast<float>(output_stream_info.get_sample_rate()),
         .source_bits_per_sample = input_stream_info.get_bits_per_sample(),
         .target_bits_per_sample = output_stream_info.get_bits_per_sample(),
-        .channels = input_stream_info_.get_channels(),
+        .channels = resampler_channels,
         .use_pre_or_post_filter = use_pre_filter,
         .subsample_interpolate = false,  // Doubles the CPU load. Using more filters is a better alternative
         .number_of_taps = number_of_taps,
@@ -94,6 +140,8 @@ AudioResamplerState AudioResampler::resample(bool stop_gracefully, int32_t *ms_d
     }
   }
 
+  AUDIO_TRACE_SCOPE(trace, RESAMPLER, this, &this->trace_blocks_);
+
   if (!this->pause_output_) {
     // Move audio data to the sink without shifting the data in the output transfer buffer to avoid unnecessary, slow
     // data moves
@@ -116,22 +164,31 @@ AudioResamplerState AudioResampler::resample(bool stop_gracefully, int32_t *ms_d
   const size_t bytes_available = this->input_transfer_buffer_->available();
   const uint32_t frames_available = this->input_stream_info_.bytes_to_frames(bytes_available);
 
-  if ((this->input_stream_info_.get_sample_rate() != this->output_stream_info_.get_sample_rate()) ||
-      (this->input_stream_info_.get_bits_per_sample() != this->output_stream_info_.get_bits_per_sample())) {
-    // Adjust gain by -3 dB to avoid clipping due to the resampling process
-    esp_audio_libs::resampler::ResamplerResults results =
-        this->resampler_->resample(this->input_transfer_buffer_->get_buffer_start(),
-                                   this->output_transfer_buffer_->get_buffer_end(), frames_available, frames_free, -3);
+  if ((this->polyphase_resampler_ != nullptr) || (this->resampler_ != nullptr)) {
+    uint32_t frames_used = 0;
+    uint32_t frames_generated = 0;
+
+    if (this->polyphase_resampler_ != nullptr) {
+      PolyphaseResamplerResults results =
+          this->polyphase_resampler_->resample(this->input_transfer_buffer_->get_buffer_start(),
+                                               this->output_transfer_buffer_->get_buffer_end(), frames_available,
+                                               frames_free);
+      frames_used = results.frames_used;
+      frames_generated = results.frames_generated;
+    } else {
+      esp_audio_libs::resampler::ResamplerResults results = this->generic_resample_(frames_available, frames_free);
+      frames_used = results.frames_used;
+      frames_generated = results.frames_generated;
+    }
 
-    this->input_transfer_buffer_->decrease_buffer_length(this->input_stream_info_.frames_to_bytes(results.frames_used));
-    this->output_transfer_buffer_->increase_buffer_length(
-        this->output_stream_info_.frames_to_bytes(results.frames_generated));
+    this->input_transfer_buffer_->decrease_buffer_length(this->input_stream_info_.frames_to_bytes(frames_used));
+    this->output_transfer_buffer_->increase_buffer_length(this->output_stream_info_.frames_to_bytes(frames_generated));
 
     // Resampling causes slight differences in the durations used versus generated. Computes the difference in
     // millisconds. The callback function passing the played audio duration uses the difference to convert from output
     // duration to input duration.
-    this->accumulated_frames_used_ += results.frames_used;
-    this->accumulated_frames_generated_ += results.frames_generated;
+    this->accumulated_frames_used_ += frames_used;
+    this->accumulated_frames_generated_ += frames_generated;
 
     const int32_t used_ms =
         this->input_stream_info_.frames_to_milliseconds_with_remainder(&this->accumulated_frames_used_);
@@ -140,6 +197,20 @@ AudioResamplerState AudioResampler::resample(bool stop_gracefully, int32_t *ms_d
 
     *ms_differential = used_ms - generated_ms;
 
+  } else if (this->mix_channels_) {
+    // No resampling required, mix the channels directly into the output transfer buffer
+    *ms_differential = 0;
+
+    const uint32_t frames_to_transfer = std::min(frames_free, frames_available);
+
+    this->channel_mixer_.mix_frames(this->input_transfer_buffer_->get_buffer_start(),
+                                    this->input_stream_info_.samples_to_bytes(1),
+                                    this->output_transfer_buffer_->get_buffer_end(),
+                                    this->output_stream_info_.samples_to_bytes(1), frames_to_transfer);
+
+    this->input_transfer_buffer_->decrease_buffer_length(this->input_stream_info_.frames_to_bytes(frames_to_transfer));
+    this->output_transfer_buffer_->increase_buffer_length(
+        this->output_stream_info_.frames_to_bytes(frames_to_transfer));
   } else {
     // No resampling required, copy samples directly to the output transfer buffer
     *ms_differential = 0;
@@ -154,9 +225,55 @@ AudioResamplerState AudioResampler::resample(bool stop_gracefully, int32_t *ms_d
     this->output_transfer_buffer_->increase_buffer_length(bytes_to_transfer);
   }
 
+  AUDIO_TRACE_ADD_BYTES(trace, bytes_available - this->input_transfer_buffer_->available());
+
   return AudioResamplerState::RESAMPLING;
 }
 
+esp_audio_libs::resampler::ResamplerResults AudioResampler::generic_resample_(uint32_t frames_available,
+                                                                              uint32_t frames_free) {
+  uint8_t *resampler_input = this->input_transfer_buffer_->get_buffer_start();
+  uint8_t *resampler_output = this->output_transfer_buffer_->get_buffer_end();
+
+  const bool downmix = this->input_stream_info_.get_channels() >= this->output_stream_info_.get_channels();
+
+  if (this->channel_scratch_ != nullptr) {
+    if (downmix) {
+      // Mixing is stateless, so any frames the resampler doesn't consume are simply mixed again next time
+      frames_available = std::min(frames_available, this->channel_scratch_frames_);
+      const size_t bytes_per_sample = this->input_stream_info_.samples_to_bytes(1);
+      this->channel_mixer_.mix_frames(resampler_input, bytes_per_sample, this->channel_scratch_, bytes_per_sample,
+                                      frames_available);
+      resampler_input = this->channel_scratch_;
+    } else {
+      frames_free = std::min(frames_free, this->channel_scratch_frames_);
+      resampler_output = this->channel_scratch_;
+    }
+  }
+
+  // Adjust gain by -3 dB to avoid clipping due to the resampling process
+  esp_audio_libs::resampler::ResamplerResults results =
+      this->resampler_->resample(resampler_input, resampler_output, frames_available, frames_free, -3);
+
+  if ((this->channel_scratch_ != nullptr) && !downmix) {
+    const size_t bytes_per_sample = this->output_stream_info_.samples_to_bytes(1);
+    this->channel_mixer_.mix_frames(this->channel_scratch_, bytes_per_sample,
+                                    this->output_transfer_buffer_->get_buffer_end(), bytes_per_sample,
+                                    results.frames_generated);
+  }
+
+  return results;
+}
+
+void AudioResampler::deallocate_channel_scratch_() {
+  if (this->channel_scratch_ != nullptr) {
+    AudioBufferPool::get().release(this->channel_scratch_, this->channel_scratch_size_);
+    this->channel_scratch_ = nullptr;
+  }
+  this->channel_scratch_size_ = 0;
+  this->channel_scratch_frames_ = 0;
+}
+
 }  // namespace audio
 }  // namespace esphome
 
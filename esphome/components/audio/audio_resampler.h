@@ -3,6 +3,9 @@
 #ifdef USE_ESP32
 
 #include "audio.h"
+#include "audio_channel_mixer.h"
+#include "audio_polyphase_resampler.h"
+#include "audio_trace.h"
 #include "audio_transfer_buffer.h"
 
 #include "esphome/core/defines.h"
@@ -31,6 +34,10 @@ class AudioResampler {
    * @brief Class that facilitates resampling audio.
    * The audio data is read from a ring buffer source, resampled, and sent to an audio sink (ring buffer or speaker
    * component). Also supports converting bits per sample.
+   * Sample rates that differ by a supported integer factor use a fixed-point polyphase filter; all other rates use the
+   * generic esp-audio-libs resampler.
+   * Converts between channel counts; mono is duplicated to every output channel and downmixes average the input
+   * channels.
    */
  public:
   /// @brief Allocates the input and output transfer buffers
@@ -38,6 +45,9 @@ class AudioResampler {
   /// @param output_buffer_size Size of the output transfer buffer in bytes.
   AudioResampler(size_t input_buffer_size, size_t output_buffer_size);
 
+  /// @brief Deallocates the channel mixing scratch buffer, if necessary
+  ~AudioResampler();
+
   /// @brief Adds a source ring buffer for audio data. Takes ownership of the ring buffer in a shared_ptr.
   /// @param input_ring_buffer weak_ptr of a shared_ptr of the sink ring buffer to transfer ownership
   /// @return ESP_OK if successsful, ESP_ERR_NO_MEM if the transfer buffer wasn't allocated
@@ -55,11 +65,11 @@ class AudioResampler {
   esp_err_t add_sink(speaker::Speaker *speaker);
 #endif
 
-  /// @brief Sets up the class to resample.
+  /// @brief Sets up the class to resample. Automatically selects the polyphase fast path for integer ratios.
   /// @param input_stream_info The incoming sample rate, bits per sample, and number of channels
   /// @param output_stream_info The desired outgoing sample rate, bits per sample, and number of channels
-  /// @param number_of_taps Number of taps per FIR filter
-  /// @param number_of_filters Number of FIR filters
+  /// @param number_of_taps Number of taps per FIR filter for the generic resampler
+  /// @param number_of_filters Number of FIR filters for the generic resampler
   /// @return ESP_OK if it is able to convert the incoming stream,
   ///         ESP_ERR_NO_MEM if the transfer buffers failed to allocate,
   ///         ESP_ERR_NOT_SUPPORTED if the stream can't be converted.
@@ -88,12 +98,31 @@ class AudioResampler {
   uint32_t accumulated_frames_used_{0};
   uint32_t accumulated_frames_generated_{0};
 
+#ifdef USE_AUDIO_TRACE
+  uint32_t trace_blocks_{0};
+#endif
+
   bool pause_output_{false};
 
+  /// @brief Runs the generic resampler, mixing channels through the scratch buffer if necessary
+  esp_audio_libs::resampler::ResamplerResults generic_resample_(uint32_t frames_available, uint32_t frames_free);
+
+  void deallocate_channel_scratch_();
+
+  ChannelMixer channel_mixer_;
+  // True if the channel mixer isn't a plain passthrough
+  bool mix_channels_{false};
+
+  // Holds the generic resampler's input when downmixing, or its output when upmixing
+  uint8_t *channel_scratch_{nullptr};
+  size_t channel_scratch_size_{0};
+  uint32_t channel_scratch_frames_{0};
+
   AudioStreamInfo input_stream_info_;
   AudioStreamInfo output_stream_info_;
 
   std::unique_ptr<esp_audio_libs::resampler::Resampler> resampler_;
+  std::unique_ptr<PolyphaseResampler> polyphase_resampler_;
 };
 
 }  // namespace audio
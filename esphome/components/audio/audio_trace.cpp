@@ -0,0 +1,139 @@
+#include "audio_trace.h"
+
+#ifdef USE_ESP32
+
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+#include <esp_timer.h>
+
+#include <cinttypes>
+#include <new>
+
+namespace esphome {
+namespace audio {
+
+static const char *const TAG = "audio.trace";
+
+const char *audio_trace_stage_to_string(AudioTraceStage stage) {
+  switch (stage) {
+    case AudioTraceStage::READER_START:
+      return "reader_start";
+    case AudioTraceStage::READER:
+      return "read";
+    case AudioTraceStage::DECODER:
+      return "decode";
+    case AudioTraceStage::RESAMPLER:
+      return "resample";
+    case AudioTraceStage::SPEAKER_START:
+      return "speaker_start";
+    case AudioTraceStage::SPEAKER_WRITE:
+      return "i2s_write";
+    case AudioTraceStage::SPEAKER_CONVERT:
+      return "convert";
+    default:
+      return "unknown";
+  }
+}
+
+#ifdef USE_AUDIO_TRACE
+
+AudioTrace &AudioTrace::get() {
+  static AudioTrace trace;
+  return trace;
+}
+
+AudioTrace::AudioTrace() {
+  RAMAllocator<AudioTraceEvent> allocator(RAMAllocator<AudioTraceEvent>::ALLOW_FAILURE);
+  this->events_ = allocator.allocate(AUDIO_TRACE_MAX_EVENTS);
+  if (this->events_ == nullptr) {
+    ESP_LOGE(TAG, "Failed to allocate %u trace events", AUDIO_TRACE_MAX_EVENTS);
+    return;
+  }
+  for (size_t i = 0; i < AUDIO_TRACE_MAX_EVENTS; ++i) {
+    new (&this->events_[i]) AudioTraceEvent();
+    this->events_[i].sequence.store(0, std::memory_order_relaxed);
+  }
+}
+
+int64_t AudioTrace::now_us() { return esp_timer_get_time(); }
+
+void AudioTrace::record(AudioTraceStage stage, const void *owner, uint32_t block_id, int64_t start_us,
+                        uint32_t bytes) {
+  if (this->events_ == nullptr) {
+    return;
+  }
+
+  const int64_t end_us = now_us();
+
+  // Each writer claims its own slot, so concurrent tasks never write the same event
+  const uint32_t index = this->next_index_.fetch_add(1, std::memory_order_relaxed);
+  AudioTraceEvent &event = this->events_[index % AUDIO_TRACE_MAX_EVENTS];
+
+  // Mark the slot as being written, so a concurrent dump skips it
+  event.sequence.store(0, std::memory_order_release);
+  event.start_us = start_us;
+  event.duration_us = static_cast<uint32_t>(end_us - start_us);
+  event.block_id = block_id;
+  event.bytes = bytes;
+  event.owner = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(owner));
+  event.stage = stage;
+  event.sequence.store(index + 1, std::memory_order_release);
+}
+
+void AudioTrace::dump() {
+  if (this->events_ == nullptr) {
+    ESP_LOGW(TAG, "No trace buffer");
+    return;
+  }
+
+  const uint32_t end_index = this->next_index_.load(std::memory_order_acquire);
+  uint32_t start_index = this->first_index_.load(std::memory_order_relaxed);
+  if (end_index - start_index > AUDIO_TRACE_MAX_EVENTS) {
+    start_index = end_index - AUDIO_TRACE_MAX_EVENTS;
+  }
+
+  ESP_LOGI(TAG, "Audio trace with %" PRIu32 " events; save the lines below with tests/audio_trace/extract_trace.py",
+           end_index - start_index);
+
+  for (uint32_t index = start_index; index != end_index; ++index) {
+    const AudioTraceEvent &event = this->events_[index % AUDIO_TRACE_MAX_EVENTS];
+
+    // Copy the event, then verify it wasn't overwritten while copying
+    const uint32_t sequence = event.sequence.load(std::memory_order_acquire);
+    const int64_t start_us = event.start_us;
+    const uint32_t duration_us = event.duration_us;
+    const uint32_t block_id = event.block_id;
+    const uint32_t bytes = event.bytes;
+    const uint32_t owner = event.owner;
+    const AudioTraceStage stage = event.stage;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if ((sequence != index + 1) || (event.sequence.load(std::memory_order_relaxed) != sequence)) {
+      continue;
+    }
+
+    // Chrome trace timestamps are in microseconds. Printed as seconds and microseconds, since printf on the device may
+    // not support 64 bit integers.
+    const uint32_t seconds = static_cast<uint32_t>(start_us / 1000000);
+    const uint32_t microseconds = static_cast<uint32_t>(start_us % 1000000);
+    char timestamp[24];
+    if (seconds > 0) {
+      snprintf(timestamp, sizeof(timestamp), "%" PRIu32 "%06" PRIu32, seconds, microseconds);
+    } else {
+      snprintf(timestamp, sizeof(timestamp), "%" PRIu32, microseconds);
+    }
+
+    ESP_LOGI(TAG,
+             "{\"name\":\"%s\",\"cat\":\"audio\",\"ph\":\"X\",\"ts\":%s,\"dur\":%" PRIu32 ",\"pid\":%" PRIu32
+             ",\"tid\":%u,\"args\":{\"block\":%" PRIu32 ",\"bytes\":%" PRIu32 "}}",
+             audio_trace_stage_to_string(stage), timestamp, duration_us, owner, static_cast<unsigned>(stage), block_id,
+             bytes);
+  }
+}
+
+#endif
+
+}  // namespace audio
+}  // namespace esphome
+
+#endif
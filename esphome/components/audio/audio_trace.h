@@ -0,0 +1,126 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "esphome/core/defines.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace audio {
+
+enum class AudioTraceStage : uint8_t {
+  READER_START = 0,  // Opening a file or connecting to a url
+  READER,            // Reading file or http data into the reader's buffer
+  DECODER,           // Decoding audio
+  RESAMPLER,         // Resampling audio
+  SPEAKER_START,     // Starting the I2S driver for a speaker
+  SPEAKER_WRITE,     // Writing audio to the I2S port
+  SPEAKER_CONVERT,   // Scaling and widening audio to the I2S bus format
+};
+
+const char *audio_trace_stage_to_string(AudioTraceStage stage);
+
+#ifdef USE_AUDIO_TRACE
+
+#ifndef AUDIO_TRACE_MAX_EVENTS
+#define AUDIO_TRACE_MAX_EVENTS 512
+#endif
+
+struct AudioTraceEvent {
+  std::atomic<uint32_t> sequence;  // Index of the event stored in the slot plus one; 0 while the slot is being written
+  int64_t start_us;
+  uint32_t duration_us;
+  uint32_t block_id;
+  uint32_t bytes;
+  uint32_t owner;  // Identifies the object that recorded the event, e.g., one of several decoders
+  AudioTraceStage stage;
+};
+
+class AudioTrace {
+  /*
+   * @brief Process-wide ring of timed audio processing events for finding where latency comes from.
+   * Each pipeline stage records how long it spent on a block of audio. The ring has a fixed size, and the newest events
+   * overwrite the oldest. Dumping logs the events as Chrome trace JSON (chrome://tracing, Perfetto), one event per line.
+   *   - Recording is lock free and never allocates, so it is safe in the audio tasks.
+   *   - Events being overwritten while dumping are skipped.
+   */
+ public:
+  /// @brief Returns the shared trace instance
+  static AudioTrace &get();
+
+  /// @brief Returns the current time in microseconds since boot
+  static int64_t now_us();
+
+  /// @brief Records an event that started at start_us and ends now
+  /// @param stage Pipeline stage that processed the block
+  /// @param owner Object that processed the block
+  /// @param block_id Index of the block in the owner's stream
+  /// @param start_us Time from now_us() when processing started
+  /// @param bytes Number of bytes processed
+  void record(AudioTraceStage stage, const void *owner, uint32_t block_id, int64_t start_us, uint32_t bytes);
+
+  /// @brief Logs the recorded events as Chrome trace JSON, oldest first
+  void dump();
+
+  /// @brief Discards the recorded events
+  void clear() { this->first_index_.store(this->next_index_.load(std::memory_order_acquire)); }
+
+ protected:
+  AudioTrace();
+
+  AudioTraceEvent *events_{nullptr};
+
+  std::atomic<uint32_t> next_index_{0};
+  std::atomic<uint32_t> first_index_{0};
+};
+
+class AudioTraceScope {
+  /*
+   * @brief Records an event for the duration of its scope.
+   * With a block counter, the event is only recorded if any bytes were processed, so idle polling isn't traced, and
+   * block ids count the recorded events per owner. Without one, e.g., for starting a stage, the event is always
+   * recorded as block 0.
+   */
+ public:
+  AudioTraceScope(AudioTraceStage stage, const void *owner, uint32_t *block_counter)
+      : stage_(stage), owner_(owner), block_counter_(block_counter), start_us_(AudioTrace::now_us()) {}
+  ~AudioTraceScope() {
+    if (this->block_counter_ == nullptr) {
+      AudioTrace::get().record(this->stage_, this->owner_, 0, this->start_us_, this->bytes_);
+    } else if (this->bytes_ > 0) {
+      AudioTrace::get().record(this->stage_, this->owner_, (*this->block_counter_)++, this->start_us_, this->bytes_);
+    }
+  }
+
+  void add_bytes(size_t bytes) { this->bytes_ += bytes; }
+
+ protected:
+  AudioTraceStage stage_;
+  const void *owner_;
+  uint32_t *block_counter_;
+  int64_t start_us_;
+  uint32_t bytes_{0};
+};
+
+// Traces the enclosing scope. Compiles to nothing unless tracing is enabled.
+#define AUDIO_TRACE_SCOPE(name, stage, owner, block_counter) \
+  ::esphome::audio::AudioTraceScope name(::esphome::audio::AudioTraceStage::stage, owner, block_counter)
+#define AUDIO_TRACE_START_SCOPE(name, stage, owner) \
+  ::esphome::audio::AudioTraceScope name(::esphome::audio::AudioTraceStage::stage, owner, nullptr)
+#define AUDIO_TRACE_ADD_BYTES(name, bytes) name.add_bytes(bytes)
+
+#else
+
+#define AUDIO_TRACE_SCOPE(name, stage, owner, block_counter)
+#define AUDIO_TRACE_START_SCOPE(name, stage, owner)
+#define AUDIO_TRACE_ADD_BYTES(name, bytes)
+
+#endif
+
+}  // namespace audio
+}  // namespace esphome
+
+#endif
@@ -2,8 +2,13 @@
 
 #ifdef USE_ESP32
 
+#include "audio_buffer_pool.h"
+
 #include "esphome/core/helpers.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace esphome {
 namespace audio {
 
@@ -86,10 +91,9 @@ bool AudioTransferBuffer::reallocate(size_t new_buffer_size) {
 bool AudioTransferBuffer::allocate_buffer_(size_t buffer_size) {
   this->buffer_size_ = buffer_size;
 
-  RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
-
-  this->buffer_ = allocator.allocate(this->buffer_size_);
+  this->buffer_ = AudioBufferPool::get().acquire(this->buffer_size_);
   if (this->buffer_ == nullptr) {
+    this->buffer_size_ = 0;
     return false;
   }
 
@@ -101,8 +105,7 @@ bool AudioTransferBuffer::allocate_buffer_(size_t buffer_size) {
 
 void AudioTransferBuffer::deallocate_buffer_() {
   if (this->buffer_ != nullptr) {
-    RAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
-    allocator.deallocate(this->buffer_, this->buffer_size_);
+    AudioBufferPool::get().release(this->buffer_, this->buffer_size_);
     this->buffer_ = nullptr;
     this->data_start_ = nullptr;
   }
@@ -132,6 +135,19 @@ size_t AudioSourceTransferBuffer::transfer_data_from_source(TickType_t ticks_to_
   return bytes_read;
 }
 
+size_t AudioSourceTransferBuffer::read_into(uint8_t *destination, size_t length, TickType_t ticks_to_wait) {
+  size_t bytes_read = std::min(length, this->available());
+  if (bytes_read > 0) {
+    memcpy(destination, this->data_start_, bytes_read);
+    this->decrease_buffer_length(bytes_read);
+  }
+
+  if ((bytes_read < length) && (this->ring_buffer_.use_count() > 0)) {
+    bytes_read += this->ring_buffer_->read((void *) (destination + bytes_read), length - bytes_read, ticks_to_wait);
+  }
+  return bytes_read;
+}
+
 size_t AudioSinkTransferBuffer::transfer_data_to_sink(TickType_t ticks_to_wait, bool post_shift) {
   size_t bytes_written = 0;
   if (this->available()) {
@@ -59,12 +59,13 @@ class AudioTransferBuffer {
   bool reallocate(size_t new_buffer_size);
 
  protected:
-  /// @brief Allocates the transfer buffer in external memory, if available.
+  /// @brief Gets the transfer buffer from the shared audio buffer pool. Pooled buffers are in external memory, if
+  /// available.
   /// @param buffer_size The number of bytes to allocate
   /// @return True is successful, false otherwise.
   bool allocate_buffer_(size_t buffer_size);
 
-  /// @brief Deallocates the buffer and resets the class variables.
+  /// @brief Returns the buffer to the shared audio buffer pool and resets the class variables.
   void deallocate_buffer_();
 
   // A possible source or sink for the transfer buffer
@@ -133,6 +134,14 @@ class AudioSourceTransferBuffer : public AudioTransferBuffer {
   /// @return Number of bytes read
   size_t transfer_data_from_source(TickType_t ticks_to_wait, bool pre_shift = true);
 
+  /// @brief Reads data into another buffer, bypassing the transfer buffer. Any data already in the transfer buffer is
+  /// copied out first, followed by data read directly from the source.
+  /// @param destination Pointer to the buffer to read into
+  /// @param length Maximum number of bytes to read
+  /// @param ticks_to_wait FreeRTOS ticks to block while waiting for the source to have enough data
+  /// @return Number of bytes read
+  size_t read_into(uint8_t *destination, size_t length, TickType_t ticks_to_wait);
+
   /// @brief Adds a ring buffer as the transfer buffer's source.
   /// @param ring_buffer weak_ptr to the allocated ring buffer
   void set_source(const std::weak_ptr<RingBuffer> &ring_buffer) { this->ring_buffer_ = ring_buffer.lock(); };
@@ -0,0 +1,27 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "audio_trace.h"
+
+#include "esphome/core/automation.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace audio {
+
+template<typename... Ts> class DumpTraceAction : public Action<Ts...> {
+ public:
+  void play(Ts... x) override {
+#ifdef USE_AUDIO_TRACE
+    AudioTrace::get().dump();
+#else
+    ESP_LOGW("audio.trace", "Tracing is disabled; set trace_events in the audio component to enable it");
+#endif
+  }
+};
+
+}  // namespace audio
+}  // namespace esphome
+
+#endif
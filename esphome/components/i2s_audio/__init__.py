@@ -155,37 +155,13 @@ def final_validate_device_schema(name: str) -> cv.Schema:
 
     return create_schema
 
-i2s_mode_t = cg.global_ns.enum("i2s_mode_t")
 I2S_MODE_OPTIONS = {
-    CONF_PRIMARY: i2s_mode_t.I2S_MODE_MASTER,  # NOLINT
-    CONF_SECONDARY: i2s_mode_t.I2S_MODE_SLAVE,  # NOLINT
+    CONF_PRIMARY: i2s.I2S_CLK_MODES[i2s.INTERNAL_CLK],  # NOLINT
+    CONF_SECONDARY: i2s.I2S_CLK_MODES[i2s.EXTERNAL_CLK],  # NOLINT
 }
 
-
-i2s_channel_fmt_t = cg.global_ns.enum("i2s_channel_fmt_t")
-I2S_CHANNELS = {
-    CONF_MONO: i2s_channel_fmt_t.I2S_CHANNEL_FMT_ALL_LEFT,
-    CONF_LEFT: i2s_channel_fmt_t.I2S_CHANNEL_FMT_ONLY_LEFT,
-    CONF_RIGHT: i2s_channel_fmt_t.I2S_CHANNEL_FMT_ONLY_RIGHT,
-    CONF_STEREO: i2s_channel_fmt_t.I2S_CHANNEL_FMT_RIGHT_LEFT,
-}
-
-i2s_bits_per_sample_t = cg.global_ns.enum("i2s_bits_per_sample_t")
-I2S_BITS_PER_SAMPLE = {
-    8: i2s_bits_per_sample_t.I2S_BITS_PER_SAMPLE_8BIT,
-    16: i2s_bits_per_sample_t.I2S_BITS_PER_SAMPLE_16BIT,
-    24: i2s_bits_per_sample_t.I2S_BITS_PER_SAMPLE_24BIT,
-    32: i2s_bits_per_sample_t.I2S_BITS_PER_SAMPLE_32BIT,
-}
-
-i2s_bits_per_chan_t = cg.global_ns.enum("i2s_bits_per_chan_t")
-I2S_BITS_PER_CHANNEL = {
-    "default": i2s_bits_per_chan_t.I2S_BITS_PER_CHAN_DEFAULT,
-    8: i2s_bits_per_chan_t.I2S_BITS_PER_CHAN_8BIT,
-    16: i2s_bits_per_chan_t.I2S_BITS_PER_CHAN_16BIT,
-    24: i2s_bits_per_chan_t.I2S_BITS_PER_CHAN_24BIT,
-    32: i2s_bits_per_chan_t.I2S_BITS_PER_CHAN_32BIT,
-}
+I2S_BITS_PER_SAMPLE = i2s.BITS_PER_SAMPLE
+I2S_BITS_PER_CHANNEL = i2s.BITS_PER_CHANNEL
 
 _validate_bits = cv.float_with_unit("bits", "bit")
 
@@ -202,7 +178,9 @@ def i2s_audio_component_schema(
         {
             cv.GenerateID(): cv.declare_id(class_),
             cv.GenerateID(CONF_I2S_AUDIO_ID): cv.use_id(I2SAudioComponent),
-            cv.Optional(CONF_CHANNEL, default=default_channel): cv.enum(I2S_CHANNELS),
+            cv.Optional(CONF_CHANNEL, default=default_channel): cv.one_of(
+                *i2s.CHANNELS, lower=True
+            ),
             cv.Optional(CONF_SAMPLE_RATE, default=default_sample_rate): cv.int_range(
                 min=1
             ),
@@ -223,9 +201,16 @@ def i2s_audio_component_schema(
 
 
 
-async def apply_i2s_settings(var, config) -> None:
+async def apply_i2s_settings(var, config, transmit: bool) -> None:
     cg.add(var.set_clk_mode(config[i2s.CONF_CLK_MODE]))
-    cg.add(var.set_channel(config[i2s.CONF_CHANNEL]))
+    if tdm_slots := config.get(i2s.CONF_TDM_SLOTS):
+        slot_mask = sum(1 << slot for slot in tdm_slots)
+        total_slots = config.get(i2s.CONF_TDM_TOTAL_SLOTS, 0)
+        cg.add(var.set_tdm_slots(slot_mask, total_slots))
+    else:
+        slot_mode, slot_mask = i2s.get_slot_format(config, transmit)
+        cg.add(var.set_slot_mode(slot_mode))
+        cg.add(var.set_std_slot_mask(slot_mask))
     cg.add(var.set_sample_rate(config[i2s.CONF_SAMPLE_RATE]))
     cg.add(var.set_bits_per_sample(config[i2s.CONF_BITS_PER_SAMPLE]))
     cg.add(var.set_use_apll(config[i2s.CONF_USE_APLL]))
@@ -236,7 +221,7 @@ async def register_i2s_writer(writer, config: dict) -> None:
     i2s_cntrl = await cg.get_variable(config[CONF_I2S_AUDIO_ID])
     await cg.register_parented(writer, config[CONF_I2S_AUDIO_ID])
     cg.add(i2s_cntrl.set_audio_out(writer))
-    await apply_i2s_settings(writer, config)
+    await apply_i2s_settings(writer, config, transmit=True)
 
     if CONF_I2S_DOUT_PIN in config:
         cg.add(writer.set_dout_pin(config[CONF_I2S_DOUT_PIN]))
@@ -248,7 +233,7 @@ async def register_i2s_reader(reader, config: dict) -> None:
     await cg.register_parented(reader, config[CONF_I2S_AUDIO_ID])
     cg.add(i2s_cntrl.set_audio_in(reader))
 
-    await apply_i2s_settings(reader, config)
+    await apply_i2s_settings(reader, config, transmit=False)
     cg.add(reader.set_pdm(config[CONF_PDM]))
 
     if CONF_I2S_DIN_PIN in config:
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace esphome {
+namespace i2s_audio {
+
+class I2SAccess {
+public:
+   static constexpr uint8_t FREE = 0;
+   static constexpr uint8_t RX   = 1;
+   static constexpr uint8_t TX   = 2;
+};
+
+class I2SAccessState {
+  /*
+   * @brief Lock-free claims on an I2S port. The reader's and writer's claim counts share one atomic word, so a claim
+   * sees both sides at once and exclusive access can't be granted to both.
+   *   - In duplex mode, either side can always claim.
+   *   - In exclusive mode, a side can only claim while the other side has no claims.
+   * Every successful claim must be matched by one release. Doesn't depend on ESP-IDF, so it can be tested on the host.
+   */
+ public:
+  /// @brief Adds a claim for access
+  /// @param access I2SAccess::RX or I2SAccess::TX
+  /// @param exclusive If true, fails while the other side holds a claim
+  /// @return True if the claim was added
+  bool claim(uint8_t access, bool exclusive) {
+    const uint32_t own_mask = COUNT_MASK << shift_(access);
+    uint32_t state = this->state_.load(std::memory_order_relaxed);
+    uint32_t desired;
+    do {
+      if( exclusive && (state & ~own_mask) != 0 ){
+        return false;
+      }
+      if( count_(state, access) == COUNT_MASK ){
+        return false;
+      }
+      desired = state + (1u << shift_(access));
+    } while( !this->state_.compare_exchange_weak(state, desired, std::memory_order_acq_rel, std::memory_order_relaxed) );
+    return true;
+  }
+
+  /// @brief Removes a claim for access
+  /// @return False if access held no claims
+  bool release(uint8_t access) {
+    uint32_t state = this->state_.load(std::memory_order_relaxed);
+    uint32_t desired;
+    do {
+      if( count_(state, access) == 0 ){
+        return false;
+      }
+      desired = state - (1u << shift_(access));
+    } while( !this->state_.compare_exchange_weak(state, desired, std::memory_order_acq_rel, std::memory_order_relaxed) );
+    return true;
+  }
+
+  uint32_t count(uint8_t access) const { return count_(this->state_.load(std::memory_order_acquire), access); }
+  bool is_claimed(uint8_t access) const { return this->count(access) > 0; }
+  bool is_claimed_by_other(uint8_t access) const {
+    return this->count(access == I2SAccess::RX ? I2SAccess::TX : I2SAccess::RX) > 0;
+  }
+
+ protected:
+  static constexpr uint32_t COUNT_MASK = 0xFFFF;
+  static constexpr uint32_t shift_(uint8_t access) { return access == I2SAccess::RX ? 0 : 16; }
+  static constexpr uint32_t count_(uint32_t state, uint8_t access) { return (state >> shift_(access)) & COUNT_MASK; }
+
+  std::atomic<uint32_t> state_{0};
+};
+
+}  // namespace i2s_audio
+}  // namespace esphome
@@ -2,6 +2,7 @@
 
 #ifdef USE_ESP32
 
+#include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 
 namespace esphome {
@@ -9,12 +10,12 @@ namespace i2s_audio {
 
   static const char *const TAG = "i2s_audio";
 
-#if defined(USE_ESP_IDF) && (ESP_IDF_VERSION_MAJOR >= 5)
 static const uint8_t I2S_NUM_MAX = SOC_I2S_NUM;  // because IDF 5+ took this away :(
-#endif
 
-static const size_t DMA_BUFFERS_COUNT = 4;
-static const size_t I2S_EVENT_QUEUE_COUNT = DMA_BUFFERS_COUNT + 1;
+enum I2SEventType : uint8_t {
+  I2S_EVENT_TX_DONE,       // A TX DMA buffer finished sending
+  I2S_EVENT_TX_UNDERFLOW,  // The TX DMA ran out of audio and sent silence
+};
 
 
 void I2SAudioComponent::setup() {
@@ -29,6 +30,16 @@ void I2SAudioComponent::setup() {
   this->port_ = next_port_num;
   next_port_num = (i2s_port_t) (next_port_num + 1);
 
+  if( this->audio_out_ != nullptr ){
+    // One event per DMA buffer, plus one for an underflow
+    this->i2s_event_queue_ = xQueueCreate(this->audio_out_->get_dma_desc_num() + 1, sizeof(I2SEventType));
+    if( this->i2s_event_queue_ == nullptr ){
+      ESP_LOGE(TAG, "Failed to create the I2S event queue");
+      this->mark_failed();
+      return;
+    }
+  }
+
   ESP_LOGCONFIG(TAG, "Setting up I2S Audio...");
 }
 
@@ -46,66 +57,120 @@ void I2SAudioComponent::dump_config(){
 
 
 bool I2SAudioComponent::claim_access_(uint8_t access){
-  bool success = false;
-  this->lock();
-  if( this->access_mode_ == I2SAccessMode::DUPLEX ){
-    this->access_state_ |= access;
-    success = true;
+  return this->access_state_.claim(access, this->access_mode_ == I2SAccessMode::EXCLUSIVE);
+}
+
+bool I2SAudioComponent::release_access_(uint8_t access){
+  if( !this->access_state_.release(access) ){
+    esph_log_w(TAG, "%s released access it didn't claim", access == I2SAccess::RX ? "Reader" : "Writer");
+    return false;
   }
-  else {
-    if( this->access_state_ == I2SAccess::FREE ){
-      this->access_state_ = access;
+  return true;
+}
+
+bool I2SAudioComponent::create_channels_(uint32_t sample_rate, uint8_t access){
+  const bool duplex = this->access_mode_ == I2SAccessMode::DUPLEX;
+  const bool create_tx = this->audio_out_ != nullptr && (duplex || access == I2SAccess::TX);
+  const bool create_rx = this->audio_in_ != nullptr && (duplex || access == I2SAccess::RX);
+
+  // Channels allocated together share one config, so the writer's DMA buffers keep the timing its task expects
+  const I2SSettings *settings = create_tx ? static_cast<const I2SSettings *>(this->audio_out_)
+                                          : static_cast<const I2SSettings *>(this->audio_in_);
+  if( settings == nullptr ){
+    return false;
+  }
+  const i2s_chan_config_t chan_cfg = settings->get_chan_cfg(this->get_port());
+  esp_err_t err = i2s_new_channel(&chan_cfg, create_tx ? &this->tx_handle_ : nullptr,
+                                  create_rx ? &this->rx_handle_ : nullptr);
+  if( err != ESP_OK ){
+    esph_log_e(TAG, "Couldn't allocate the channels: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  if( this->tx_handle_ != nullptr ){
+    i2s_std_gpio_config_t gpio_cfg = this->get_gpio_config();
+    gpio_cfg.dout = (gpio_num_t) this->audio_out_->get_dout_pin();
+    err = this->audio_out_->init_channel(this->tx_handle_, gpio_cfg, sample_rate);
+    if( err == ESP_OK ){
+      i2s_event_callbacks_t callbacks = {};
+      callbacks.on_sent = I2SAudioComponent::on_tx_sent_;
+      callbacks.on_send_q_ovf = I2SAudioComponent::on_tx_underflow_;
+      err = i2s_channel_register_event_callback(this->tx_handle_, &callbacks, this);
     }
-    success = this->access_state_ & access;
   }
-  this->unlock();
-  return success;
-}
+  if( err == ESP_OK && this->rx_handle_ != nullptr ){
+    i2s_std_gpio_config_t gpio_cfg = this->get_gpio_config();
+    gpio_cfg.din = (gpio_num_t) this->audio_in_->get_din_pin();
+    err = this->audio_in_->init_channel(this->rx_handle_, gpio_cfg, sample_rate);
+  }
+  if( err != ESP_OK ){
+    esph_log_e(TAG, "Couldn't initialize the channels: %s", esp_err_to_name(err));
+    this->delete_channels_();
+    return false;
+  }
 
-bool I2SAudioComponent::release_access_(uint8_t access){
-  this->lock();
-  this->access_state_ = this->access_state_ & (~access);
-  this->unlock();
+  this->installed_sample_rate_ = sample_rate;
+  this->rx_dma_frame_num_ = chan_cfg.dma_frame_num;
+  this->reset_frame_clock_();
   return true;
 }
 
-bool I2SAudioComponent::install_i2s_driver_(i2s_driver_config_t i2s_cfg, uint8_t access){
+void I2SAudioComponent::delete_channels_(){
+  if( this->tx_handle_ != nullptr ){
+    i2s_del_channel(this->tx_handle_);
+    this->tx_handle_ = nullptr;
+  }
+  if( this->rx_handle_ != nullptr ){
+    i2s_del_channel(this->rx_handle_);
+    this->rx_handle_ = nullptr;
+  }
+  this->enabled_channels_ = I2SAccess::FREE;
+  if( this->i2s_event_queue_ != nullptr ){
+    xQueueReset(this->i2s_event_queue_);
+  }
+}
+
+bool I2SAudioComponent::install_i2s_driver_(uint32_t sample_rate, uint8_t access){
   bool success = false;
   this->lock();
   esph_log_d(TAG, "Install driver requested by %s", access == I2SAccess::RX ? "Reader" : "Writer");
-  if( this->access_state_ == I2SAccess::FREE || this->access_state_ == access ){
-    if( this->driver_loaded_ ){
-      ESP_LOGW(TAG,"trying to load i2s driver twice");
-      return true;
-    }
-    if(this->access_mode_ == I2SAccessMode::DUPLEX){
-      i2s_cfg.mode = (i2s_mode_t) (i2s_cfg.mode | I2S_MODE_TX | I2S_MODE_RX);
+  const I2SSettings *settings = access == I2SAccess::RX ? static_cast<const I2SSettings *>(this->audio_in_)
+                                                        : static_cast<const I2SSettings *>(this->audio_out_);
+  i2s_chan_handle_t handle = access == I2SAccess::RX ? this->rx_handle_ : this->tx_handle_;
+  if( settings == nullptr || !this->access_state_.is_claimed(access) ){
+    ESP_LOGE(TAG, "Unexpected i2s state: mode: %d rx_claims: %u tx_claims: %u access_request: %d", (int) this->access_mode_,
+             (unsigned) this->access_state_.count(I2SAccess::RX), (unsigned) this->access_state_.count(I2SAccess::TX), (int) access);
+  } else if( this->enabled_channels_ & access ){
+    ESP_LOGW(TAG, "trying to load i2s driver twice");
+    success = true;
+  } else {
+    if( handle == nullptr && this->tx_handle_ == nullptr && this->rx_handle_ == nullptr ){
+      success = this->create_channels_(sample_rate, access);
+    } else if( handle != nullptr ){
+      // Allocated along with the other side's channel, so it has to run on the same clock
+      success = this->validate_cfg_for_duplex_(sample_rate);
+      if (!success ){
+        ESP_LOGE(TAG, "incompatible i2s settings for duplex mode, sample rate: %u installed: %u", (unsigned) sample_rate,
+                 (unsigned) this->installed_sample_rate_);
+      }
+    } else {
+      ESP_LOGE(TAG, "Unexpected i2s state: mode: %d rx_claims: %u tx_claims: %u access_request: %d", (int) this->access_mode_,
+               (unsigned) this->access_state_.count(I2SAccess::RX), (unsigned) this->access_state_.count(I2SAccess::TX), (int) access);
     }
-    success = ESP_OK == i2s_driver_install(this->get_port(), &i2s_cfg, I2S_EVENT_QUEUE_COUNT, &this->i2s_event_queue_);
-    esph_log_d(TAG, "Installing driver : %s", success ? "yes" : "no" );
-    i2s_pin_config_t pin_config = this->get_pin_config();
+
     if( success ){
-      this->driver_loaded_ = true;
-      if( this->audio_in_ != nullptr )
-      {
-        pin_config.data_in_num = this->audio_in_->get_din_pin();
-      }
-      if( this->audio_out_ != nullptr )
-      {
-        pin_config.data_out_num = this->audio_out_->get_dout_pin();
-      }
-      success &= ESP_OK == i2s_set_pin(this->get_port(), &pin_config);
+      handle = access == I2SAccess::RX ? this->rx_handle_ : this->tx_handle_;
+      success = ESP_OK == i2s_channel_enable(handle);
+      esph_log_d(TAG, "Installing driver : %s", success ? "yes" : "no" );
       if( success ){
-        this->installed_cfg_ = i2s_cfg;
+        this->enabled_channels_ |= access;
+        if( access == I2SAccess::RX ){
+          this->start_rx_frames_();
+        }
+      } else if( this->enabled_channels_ == I2SAccess::FREE ){
+        this->delete_channels_();
       }
     }
-  } else if (this->access_mode_ == I2SAccessMode::DUPLEX && this->driver_loaded_ ){
-    success = this->validate_cfg_for_duplex_(i2s_cfg);
-    if (!success ){
-      ESP_LOGE(TAG, "incompatible i2s settings for duplex mode, access_state: %d", this->access_state_);
-    }
-  } else {
-    ESP_LOGE(TAG, "Unexpected i2s state: mode: %d access_state: %d access_request: %d", (int) this->access_mode_, (int) this->access_state_, (int) access);
   }
   this->unlock();
   return success;
@@ -114,44 +179,151 @@ bool I2SAudioComponent::install_i2s_driver_(i2s_driver_config_t i2s_cfg, uint8_t
 bool I2SAudioComponent::uninstall_i2s_driver_(uint8_t access){
   bool success = false;
   this->lock();
-  // check that i2s is not occupied by others
-  if( (this->access_state_ & access) == access && (this->access_state_ & ~access) == 0 ){
-    i2s_zero_dma_buffer(this->get_port());
-    esp_err_t err = i2s_driver_uninstall(this->get_port());
-    if (err == ESP_OK) {
-      success = true;
-      this->access_state_ = I2SAccess::FREE;
-      this->driver_loaded_ = false;
-    } else {
-      esph_log_e(TAG, "Couldn't unload driver");
+  i2s_chan_handle_t handle = access == I2SAccess::RX ? this->rx_handle_ : this->tx_handle_;
+  if( handle != nullptr && (this->enabled_channels_ & access) ){
+    success = ESP_OK == i2s_channel_disable(handle);
+    if( !success ){
+      esph_log_e(TAG, "Couldn't stop channel");
     }
+    this->enabled_channels_ &= ~access;
   }
-  else {
-    // other component hasn't released yet
-    // don't uninstall driver, just release caller
+  if( this->enabled_channels_ == I2SAccess::FREE ){
+    this->delete_channels_();
+  } else {
+    // other component hasn't released yet, keep its channel running
     esph_log_d(TAG, "Other component hasn't released");
-    this->access_state_ = this->access_state_ & (~access);
   }
   this->unlock();
   return success;
 }
 
-void I2SAudioComponent::process_i2s_events(bool &tx_dma_underflow){
-  i2s_event_t i2s_event;
-      while (xQueueReceive(this->i2s_event_queue_, &i2s_event, 0)) {
-        if (i2s_event.type == I2S_EVENT_TX_Q_OVF) {
-          tx_dma_underflow = true;
-        }
-      }
+bool I2SAudioComponent::reconfigure_i2s_clock_(uint32_t sample_rate, uint8_t access){
+  bool success = false;
+  this->lock();
+  const I2SSettings *settings = access == I2SAccess::RX ? static_cast<const I2SSettings *>(this->audio_in_)
+                                                        : static_cast<const I2SSettings *>(this->audio_out_);
+  i2s_chan_handle_t handle = access == I2SAccess::RX ? this->rx_handle_ : this->tx_handle_;
+  if( handle == nullptr || (this->enabled_channels_ & access) != access ){
+    esph_log_e(TAG, "Can't reconfigure the clock without an installed driver");
+  }
+  else if( this->installed_sample_rate_ == sample_rate ){
+    success = true;
+  }
+  else if( this->access_state_.is_claimed_by_other(access) ){
+    // The other side is streaming on the same clock, e.g., the microphone in duplex mode
+    esph_log_d(TAG, "Other component is using the clock, not reconfiguring");
+  }
+  else {
+    // The clock can only change while the channel is stopped, which drops the audio queued in its DMA buffers
+    esp_err_t err = i2s_channel_disable(handle);
+    if( err == ESP_OK ){
+      success = ESP_OK == settings->reconfig_clock(handle, sample_rate);
+      err = i2s_channel_enable(handle);
+    }
+    success &= err == ESP_OK;
+    esph_log_d(TAG, "Reconfiguring clock to %u Hz : %s", (unsigned) sample_rate, success ? "yes" : "no" );
+    if( success ){
+      // Continue the frame count from the moment the clock changed
+      const uint32_t now = micros();
+      const uint32_t frame = this->frame_at(now);
+      LockGuard guard(this->frame_clock_lock_);
+      this->installed_sample_rate_ = sample_rate;
+      this->anchor_frame_ = frame;
+      this->anchor_us_ = now;
+    }
+  }
+  this->unlock();
+  return success;
+}
+
+/// Queues an event for process_i2s_events. If the task fell behind, the oldest event is dropped for the newest.
+static bool IRAM_ATTR queue_i2s_event_from_isr(QueueHandle_t queue, I2SEventType event){
+  BaseType_t need_yield = pdFALSE;
+  if( queue == nullptr ){
+    return false;
+  }
+  if( xQueueIsQueueFullFromISR(queue) ){
+    I2SEventType dropped;
+    xQueueReceiveFromISR(queue, &dropped, &need_yield);
+  }
+  xQueueSendFromISR(queue, &event, &need_yield);
+  return need_yield == pdTRUE;
+}
+
+bool IRAM_ATTR I2SAudioComponent::on_tx_sent_(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx){
+  I2SAudioComponent *this_component = static_cast<I2SAudioComponent *>(user_ctx);
+  return queue_i2s_event_from_isr(this_component->i2s_event_queue_, I2S_EVENT_TX_DONE);
+}
+
+bool IRAM_ATTR I2SAudioComponent::on_tx_underflow_(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx){
+  I2SAudioComponent *this_component = static_cast<I2SAudioComponent *>(user_ctx);
+  return queue_i2s_event_from_isr(this_component->i2s_event_queue_, I2S_EVENT_TX_UNDERFLOW);
+}
+
+uint32_t I2SAudioComponent::process_i2s_events(bool &tx_dma_underflow, TickType_t ticks_to_wait){
+  uint32_t tx_buffers_sent = 0;
+  if( this->i2s_event_queue_ == nullptr ){
+    return 0;
+  }
+  I2SEventType i2s_event;
+  while( xQueueReceive(this->i2s_event_queue_, &i2s_event, ticks_to_wait) ){
+    if( i2s_event == I2S_EVENT_TX_UNDERFLOW ){
+      tx_dma_underflow = true;
+    } else if( i2s_event == I2S_EVENT_TX_DONE ){
+      ++tx_buffers_sent;
+    }
+    // Only wait for the first event
+    ticks_to_wait = 0;
+  }
+  return tx_buffers_sent;
+}
+
+
+void I2SAudioComponent::reset_frame_clock_(){
+  LockGuard guard(this->frame_clock_lock_);
+  this->rx_start_frame_ = 0;
+  this->rx_frames_ = 0;
+  this->anchor_frame_ = 0;
+  this->anchor_us_ = micros();
 }
 
+void I2SAudioComponent::start_rx_frames_(){
+  const uint32_t now = micros();
+  const uint32_t frame = this->frame_at(now);
+  LockGuard guard(this->frame_clock_lock_);
+  this->rx_start_frame_ = frame;
+  this->rx_frames_ = frame;
+  this->anchor_frame_ = frame;
+  this->anchor_us_ = now;
+}
 
-bool I2SAudioComponent::validate_cfg_for_duplex_(i2s_driver_config_t& i2s_cfg){
-  i2s_driver_config_t& installed = this->installed_cfg_;
-  return (
-         installed.sample_rate == i2s_cfg.sample_rate
-     &&  installed.bits_per_chan == i2s_cfg.bits_per_chan
-  );
+uint32_t I2SAudioComponent::frame_at(uint32_t time_us){
+  LockGuard guard(this->frame_clock_lock_);
+  const int32_t elapsed_us = (int32_t) (time_us - this->anchor_us_);
+  return this->anchor_frame_ + (int32_t) ((int64_t) elapsed_us * this->installed_sample_rate_ / 1000000);
+}
+
+uint32_t I2SAudioComponent::advance_rx_frames_(uint32_t frames, uint32_t read_start_us){
+  const uint32_t now = micros();
+  LockGuard guard(this->frame_clock_lock_);
+  const uint32_t first_frame = this->rx_frames_;
+  this->rx_frames_ += frames;
+
+  // A read that waited returned as soon as the DMA buffer holding its last frame completed. Buffers complete at
+  // multiples of the buffer length from the first captured frame, so that boundary was on the bus just now.
+  const uint32_t dma_buf_len = this->rx_dma_frame_num_;
+  const uint32_t dma_buffer_us = (uint64_t) dma_buf_len * 1000000 / this->installed_sample_rate_;
+  if( (dma_buf_len > 0) && (now - read_start_us) > dma_buffer_us / 4 ){
+    const uint32_t captured = this->rx_frames_ - this->rx_start_frame_;
+    this->anchor_frame_ = this->rx_start_frame_ + (captured + dma_buf_len - 1) / dma_buf_len * dma_buf_len;
+    this->anchor_us_ = now;
+  }
+  return first_frame;
+}
+
+bool I2SAudioComponent::validate_cfg_for_duplex_(uint32_t sample_rate){
+  // Both channels were initialized with the installed sample rate, so only the side's own rate needs checking
+  return this->installed_sample_rate_ == sample_rate;
 }
 
 
@@ -163,45 +335,115 @@ void I2SSettings::dump_i2s_settings() const {
   else{
     esph_log_config(TAG, "I2S-Writer (%s):", init_str.c_str());
   }
-  esph_log_config(TAG, "  clk_mode: %s", this->i2s_clk_mode_ == I2S_MODE_MASTER ? "internal" : "external"  );
+  esph_log_config(TAG, "  clk_mode: %s", this->i2s_role_ == I2S_ROLE_MASTER ? "internal" : "external"  );
   esph_log_config(TAG, "  sample-rate: %d bits_per_sample: %d", this->sample_rate_, this->bits_per_sample_ );
-  esph_log_config(TAG, "  channel_fmt: %d channels: %d", this->channel_fmt_, this->num_of_channels() );
+  if( this->is_tdm() ){
+    esph_log_config(TAG, "  tdm_slot_mask: 0x%04x channels: %d", (unsigned) this->tdm_slot_mask_, this->num_of_channels() );
+  } else {
+    esph_log_config(TAG, "  slot_mask: %d channels: %d", this->std_slot_mask_, this->num_of_channels() );
+  }
+  esph_log_config(TAG, "  dma_buffers: %u x %u frames", (unsigned) this->dma_desc_num_, (unsigned) this->dma_frame_num_);
   esph_log_config(TAG, "  use_apll: %s, use_pdm: %s", this->use_apll_ ? "yes": "no", this->pdm_ ? "yes": "no");
 }
 
 
-i2s_driver_config_t I2SSettings::get_i2s_cfg() const {
-  uint8_t mode = this->i2s_clk_mode_ | ( this->i2s_access_ == I2SAccess::RX ? I2S_MODE_RX : I2S_MODE_TX);
-
-  if( this->pdm_){
-      mode = (i2s_mode_t) (mode | I2S_MODE_PDM);
+i2s_clock_src_t I2SSettings::get_clk_src_() const {
+#if SOC_I2S_SUPPORTS_APLL
+  if( this->use_apll_ ){
+    return I2S_CLK_SRC_APLL;
   }
+#endif
+  return I2S_CLK_SRC_DEFAULT;
+}
 
-  i2s_driver_config_t config = {
-      .mode = (i2s_mode_t) mode,
-      .sample_rate = this->sample_rate_,
-      .bits_per_sample = this->bits_per_sample_,
-      .channel_format = this->channel_fmt_,
-      .communication_format = I2S_COMM_FORMAT_STAND_I2S,
-      .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-      .dma_buf_count = DMA_BUFFERS_COUNT,
-      .dma_buf_len = 240,
-      .use_apll = false,
-      .tx_desc_auto_clear = true,
-      .fixed_mclk = I2S_PIN_NO_CHANGE,
-      .mclk_multiple = I2S_MCLK_MULTIPLE_256,
-      .bits_per_chan = I2S_BITS_PER_CHAN_DEFAULT,
+i2s_chan_config_t I2SSettings::get_chan_cfg(i2s_port_t port) const {
+  i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(port, this->i2s_role_);
+  chan_cfg.dma_desc_num = this->dma_desc_num_;
+  chan_cfg.dma_frame_num = this->dma_frame_num_;
+  // Send silence rather than repeating stale buffers if the writer runs out of audio
+  chan_cfg.auto_clear = true;
+  return chan_cfg;
+}
+
+esp_err_t I2SSettings::init_channel(i2s_chan_handle_t handle, i2s_std_gpio_config_t gpio_cfg,
+                                    uint32_t sample_rate) const {
+#if SOC_I2S_SUPPORTS_PDM_RX
+  if( this->pdm_ ){
+    i2s_pdm_rx_config_t pdm_cfg = {
+        .clk_cfg = I2S_PDM_RX_CLK_DEFAULT_CONFIG(sample_rate),
+        .slot_cfg = I2S_PDM_RX_SLOT_DEFAULT_CONFIG(this->bits_per_sample_, this->slot_mode_),
+        .gpio_cfg = {
+            .clk = gpio_cfg.ws,
+            .din = gpio_cfg.din,
+            .invert_flags = {
+                .clk_inv = false,
+            },
+        },
+    };
+    pdm_cfg.clk_cfg.clk_src = this->get_clk_src_();
+    pdm_cfg.slot_cfg.slot_bit_width = this->bits_per_channel_;
+    if( this->std_slot_mask_ == I2S_STD_SLOT_LEFT ){
+      pdm_cfg.slot_cfg.slot_mask = I2S_PDM_SLOT_LEFT;
+    } else if( this->std_slot_mask_ == I2S_STD_SLOT_RIGHT ){
+      pdm_cfg.slot_cfg.slot_mask = I2S_PDM_SLOT_RIGHT;
+    }
+    return i2s_channel_init_pdm_rx_mode(handle, &pdm_cfg);
+  }
+#endif
 #if SOC_I2S_SUPPORTS_TDM
-      .chan_mask = I2S_CHANNEL_MONO,
-      .total_chan = 0,
-      .left_align = false,
-      .big_edin = false,
-      .bit_order_msb = false,
-      .skip_msk = false,
+  if( this->is_tdm() ){
+    i2s_tdm_config_t tdm_cfg = {
+        .clk_cfg = I2S_TDM_CLK_DEFAULT_CONFIG(sample_rate),
+        .slot_cfg = I2S_TDM_PHILIPS_SLOT_DEFAULT_CONFIG(this->bits_per_sample_, I2S_SLOT_MODE_STEREO,
+                                                        (i2s_tdm_slot_mask_t) this->tdm_slot_mask_),
+        .gpio_cfg = {
+            .mclk = gpio_cfg.mclk,
+            .bclk = gpio_cfg.bclk,
+            .ws = gpio_cfg.ws,
+            .dout = gpio_cfg.dout,
+            .din = gpio_cfg.din,
+            .invert_flags = {
+                .mclk_inv = false,
+                .bclk_inv = false,
+                .ws_inv = false,
+            },
+        },
+    };
+    tdm_cfg.clk_cfg.clk_src = this->get_clk_src_();
+    tdm_cfg.slot_cfg.slot_bit_width = this->bits_per_channel_;
+    tdm_cfg.slot_cfg.total_slot = this->tdm_total_slots_;
+    return i2s_channel_init_tdm_mode(handle, &tdm_cfg);
+  }
 #endif
+  i2s_std_config_t std_cfg = {
+      .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sample_rate),
+      .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(this->bits_per_sample_, this->slot_mode_),
+      .gpio_cfg = gpio_cfg,
   };
+  std_cfg.clk_cfg.clk_src = this->get_clk_src_();
+  std_cfg.slot_cfg.slot_bit_width = this->bits_per_channel_;
+  std_cfg.slot_cfg.slot_mask = this->std_slot_mask_;
+  return i2s_channel_init_std_mode(handle, &std_cfg);
+}
 
-  return config;
+esp_err_t I2SSettings::reconfig_clock(i2s_chan_handle_t handle, uint32_t sample_rate) const {
+#if SOC_I2S_SUPPORTS_PDM_RX
+  if( this->pdm_ ){
+    i2s_pdm_rx_clk_config_t clk_cfg = I2S_PDM_RX_CLK_DEFAULT_CONFIG(sample_rate);
+    clk_cfg.clk_src = this->get_clk_src_();
+    return i2s_channel_reconfig_pdm_rx_clock(handle, &clk_cfg);
+  }
+#endif
+#if SOC_I2S_SUPPORTS_TDM
+  if( this->is_tdm() ){
+    i2s_tdm_clk_config_t clk_cfg = I2S_TDM_CLK_DEFAULT_CONFIG(sample_rate);
+    clk_cfg.clk_src = this->get_clk_src_();
+    return i2s_channel_reconfig_tdm_clock(handle, &clk_cfg);
+  }
+#endif
+  i2s_std_clk_config_t clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sample_rate);
+  clk_cfg.clk_src = this->get_clk_src_();
+  return i2s_channel_reconfig_std_clock(handle, &clk_cfg);
 }
 
 }  // namespace i2s_audio
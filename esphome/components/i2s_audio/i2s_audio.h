@@ -3,22 +3,24 @@
 #include "esphome/core/defines.h"
 #ifdef USE_ESP32
 
-#include <driver/i2s.h>
+#include <driver/i2s_std.h>
+#if SOC_I2S_SUPPORTS_TDM
+#include <driver/i2s_tdm.h>
+#endif
+#if SOC_I2S_SUPPORTS_PDM_RX
+#include <driver/i2s_pdm.h>
+#endif
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include "esphome/core/component.h"
 #include "esphome/core/helpers.h"
 
+#include "i2s_access_state.h"
+
 namespace esphome {
 namespace i2s_audio {
 
 enum class I2SAccessMode  : uint8_t {EXCLUSIVE, DUPLEX};
-class I2SAccess {
-public:
-   static constexpr uint8_t FREE = 0;
-   static constexpr uint8_t RX   = 1;
-   static constexpr uint8_t TX   = 2;
-};
-
-
 class I2SReader;
 class I2SWriter;
 class I2SAudioComponent : public Component {
@@ -26,13 +28,18 @@ class I2SAudioComponent : public Component {
   void setup() override;
   void dump_config() override;
 
-  i2s_pin_config_t get_pin_config() const {
+  i2s_std_gpio_config_t get_gpio_config() const {
     return {
-        .mck_io_num = this->mclk_pin_,
-        .bck_io_num = this->bclk_pin_,
-        .ws_io_num = this->lrclk_pin_,
-        .data_out_num = I2S_PIN_NO_CHANGE,
-        .data_in_num = I2S_PIN_NO_CHANGE,
+        .mclk = (gpio_num_t) this->mclk_pin_,
+        .bclk = (gpio_num_t) this->bclk_pin_,
+        .ws = (gpio_num_t) this->lrclk_pin_,
+        .dout = I2S_GPIO_UNUSED,
+        .din = I2S_GPIO_UNUSED,
+        .invert_flags = {
+            .mclk_inv = false,
+            .bclk_inv = false,
+            .ws_inv = false,
+        },
     };
   }
 
@@ -45,38 +52,82 @@ class I2SAudioComponent : public Component {
   void unlock() { this->lock_.unlock(); }
 
   i2s_port_t get_port() const { return this->port_; }
+  /// @brief Channel handles, only valid while the driver is installed for that direction
+  i2s_chan_handle_t get_tx_handle() const { return this->tx_handle_; }
+  i2s_chan_handle_t get_rx_handle() const { return this->rx_handle_; }
   void set_audio_in(I2SReader* comp_in){ this->audio_in_ = comp_in;}
   void set_audio_out(I2SWriter* comp_out){ this->audio_out_ = comp_out;}
 
   void set_access_mode(I2SAccessMode access_mode){this->access_mode_ = access_mode;}
   bool is_exclusive(){return this->access_mode_ == I2SAccessMode::EXCLUSIVE;}
 
-  void process_i2s_events(bool &tx_dma_underflow);
+  /// @brief Drains the I2S event queue.
+  /// @param tx_dma_underflow Set to true if the TX DMA ran out of audio and sent silence
+  /// @param ticks_to_wait FreeRTOS ticks to wait for the first event if the queue is empty
+  /// @return Number of TX DMA buffers that finished sending
+  uint32_t process_i2s_events(bool &tx_dma_underflow, TickType_t ticks_to_wait = 0);
+
+  /// @brief Returns the bus frame being played and captured at time_us. Frame 0 is the first frame after the driver was
+  /// installed. In duplex mode, the reader and writer share the bus clock, so the same frame number marks the same
+  /// instant in the microphone's capture and the speaker's output. While a reader is running, the clock is anchored to
+  /// its DMA buffer completions, so it follows the bus clock rather than the CPU's.
+  /// @param time_us Time from micros()
+  uint32_t frame_at(uint32_t time_us);
 
  protected:
   friend I2SReader;
   friend I2SWriter;
 
+  /// @brief Advances the count of frames read by count, re-anchoring the frame clock if the read waited for the DMA.
+  /// @param frames Number of frames read
+  /// @param read_start_us Time from micros() when the read started
+  /// @return Bus frame of the first frame read
+  uint32_t advance_rx_frames_(uint32_t frames, uint32_t read_start_us);
+  void reset_frame_clock_();
+  /// @brief Starts counting captured frames at the current bus frame, as the RX channel may start after the TX one
+  void start_rx_frames_();
+
+  /// @brief TX channel ISR callbacks, queue the events for process_i2s_events
+  static bool on_tx_sent_(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
+  static bool on_tx_underflow_(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
+
+  // Serializes allocating, starting, and stopping the channels. Claiming and releasing access doesn't take it.
   Mutex lock_;
   I2SAccessMode access_mode_{I2SAccessMode::DUPLEX};
-  uint8_t access_state_{I2SAccess::FREE};
+  I2SAccessState access_state_;
 
   bool claim_access_(uint8_t access);
   bool release_access_(uint8_t access);
-  bool install_i2s_driver_(i2s_driver_config_t i2s_cfg, uint8_t access);
+  bool install_i2s_driver_(uint32_t sample_rate, uint8_t access);
   bool uninstall_i2s_driver_(uint8_t access);
-  bool validate_cfg_for_duplex_(i2s_driver_config_t& i2s_cfg);
+  bool reconfigure_i2s_clock_(uint32_t sample_rate, uint8_t access);
+  bool validate_cfg_for_duplex_(uint32_t sample_rate);
+  /// @brief Allocates and initializes the channels. In duplex mode, both directions are allocated together, so they
+  /// share the bus clock, and each side enables its own channel when it installs the driver.
+  bool create_channels_(uint32_t sample_rate, uint8_t access);
+  void delete_channels_();
 
   I2SReader *audio_in_{nullptr};
   I2SWriter *audio_out_{nullptr};
 
-  int mclk_pin_{I2S_PIN_NO_CHANGE};
-  int bclk_pin_{I2S_PIN_NO_CHANGE};
+  int mclk_pin_{I2S_GPIO_UNUSED};
+  int bclk_pin_{I2S_GPIO_UNUSED};
   int lrclk_pin_;
   i2s_port_t port_{};
-  i2s_driver_config_t installed_cfg_{};
-  QueueHandle_t i2s_event_queue_;
-  bool driver_loaded_{false};
+  i2s_chan_handle_t tx_handle_{nullptr};
+  i2s_chan_handle_t rx_handle_{nullptr};
+  uint8_t enabled_channels_{I2SAccess::FREE};
+  uint32_t installed_sample_rate_{0};
+  uint32_t rx_dma_frame_num_{0};
+  QueueHandle_t i2s_event_queue_{nullptr};
+
+  // Bus frame clock. Frames captured since the driver was installed count exactly; other times are extrapolated from
+  // the anchor, the latest moment a known frame was on the bus.
+  Mutex frame_clock_lock_;
+  uint32_t rx_start_frame_{0};
+  uint32_t rx_frames_{0};
+  uint32_t anchor_frame_{0};
+  uint32_t anchor_us_{0};
 };
 
 class I2SSettings {
@@ -84,29 +135,65 @@ public:
   I2SSettings() = default;
   I2SSettings(uint8_t access) : i2s_access_(access) {}
 
-  i2s_driver_config_t get_i2s_cfg() const;
+  /// @brief Returns the config for allocating a channel with these settings' role and DMA buffers
+  i2s_chan_config_t get_chan_cfg(i2s_port_t port) const;
+  /// @brief Initializes an allocated channel in standard, TDM, or PDM mode
+  esp_err_t init_channel(i2s_chan_handle_t handle, i2s_std_gpio_config_t gpio_cfg, uint32_t sample_rate) const;
+  /// @brief Changes the sample rate of an initialized channel, which must be disabled
+  esp_err_t reconfig_clock(i2s_chan_handle_t handle, uint32_t sample_rate) const;
   void dump_i2s_settings() const;
   
-  void set_clk_mode(i2s_mode_t clk_mode){ this->i2s_clk_mode_ = clk_mode; } 
-  void set_channel(i2s_channel_fmt_t channel_fmt) { this->channel_fmt_ = channel_fmt; }
+  void set_clk_mode(i2s_role_t clk_mode){ this->i2s_role_ = clk_mode; } 
+  void set_slot_mode(i2s_slot_mode_t slot_mode) { this->slot_mode_ = slot_mode; }
+  void set_std_slot_mask(i2s_std_slot_mask_t slot_mask) { this->std_slot_mask_ = slot_mask; }
+#if SOC_I2S_SUPPORTS_TDM
+  /// @brief Switches to TDM. Each active slot carries one channel of the audio, the other slots aren't transferred.
+  /// @param slot_mask Active slots, I2S_TDM_SLOT0 and up
+  /// @param total_slots Slots in a frame on the bus, or I2S_TDM_AUTO_SLOT_NUM for up to the highest active slot
+  void set_tdm_slots(uint32_t slot_mask, uint32_t total_slots) {
+    this->tdm_slot_mask_ = slot_mask;
+    this->tdm_total_slots_ = total_slots;
+  }
+#endif
   void set_sample_rate(uint32_t sample_rate) { this->sample_rate_ = sample_rate; }
-  void set_bits_per_sample(i2s_bits_per_sample_t bits_per_sample) { this->bits_per_sample_ = bits_per_sample; }
-  void set_bits_per_channel(i2s_bits_per_chan_t bits_per_channel) { this->bits_per_channel_ = bits_per_channel; }
-  void set_use_apll(uint32_t use_apll) { this->use_apll_ = use_apll; }
+  void set_bits_per_sample(i2s_data_bit_width_t bits_per_sample) { this->bits_per_sample_ = bits_per_sample; }
+  void set_bits_per_channel(i2s_slot_bit_width_t bits_per_channel) { this->bits_per_channel_ = bits_per_channel; }
+  void set_use_apll(bool use_apll) { this->use_apll_ = use_apll; }
+  /// @brief Sets the DMA buffers allocated for the channel
+  /// @param count Number of DMA descriptors
+  /// @param frames Frames per DMA buffer
+  void set_dma_buffers(uint32_t count, uint32_t frames) {
+    this->dma_desc_num_ = count;
+    this->dma_frame_num_ = frames;
+  }
   
   void set_pdm(bool pdm) { this->pdm_ = pdm; }
   void set_fixed_settings(bool is_fixed){ this->is_fixed_ = is_fixed; }
-  int num_of_channels() const { return (this->channel_fmt_ == I2S_CHANNEL_FMT_ONLY_RIGHT
-   || this->channel_fmt_ == I2S_CHANNEL_FMT_ONLY_LEFT) ? 1 : 2; }
+  bool is_tdm() const { return this->tdm_slot_mask_ != 0; }
+  int num_of_channels() const {
+    if( this->is_tdm() ){
+      return __builtin_popcount(this->tdm_slot_mask_);
+    }
+    return this->slot_mode_ == I2S_SLOT_MODE_MONO ? 1 : 2;
+  }
+  uint32_t get_dma_desc_num() const { return this->dma_desc_num_; }
+  uint32_t get_dma_frame_num() const { return this->dma_frame_num_; }
   
 
 protected:
+   i2s_clock_src_t get_clk_src_() const;
+
    bool use_apll_{false};
-   i2s_bits_per_sample_t bits_per_sample_;
-   i2s_bits_per_chan_t bits_per_channel_;
-   i2s_channel_fmt_t channel_fmt_;
-   i2s_mode_t i2s_clk_mode_{I2S_MODE_MASTER};
-   i2s_mode_t i2s_access_mode_;
+   i2s_data_bit_width_t bits_per_sample_{I2S_DATA_BIT_WIDTH_16BIT};
+   i2s_slot_bit_width_t bits_per_channel_{I2S_SLOT_BIT_WIDTH_AUTO};
+   i2s_slot_mode_t slot_mode_{I2S_SLOT_MODE_STEREO};
+   i2s_std_slot_mask_t std_slot_mask_{I2S_STD_SLOT_BOTH};
+   uint32_t tdm_slot_mask_{0};
+   uint32_t tdm_total_slots_{0};
+   i2s_role_t i2s_role_{I2S_ROLE_MASTER};
+   // Speakers write one DMA buffer at a time and size their buffers to the whole queue, both in frames
+   uint32_t dma_desc_num_{4};
+   uint32_t dma_frame_num_{240};
    
    bool pdm_{false};
    uint32_t sample_rate_;
@@ -120,27 +207,38 @@ class I2SReader : public I2SSettings, public Parented<I2SAudioComponent> {
 public:
    I2SReader() : I2SSettings( I2SAccess::RX ) {}
 
-   bool install_i2s_driver(i2s_driver_config_t i2s_cfg){
-      return this->parent_->install_i2s_driver_(i2s_cfg, I2SAccess::RX);}
+   bool install_i2s_driver(){ return this->install_i2s_driver(this->sample_rate_); }
+   bool install_i2s_driver(uint32_t sample_rate){
+      return this->parent_->install_i2s_driver_(sample_rate, I2SAccess::RX);}
    bool uninstall_i2s_driver(){ return this->parent_->uninstall_i2s_driver_(I2SAccess::RX);}
    bool claim_i2s_access(){return this->parent_->claim_access_(I2SAccess::RX);}
    bool release_i2s_access(){return this->parent_->release_access_(I2SAccess::RX);}
    bool is_adjustable(){return !this->is_fixed_ && this->parent_->is_exclusive();}
-#if SOC_I2S_SUPPORTS_ADC
-  void set_adc_channel(adc1_channel_t channel) {
-    this->adc_channel_ = channel;
-    this->use_internal_adc_ = true;
-  }
-#endif
+
+   /// @brief Registers a callback for every block read, e.g., to align the microphone with a playback reference.
+   /// Called from the reading task with the bus frame of the block's first frame, the block in the bus format, and its
+   /// number of frames, so it should return quickly.
+   void add_on_rx_block_callback(std::function<void(uint32_t, const void *, size_t)> &&callback) {
+      this->rx_block_callback_.add(std::move(callback));
+   }
    void set_din_pin(int8_t pin) { this->din_pin_ = pin; }
    int8_t get_din_pin() { return this->din_pin_; }
 
 protected:
-#if SOC_I2S_SUPPORTS_ADC
-   adc1_channel_t adc_channel_{ADC1_CHANNEL_MAX};
-   bool use_internal_adc_{false};
-#endif
-   int8_t din_pin_{I2S_PIN_NO_CHANGE};
+   /// @brief Counts a block read from the I2S port on the shared frame clock and reports it to the callbacks.
+   /// Must be called for every read, so the count stays in step with the bus.
+   /// @param data Block in the bus format
+   /// @param frames Number of frames in the block
+   /// @param read_start_us Time from micros() when the read started
+   /// @return Bus frame of the block's first frame
+   uint32_t stamp_rx_block_(const void *data, size_t frames, uint32_t read_start_us){
+      const uint32_t bus_frame = this->parent_->advance_rx_frames_(frames, read_start_us);
+      this->rx_block_callback_.call(bus_frame, data, frames);
+      return bus_frame;
+   }
+
+   CallbackManager<void(uint32_t, const void *, size_t)> rx_block_callback_;
+   int8_t din_pin_{I2S_GPIO_UNUSED};
 };
 
 
@@ -148,25 +246,42 @@ class I2SWriter : public I2SSettings, public Parented<I2SAudioComponent> {
 public:
    I2SWriter() : I2SSettings(I2SAccess::TX ) {}
 
-   bool install_i2s_driver(i2s_driver_config_t i2s_cfg){
-      return this->parent_->install_i2s_driver_(i2s_cfg, I2SAccess::TX); }
+   bool install_i2s_driver(){ return this->install_i2s_driver(this->sample_rate_); }
+   bool install_i2s_driver(uint32_t sample_rate){
+      return this->parent_->install_i2s_driver_(sample_rate, I2SAccess::TX); }
    bool uninstall_i2s_driver(){ return this->parent_->uninstall_i2s_driver_(I2SAccess::TX);}
+   /// @brief Changes the sample rate of the installed driver without reinstalling it. Refused while the reader shares
+   /// the port, so the microphone's clock never changes under it.
+   bool reconfigure_i2s_clock(uint32_t sample_rate){
+      return this->parent_->reconfigure_i2s_clock_(sample_rate, I2SAccess::TX);}
    bool claim_i2s_access(){return this->parent_->claim_access_(I2SAccess::TX);}
    bool release_i2s_access(){return this->parent_->release_access_(I2SAccess::TX);}
    bool is_adjustable(){return !this->is_fixed_ && this->parent_->is_exclusive();}
 
-#if SOC_I2S_SUPPORTS_DAC
-  void set_internal_dac_mode(i2s_dac_mode_t mode) { this->internal_dac_mode_ = mode; }
-#endif
+   /// @brief Registers a callback for every block written, e.g., as the echo reference for the microphone. Called from
+   /// the writing task with the bus frame the block starts playing at, the block in the bus format, and its number of
+   /// frames, so it should return quickly.
+   void add_on_tx_block_callback(std::function<void(uint32_t, const void *, size_t)> &&callback) {
+      this->tx_block_callback_.add(std::move(callback));
+   }
 
    void set_dout_pin(int8_t pin) { this->dout_pin_ = pin; }
    int8_t get_dout_pin() { return this->dout_pin_; }
 
 protected:
-#if SOC_I2S_SUPPORTS_DAC
-   i2s_dac_mode_t internal_dac_mode_{I2S_DAC_CHANNEL_DISABLE};
-#endif
-   int8_t dout_pin_{I2S_PIN_NO_CHANGE};
+   /// @brief Reports a block written to the I2S port to the callbacks with its bus frame.
+   /// @param data Block in the bus format
+   /// @param frames Number of frames in the block
+   /// @param end_us Time from micros() when the block's last frame finishes playing
+   /// @return Bus frame the block starts playing at
+   uint32_t stamp_tx_block_(const void *data, size_t frames, uint32_t end_us){
+      const uint32_t bus_frame = this->parent_->frame_at(end_us) - frames;
+      this->tx_block_callback_.call(bus_frame, data, frames);
+      return bus_frame;
+   }
+
+   CallbackManager<void(uint32_t, const void *, size_t)> tx_block_callback_;
+   int8_t dout_pin_{I2S_GPIO_UNUSED};
 };
 
 
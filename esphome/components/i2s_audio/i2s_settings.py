@@ -1,5 +1,7 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
+from esphome.components.esp32 import get_esp32_variant
+from esphome.components.esp32.const import VARIANT_ESP32C3, VARIANT_ESP32S3
 from esphome.const import CONF_CHANNEL
 
 CONF_CLK_MODE = "i2s_clock_mode"
@@ -8,6 +10,8 @@ CONF_BITS_PER_SAMPLE = "bits_per_sample"
 CONF_PDM = "pdm"
 CONF_USE_APLL = "use_apll"
 CONF_FIXED_SETTINGS = "fixed_settings"
+CONF_TDM_SLOTS = "tdm_slots"
+CONF_TDM_TOTAL_SLOTS = "tdm_total_slots"
 
 CONF_MONO = "mono"
 CONF_LEFT = "left"
@@ -18,68 +22,112 @@ CONF_STEREO = "stereo"
 
 INTERNAL_CLK = "internal"
 EXTERNAL_CLK = "external"
-i2s_mode_t = cg.global_ns.enum("i2s_mode_t")
+i2s_role_t = cg.global_ns.enum("i2s_role_t")
 I2S_CLK_MODES = {
-    INTERNAL_CLK: i2s_mode_t.I2S_MODE_MASTER,  # NOLINT
-    EXTERNAL_CLK: i2s_mode_t.I2S_MODE_SLAVE,  # NOLINT
+    INTERNAL_CLK: i2s_role_t.I2S_ROLE_MASTER,  # NOLINT
+    EXTERNAL_CLK: i2s_role_t.I2S_ROLE_SLAVE,  # NOLINT
 }
 
 
-i2s_dac_mode_t = cg.global_ns.enum("i2s_dac_mode_t")
-INTERNAL_DAC_OPTIONS = {
-    "left": i2s_dac_mode_t.I2S_DAC_CHANNEL_LEFT_EN,
-    "right": i2s_dac_mode_t.I2S_DAC_CHANNEL_RIGHT_EN,
-    "stereo": i2s_dac_mode_t.I2S_DAC_CHANNEL_BOTH_EN,
-}
-
-i2s_channel_fmt_t = cg.global_ns.enum("i2s_channel_fmt_t")
+i2s_slot_mode_t = cg.global_ns.enum("i2s_slot_mode_t")
+SLOT_MODE_MONO = i2s_slot_mode_t.I2S_SLOT_MODE_MONO
+SLOT_MODE_STEREO = i2s_slot_mode_t.I2S_SLOT_MODE_STEREO
+i2s_std_slot_mask_t = cg.global_ns.enum("i2s_std_slot_mask_t")
+# Slot mode and active slots of each channel option
 CHANNEL_FORMAT = {
     # Only load data in left channel (mono mode)
-    "left": i2s_channel_fmt_t.I2S_CHANNEL_FMT_ONLY_LEFT,
+    "left": (SLOT_MODE_MONO, i2s_std_slot_mask_t.I2S_STD_SLOT_LEFT),
     # Only load data in right channel (mono mode)
-    "right": i2s_channel_fmt_t.I2S_CHANNEL_FMT_ONLY_RIGHT,
+    "right": (SLOT_MODE_MONO, i2s_std_slot_mask_t.I2S_STD_SLOT_RIGHT),
     # Separated left and right channel
-    "right_left": i2s_channel_fmt_t.I2S_CHANNEL_FMT_RIGHT_LEFT,
-    # Load right channel data in both two channels
-    "all_right": i2s_channel_fmt_t.I2S_CHANNEL_FMT_ALL_RIGHT,
-    # Load left channel data in both two channels
-    "all_left": i2s_channel_fmt_t.I2S_CHANNEL_FMT_ALL_LEFT,
+    "right_left": (SLOT_MODE_STEREO, i2s_std_slot_mask_t.I2S_STD_SLOT_BOTH),
+    # Receive the named channel; transmit the mono data in both channels
+    "all_right": (SLOT_MODE_MONO, i2s_std_slot_mask_t.I2S_STD_SLOT_RIGHT),
+    "all_left": (SLOT_MODE_MONO, i2s_std_slot_mask_t.I2S_STD_SLOT_LEFT),
 }
 I2S_CHANNELS = {
-    CONF_MONO: i2s_channel_fmt_t.I2S_CHANNEL_FMT_ALL_LEFT,
-    CONF_LEFT: i2s_channel_fmt_t.I2S_CHANNEL_FMT_ONLY_LEFT,
-    CONF_RIGHT: i2s_channel_fmt_t.I2S_CHANNEL_FMT_ONLY_RIGHT,
-    CONF_STEREO: i2s_channel_fmt_t.I2S_CHANNEL_FMT_RIGHT_LEFT,
+    CONF_MONO: CHANNEL_FORMAT["all_left"],
+    CONF_LEFT: CHANNEL_FORMAT["left"],
+    CONF_RIGHT: CHANNEL_FORMAT["right"],
+    CONF_STEREO: CHANNEL_FORMAT["right_left"],
 }
+CHANNELS = {**CHANNEL_FORMAT, **I2S_CHANNELS}
+# Channel options whose mono data is duplicated to both slots when transmitting
+TX_BOTH_SLOTS = {"all_right", "all_left", CONF_MONO}
+
+
+def get_slot_format(config, transmit):
+    slot_mode, slot_mask = CHANNELS[config[CONF_CHANNEL]]
+    if transmit and config[CONF_CHANNEL] in TX_BOTH_SLOTS:
+        slot_mask = i2s_std_slot_mask_t.I2S_STD_SLOT_BOTH
+    return slot_mode, slot_mask
 
-i2s_bits_per_sample_t = cg.global_ns.enum("i2s_bits_per_sample_t")
+
+i2s_data_bit_width_t = cg.global_ns.enum("i2s_data_bit_width_t")
 BITS_PER_SAMPLE = {
-    16: i2s_bits_per_sample_t.I2S_BITS_PER_SAMPLE_16BIT,
-    24: i2s_bits_per_sample_t.I2S_BITS_PER_SAMPLE_24BIT,
-    32: i2s_bits_per_sample_t.I2S_BITS_PER_SAMPLE_32BIT,
+    16: i2s_data_bit_width_t.I2S_DATA_BIT_WIDTH_16BIT,
+    24: i2s_data_bit_width_t.I2S_DATA_BIT_WIDTH_24BIT,
+    32: i2s_data_bit_width_t.I2S_DATA_BIT_WIDTH_32BIT,
 }
 
-i2s_bits_per_chan_t = cg.global_ns.enum("i2s_bits_per_chan_t")
+i2s_slot_bit_width_t = cg.global_ns.enum("i2s_slot_bit_width_t")
 BITS_PER_CHANNEL = {
-    "default": i2s_bits_per_chan_t.I2S_BITS_PER_CHAN_DEFAULT,
-    8: i2s_bits_per_chan_t.I2S_BITS_PER_CHAN_8BIT,
-    16: i2s_bits_per_chan_t.I2S_BITS_PER_CHAN_16BIT,
-    24: i2s_bits_per_chan_t.I2S_BITS_PER_CHAN_24BIT,
-    32: i2s_bits_per_chan_t.I2S_BITS_PER_CHAN_32BIT,
+    "default": i2s_slot_bit_width_t.I2S_SLOT_BIT_WIDTH_AUTO,
+    8: i2s_slot_bit_width_t.I2S_SLOT_BIT_WIDTH_8BIT,
+    16: i2s_slot_bit_width_t.I2S_SLOT_BIT_WIDTH_16BIT,
+    24: i2s_slot_bit_width_t.I2S_SLOT_BIT_WIDTH_24BIT,
+    32: i2s_slot_bit_width_t.I2S_SLOT_BIT_WIDTH_32BIT,
 }
 
+TDM_VARIANTS = [VARIANT_ESP32S3, VARIANT_ESP32C3]
+MAX_TDM_SLOTS = 16
+
 _validate_bits = cv.float_with_unit("bits", "bit")
 
+
+def get_num_channels(config):
+    if tdm_slots := config.get(CONF_TDM_SLOTS):
+        return len(tdm_slots)
+    slot_mode, _ = CHANNELS[config[CONF_CHANNEL]]
+    return 1 if slot_mode is SLOT_MODE_MONO else 2
+
+
+def validate_tdm(config):
+    if CONF_TDM_SLOTS not in config:
+        if CONF_TDM_TOTAL_SLOTS in config:
+            raise cv.Invalid(f"{CONF_TDM_TOTAL_SLOTS} requires {CONF_TDM_SLOTS}")
+        return config
+    variant = get_esp32_variant()
+    if variant not in TDM_VARIANTS:
+        raise cv.Invalid(f"{variant} does not support TDM")
+    slots = config[CONF_TDM_SLOTS]
+    if len(set(slots)) != len(slots):
+        raise cv.Invalid("TDM slots must be unique")
+    if config.get(CONF_TDM_TOTAL_SLOTS, MAX_TDM_SLOTS) <= max(slots):
+        raise cv.Invalid(f"{CONF_TDM_TOTAL_SLOTS} must include slot {max(slots)}")
+    return config
+
+
+TDM_SCHEMA = {
+    # Active slots, each carrying one channel of the audio; the other slots aren't transferred
+    cv.Optional(CONF_TDM_SLOTS): cv.All(
+        cv.ensure_list(cv.int_range(min=0, max=MAX_TDM_SLOTS - 1)), cv.Length(min=1)
+    ),
+    # Slots per frame on the bus, defaults to up to the highest active slot
+    cv.Optional(CONF_TDM_TOTAL_SLOTS): cv.int_range(min=1, max=MAX_TDM_SLOTS),
+}
+
 CONFIG_SCHEMA_I2S_COMMON = cv.Schema(
     {
         cv.Optional(CONF_CLK_MODE, default=INTERNAL_CLK): cv.enum(I2S_CLK_MODES),
-        cv.Optional(CONF_CHANNEL, default="right_left"): cv.enum(CHANNEL_FORMAT),
+        cv.Optional(CONF_CHANNEL, default="right_left"): cv.one_of(*CHANNELS, lower=True),
         cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.int_range(min=1),
         cv.Optional(CONF_BITS_PER_SAMPLE, default="32bit"): cv.All(
             _validate_bits, cv.enum(BITS_PER_SAMPLE)
         ),
         cv.Optional(CONF_USE_APLL, default=False): cv.boolean,
         cv.Optional(CONF_FIXED_SETTINGS, default=False): cv.boolean,
+        **TDM_SCHEMA,
     }
 )
 
@@ -88,12 +136,15 @@ def get_i2s_config_schema(default_channel, default_rate, default_bits):
     return cv.Schema(
         {
             cv.Optional(CONF_CLK_MODE, default=INTERNAL_CLK): cv.enum(I2S_CLK_MODES),
-            cv.Optional(CONF_CHANNEL, default=default_channel): cv.enum(I2S_CHANNELS),
+            cv.Optional(CONF_CHANNEL, default=default_channel): cv.one_of(
+                *CHANNELS, lower=True
+            ),
             cv.Optional(CONF_SAMPLE_RATE, default=default_rate): cv.int_range(min=1),
             cv.Optional(CONF_BITS_PER_SAMPLE, default=default_bits): cv.All(
                 _validate_bits, cv.enum(BITS_PER_SAMPLE)
             ),
             cv.Optional(CONF_USE_APLL, default=False): cv.boolean,
             cv.Optional(CONF_FIXED_SETTINGS, default=False): cv.boolean,
+            **TDM_SCHEMA,
         }
     )
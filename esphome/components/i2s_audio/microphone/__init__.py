@@ -2,9 +2,8 @@ import esphome.config_validation as cv
 import esphome.codegen as cg
 
 from esphome import pins
-from esphome.const import CONF_CHANNEL, CONF_ID, CONF_MODEL, CONF_NUMBER
+from esphome.const import CONF_CHANNEL, CONF_ID, CONF_MODEL
 from esphome.components import microphone, esp32
-from esphome.components.adc import ESP32_VARIANT_ADC1_PIN_TO_CHANNEL, validate_adc_pin
 
 from .. import i2s_settings as i2s
 
@@ -22,7 +21,6 @@ from .. import (
 CODEOWNERS = ["@jesserockz"]
 DEPENDENCIES = ["i2s_audio"]
 
-CONF_ADC_PIN = "adc_pin"
 CONF_ADC_TYPE = "adc_type"
 CONF_PDM = "pdm"
 CONF_SAMPLE_RATE = "sample_rate"
@@ -33,18 +31,12 @@ I2SAudioMicrophone = i2s_audio_ns.class_(
     "I2SAudioMicrophone", I2SReader, microphone.Microphone, cg.Component
 )
 
-i2s_channel_fmt_t = cg.global_ns.enum("i2s_channel_fmt_t")
-CHANNELS = {
-    "left": i2s_channel_fmt_t.I2S_CHANNEL_FMT_ONLY_LEFT,
-    "right": i2s_channel_fmt_t.I2S_CHANNEL_FMT_ONLY_RIGHT,
-}
-i2s_bits_per_sample_t = cg.global_ns.enum("i2s_bits_per_sample_t")
+CHANNELS = ["left", "right"]
 BITS_PER_SAMPLE = {
-    16: i2s_bits_per_sample_t.I2S_BITS_PER_SAMPLE_16BIT,
-    32: i2s_bits_per_sample_t.I2S_BITS_PER_SAMPLE_32BIT,
+    16: i2s.BITS_PER_SAMPLE[16],
+    32: i2s.BITS_PER_SAMPLE[32],
 }
 
-INTERNAL_ADC_VARIANTS = [esp32.const.VARIANT_ESP32]
 PDM_VARIANTS = [esp32.const.VARIANT_ESP32, esp32.const.VARIANT_ESP32S3]
 
 _validate_bits = cv.float_with_unit("bits", "bit")
@@ -57,10 +49,6 @@ def validate_esp32_variant(config):
             if variant not in PDM_VARIANTS:
                 raise cv.Invalid(f"{variant} does not support PDM")
         return config
-    if config[CONF_ADC_TYPE] == "internal":
-        if variant not in INTERNAL_ADC_VARIANTS:
-            raise cv.Invalid(f"{variant} does not have an internal ADC")
-        return config
     raise NotImplementedError
 
 
@@ -68,7 +56,7 @@ BASE_SCHEMA = microphone.MICROPHONE_SCHEMA.extend(
     {
         cv.GenerateID(): cv.declare_id(I2SAudioMicrophone),
         cv.GenerateID(CONF_I2S_AUDIO_ID): cv.use_id(I2SAudioComponent),
-        cv.Optional(CONF_CHANNEL, default="right"): cv.enum(CHANNELS),
+        cv.Optional(CONF_CHANNEL, default="right"): cv.one_of(*CHANNELS, lower=True),
         cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.int_range(min=1),
         cv.Optional(CONF_BITS_PER_SAMPLE, default="32bit"): cv.All(
             _validate_bits, cv.enum(BITS_PER_SAMPLE)
@@ -80,11 +68,6 @@ BASE_SCHEMA = microphone.MICROPHONE_SCHEMA.extend(
 CONFIG_SCHEMA = cv.All(
     cv.typed_schema(
         {
-            "internal": BASE_SCHEMA.extend(
-                {
-                    cv.Required(CONF_ADC_PIN): validate_adc_pin,
-                }
-            ),
             "external": BASE_SCHEMA.extend(
                 {
                     cv.Required(CONF_I2S_DIN_PIN): pins.internal_gpio_input_pin_number,
@@ -98,6 +81,7 @@ CONFIG_SCHEMA = cv.All(
         key=CONF_ADC_TYPE,
     ),
     validate_esp32_variant,
+    i2s.validate_tdm,
 )
 
 
@@ -107,14 +91,8 @@ async def to_code(config):
 
     # await cg.register_parented(var, config[CONF_I2S_AUDIO_ID])
 
-    if config[CONF_ADC_TYPE] == "internal":
-        variant = esp32.get_esp32_variant()
-        pin_num = config[CONF_ADC_PIN][CONF_NUMBER]
-        channel = ESP32_VARIANT_ADC1_PIN_TO_CHANNEL[variant][pin_num]
-        cg.add(var.set_adc_channel(channel))
-    else:
-        # cg.add(var.set_din_pin(config[CONF_I2S_DIN_PIN]))
-        # cg.add(var.set_pdm(config[CONF_PDM]))
-        await register_i2s_reader(var, config)
+    # cg.add(var.set_din_pin(config[CONF_I2S_DIN_PIN]))
+    # cg.add(var.set_pdm(config[CONF_PDM]))
+    await register_i2s_reader(var, config)
 
     await microphone.register_microphone(var, config)
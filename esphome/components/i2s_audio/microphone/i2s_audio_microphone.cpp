@@ -2,7 +2,6 @@
 
 #ifdef USE_ESP32
 
-#include <driver/i2s.h>
 #include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 
@@ -13,22 +12,17 @@
 namespace esphome {
 namespace i2s_audio {
 
-static const size_t BUFFER_SIZE = 512;
+// Bytes requested from the driver by each read in the loop
+static const size_t READ_SIZE = 256;
+static const size_t READ_SAMPLES = READ_SIZE / sizeof(int16_t);
 
 static const char *const TAG = "i2s_audio.microphone";
 
 void I2SAudioMicrophone::setup() {
   ESP_LOGCONFIG(TAG, "Setting up I2S Audio Microphone...");
-#if SOC_I2S_SUPPORTS_ADC
-  if (this->use_internal_adc_) {
-    if (this->parent_->get_port() != I2S_NUM_0) {
-      ESP_LOGE(TAG, "Internal ADC only works on I2S0!");
-      this->mark_failed();
-      return;
-    }
-  } else
-#endif
-      if (this->pdm_) {
+  // Reused by every read, so the loop never allocates while the microphone is running
+  this->samples_.reserve(READ_SAMPLES);
+  if (this->pdm_) {
     if (this->parent_->get_port() != I2S_NUM_0) {
       ESP_LOGE(TAG, "PDM only works on I2S0!");
       this->mark_failed();
@@ -58,29 +52,14 @@ void I2SAudioMicrophone::start_() {
   }
 #endif
 
-i2s_driver_config_t config = this->get_i2s_cfg();
-//config.mode = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_RX);
-
-#if SOC_I2S_SUPPORTS_ADC
-  if (this->use_internal_adc_) {
-    config.mode = (i2s_mode_t) (config.mode | I2S_MODE_ADC_BUILT_IN);
-    i2s_driver_install(this->parent_->get_port(), &config, 0, nullptr);
-
-    i2s_set_adc_mode(ADC_UNIT_1, this->adc_channel_);
-    i2s_adc_enable(this->parent_->get_port());
-  } else
-#endif
-  {
-    if (this->pdm_)
-      config.mode = (i2s_mode_t) (config.mode | I2S_MODE_PDM);
-
-    this->install_i2s_driver(config);
-
+  if (!this->install_i2s_driver()) {
+    this->release_i2s_access();
+    return;
   }
 
 #ifdef I2S_EXTERNAL_ADC
   if( this->external_adc_ != nullptr ){
-    this->external_adc_->apply_i2s_settings(config);
+    this->external_adc_->apply_i2s_settings(*this);
   }
 #endif
 
@@ -107,8 +86,9 @@ void I2SAudioMicrophone::stop_() {
 
 size_t I2SAudioMicrophone::read(int16_t *buf, size_t len) {
   size_t bytes_read = 0;
-  esp_err_t err = i2s_read(this->parent_->get_port(), buf, len, &bytes_read, (1 / portTICK_PERIOD_MS));
-  if (err != ESP_OK) {
+  const uint32_t read_start_us = micros();
+  esp_err_t err = i2s_channel_read(this->parent_->get_rx_handle(), buf, len, &bytes_read, 1);
+  if ((err != ESP_OK) && (err != ESP_ERR_TIMEOUT)) {
     ESP_LOGW(TAG, "Error reading from I2S microphone: %s", esp_err_to_name(err));
     this->status_set_warning();
     return 0;
@@ -117,19 +97,20 @@ size_t I2SAudioMicrophone::read(int16_t *buf, size_t len) {
   if (bytes_read == 0) {
      return 0;
   }
+  this->stamp_rx_block_(buf, bytes_read / (this->bits_per_sample_ / 8 * this->num_of_channels()), read_start_us);
   this->status_clear_warning();
-  if (this->bits_per_sample_ == I2S_BITS_PER_SAMPLE_16BIT) {
+  if (this->bits_per_sample_ == I2S_DATA_BIT_WIDTH_16BIT) {
     return bytes_read;
-  } else if (this->bits_per_sample_ == I2S_BITS_PER_SAMPLE_32BIT) {
-    std::vector<int16_t> samples;
-    size_t samples_read = bytes_read / sizeof(int32_t);
-    uint8_t shift = 16 - this->gain_log2_ ;
-    samples.resize(samples_read);
+  } else if (this->bits_per_sample_ == I2S_DATA_BIT_WIDTH_32BIT) {
+    // Narrow in place. Each 16 bit sample is written at or before the 32 bit sample it comes from, so no sample is
+    // overwritten before it's read.
+    const int32_t *samples_32 = reinterpret_cast<const int32_t *>(buf);
+    const size_t samples_read = bytes_read / sizeof(int32_t);
+    const uint8_t shift = 16 - this->gain_log2_;
     for (size_t i = 0; i < samples_read; i++) {
-      int32_t temp = reinterpret_cast<int32_t *>(buf)[i] >> shift;
-      samples[i] = static_cast<int16_t>(clamp<int32_t>(temp, INT16_MIN, INT16_MAX));
+      const int32_t temp = samples_32[i] >> shift;
+      buf[i] = static_cast<int16_t>(clamp<int32_t>(temp, INT16_MIN, INT16_MAX));
     }
-    memcpy(buf, samples.data(), samples_read * sizeof(int16_t));
     return samples_read * sizeof(int16_t);
   } else {
     ESP_LOGE(TAG, "Unsupported bits per sample: %d", this->bits_per_sample_);
@@ -138,11 +119,12 @@ size_t I2SAudioMicrophone::read(int16_t *buf, size_t len) {
 }
 
 void I2SAudioMicrophone::read_() {
-  std::vector<int16_t> samples;
-  samples.resize(BUFFER_SIZE);
-  size_t bytes_read = this->read(samples.data(), BUFFER_SIZE / sizeof(int16_t));
-  samples.resize(bytes_read / sizeof(int16_t));
-  this->data_callbacks_.call(samples);
+  // Stays within the capacity reserved in setup, so it doesn't allocate. The buffer keeps the size of the previous
+  // read, so growing it back only value-initializes samples that read didn't fill, none after a full 16 bit read.
+  this->samples_.resize(READ_SAMPLES);
+  size_t bytes_read = this->read(this->samples_.data(), READ_SIZE);
+  this->samples_.resize(bytes_read / sizeof(int16_t));
+  this->data_callbacks_.call(this->samples_);
 }
 
 void I2SAudioMicrophone::loop() {
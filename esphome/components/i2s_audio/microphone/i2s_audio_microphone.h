@@ -28,6 +28,7 @@ class I2SAudioMicrophone : public I2SReader, public microphone::Microphone, publ
   void read_();
 
   uint8_t gain_log2_{2};
+  std::vector<int16_t> samples_;
   HighFrequencyLoopRequester high_freq_;
 };
 
@@ -0,0 +1,83 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import sensor
+from esphome.const import (
+    CONF_ID,
+    CONF_LOOP_TIME,
+    CONF_SPEAKER,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    ICON_TIMER,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_PERCENT,
+)
+
+from .. import i2s_audio_ns
+from ..speaker import I2SAudioSpeaker
+
+CODEOWNERS = ["@gnumpi"]
+DEPENDENCIES = ["i2s_audio"]
+
+I2SSpeakerTelemetrySensor = i2s_audio_ns.class_(
+    "I2SSpeakerTelemetrySensor",
+    cg.PollingComponent,
+    cg.Parented.template(I2SAudioSpeaker),
+)
+
+CONF_DMA_UNDERFLOWS = "dma_underflows"
+CONF_SHORT_WRITES = "short_writes"
+CONF_RING_EMPTY_READS = "ring_empty_reads"
+CONF_BUFFER_FILL_LEVEL = "buffer_fill_level"
+
+UNIT_MICROSECOND = "µs"
+ICON_COUNTER = "mdi:counter"
+
+
+def _counter_schema():
+    return sensor.sensor_schema(
+        icon=ICON_COUNTER,
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    )
+
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(I2SSpeakerTelemetrySensor),
+        cv.GenerateID(CONF_SPEAKER): cv.use_id(I2SAudioSpeaker),
+        cv.Optional(CONF_DMA_UNDERFLOWS): _counter_schema(),
+        cv.Optional(CONF_SHORT_WRITES): _counter_schema(),
+        cv.Optional(CONF_RING_EMPTY_READS): _counter_schema(),
+        cv.Optional(CONF_BUFFER_FILL_LEVEL): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PERCENT,
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_LOOP_TIME): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MICROSECOND,
+            icon=ICON_TIMER,
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+    }
+).extend(cv.polling_component_schema("60s"))
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    await cg.register_parented(var, config[CONF_SPEAKER])
+
+    for key in (
+        CONF_DMA_UNDERFLOWS,
+        CONF_SHORT_WRITES,
+        CONF_RING_EMPTY_READS,
+        CONF_BUFFER_FILL_LEVEL,
+        CONF_LOOP_TIME,
+    ):
+        if sensor_config := config.get(key):
+            sens = await sensor.new_sensor(sensor_config)
+            cg.add(getattr(var, f"set_{key}_sensor")(sens))
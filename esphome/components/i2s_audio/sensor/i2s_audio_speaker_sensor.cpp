@@ -0,0 +1,51 @@
+#include "i2s_audio_speaker_sensor.h"
+
+#ifdef USE_ESP32
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace i2s_audio {
+
+static const char *const TAG = "i2s_audio.sensor";
+
+void I2SSpeakerTelemetrySensor::update() {
+  const I2SSpeakerTelemetry &telemetry = this->parent_->get_telemetry();
+
+  if (this->dma_underflows_sensor_ != nullptr) {
+    this->dma_underflows_sensor_->publish_state(telemetry.dma_underflows.load(std::memory_order_relaxed));
+  }
+  if (this->short_writes_sensor_ != nullptr) {
+    this->short_writes_sensor_->publish_state(telemetry.short_writes.load(std::memory_order_relaxed));
+  }
+  if (this->ring_empty_reads_sensor_ != nullptr) {
+    this->ring_empty_reads_sensor_->publish_state(telemetry.ring_empty_reads.load(std::memory_order_relaxed));
+  }
+  if (this->buffer_fill_level_sensor_ != nullptr) {
+    size_t buffered_bytes = 0;
+    size_t capacity_bytes = 0;
+    float fill_level = 0.0f;
+    if (this->parent_->get_buffer_level(&buffered_bytes, &capacity_bytes) && (capacity_bytes > 0)) {
+      fill_level = 100.0f * buffered_bytes / capacity_bytes;
+    }
+    this->buffer_fill_level_sensor_->publish_state(fill_level);
+  }
+  if (this->loop_time_sensor_ != nullptr) {
+    this->loop_time_sensor_->publish_state(this->parent_->take_max_loop_time_us());
+  }
+}
+
+void I2SSpeakerTelemetrySensor::dump_config() {
+  ESP_LOGCONFIG(TAG, "I2S Audio Speaker Telemetry:");
+  LOG_UPDATE_INTERVAL(this);
+  LOG_SENSOR("  ", "DMA Underflows", this->dma_underflows_sensor_);
+  LOG_SENSOR("  ", "Short Writes", this->short_writes_sensor_);
+  LOG_SENSOR("  ", "Ring Buffer Empty Reads", this->ring_empty_reads_sensor_);
+  LOG_SENSOR("  ", "Buffer Fill Level", this->buffer_fill_level_sensor_);
+  LOG_SENSOR("  ", "Loop Time", this->loop_time_sensor_);
+}
+
+}  // namespace i2s_audio
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,33 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "../speaker/i2s_audio_speaker.h"
+
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace i2s_audio {
+
+class I2SSpeakerTelemetrySensor : public PollingComponent, public Parented<I2SAudioSpeaker> {
+  /*
+   * @brief Publishes an I2SAudioSpeaker's telemetry for triaging stutter.
+   * The counters accumulate from boot, the buffer fill level is sampled on each update, and the loop time is the
+   * longest speaker task loop iteration since the previous update.
+   */
+  SUB_SENSOR(dma_underflows)
+  SUB_SENSOR(short_writes)
+  SUB_SENSOR(ring_empty_reads)
+  SUB_SENSOR(buffer_fill_level)
+  SUB_SENSOR(loop_time)
+
+ public:
+  void update() override;
+  void dump_config() override;
+};
+
+}  // namespace i2s_audio
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -1,23 +1,22 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome import pins
+from esphome import automation, pins
 from esphome.const import (
-    CONF_CHANNEL,
     CONF_ID,
-    CONF_NUM_CHANNELS, 
-    CONF_TIMEOUT
+    CONF_DURATION,
+    CONF_NUM_CHANNELS,
+    CONF_TIMEOUT,
+    CONF_TYPE,
 )
-from esphome.components import esp32, speaker
+from esphome.components import speaker
+from esphome.components.audio import GAIN_RAMP_TYPES
 
 from .. import i2s_settings as i2s
 
 from .. import (
     CONF_I2S_AUDIO_ID,
     CONF_I2S_DOUT_PIN,
-    CONF_LEFT,
     CONF_MONO,
-    CONF_RIGHT,
-    CONF_STEREO,
     I2SAudioComponent,
     i2s_audio_component_schema,
     I2SWriter,
@@ -31,31 +30,92 @@ DEPENDENCIES = ["i2s_audio"]
 I2SAudioSpeaker = i2s_audio_ns.class_(
     "I2SAudioSpeaker", cg.Component, speaker.Speaker, I2SWriter
 )
+I2SSourceSpeaker = i2s_audio_ns.class_(
+    "I2SSourceSpeaker", cg.Component, speaker.Speaker, cg.Parented.template(I2SAudioSpeaker)
+)
+DuckingApplyAction = i2s_audio_ns.class_(
+    "DuckingApplyAction", automation.Action, cg.Parented.template(I2SSourceSpeaker)
+)
+CrossfadeAction = i2s_audio_ns.class_(
+    "CrossfadeAction", automation.Action, cg.Parented.template(I2SSourceSpeaker)
+)
+DumpTelemetryAction = i2s_audio_ns.class_(
+    "DumpTelemetryAction", automation.Action, cg.Parented.template(I2SAudioSpeaker)
+)
 CONF_BUFFER_DURATION = "buffer_duration"
 CONF_NEVER = "never"
-i2s_dac_mode_t = cg.global_ns.enum("i2s_dac_mode_t")
 
 CONF_MUTE_PIN = "mute_pin"
 CONF_DAC_TYPE = "dac_type"
+CONF_VOLUME_RAMP = "volume_ramp"
+CONF_SOURCE_SPEAKERS = "source_speakers"
+CONF_SIDECHAIN_DUCKING = "sidechain_ducking"
+CONF_DECIBEL_REDUCTION = "decibel_reduction"
+CONF_FADE = "fade"
+CONF_TO = "to"
+CONF_KEEP_WARM = "keep_warm"
+CONF_RESET = "reset"
+CONF_DRIFT_COMPENSATION = "drift_compensation"
+CONF_TARGET_FILL_LEVEL = "target_fill_level"
+CONF_CHANNEL_MATRIX = "channel_matrix"
 
-INTERNAL_DAC_OPTIONS = {
-    "left": i2s_dac_mode_t.I2S_DAC_CHANNEL_LEFT_EN,
-    "right": i2s_dac_mode_t.I2S_DAC_CHANNEL_RIGHT_EN,
-    "stereo": i2s_dac_mode_t.I2S_DAC_CHANNEL_BOTH_EN,
-}
+VOLUME_RAMP_SCHEMA = cv.Schema(
+    {
+        cv.Optional(
+            CONF_DURATION, default="30ms"
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_TYPE, default="linear"): cv.enum(GAIN_RAMP_TYPES, lower=True),
+    }
+)
 
-NO_INTERNAL_DAC_VARIANTS = [esp32.const.VARIANT_ESP32S2]
+FADE_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_DURATION, default="0ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_TYPE, default="linear"): cv.enum(GAIN_RAMP_TYPES, lower=True),
+    }
+)
 
+SIDECHAIN_DUCKING_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_DECIBEL_REDUCTION, default=20): cv.int_range(min=0, max=51),
+        cv.Optional(CONF_DURATION, default="0ms"): cv.positive_time_period_milliseconds,
+    }
+)
 
-def validate_esp32_variant(config):
-    if config[CONF_DAC_TYPE] != "internal":
-        return config
-    variant = esp32.get_esp32_variant()
-    if variant in NO_INTERNAL_DAC_VARIANTS:
-        raise cv.Invalid(f"{variant} does not have an internal DAC")
-    return config
+DRIFT_COMPENSATION_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_TARGET_FILL_LEVEL, default="50%"): cv.percentage,
+    }
+)
+
+
+
+def _validate_channel_matrix(value):
+    rows = cv.ensure_list(cv.ensure_list(cv.float_range(min=-1.0, max=1.0)))(value)
+    if not 1 <= len(rows) <= 2:
+        raise cv.Invalid("channel_matrix must have one row per output channel (1 or 2)")
+    if not 1 <= len(rows[0]) <= 2:
+        raise cv.Invalid(
+            "channel_matrix must have one column per input channel (1 or 2)"
+        )
+    if any(len(row) != len(rows[0]) for row in rows):
+        raise cv.Invalid("channel_matrix rows must all have the same length")
+    return rows
 
 
+SOURCE_SPEAKER_SCHEMA = speaker.SPEAKER_SCHEMA.extend(
+    {
+        cv.GenerateID(): cv.declare_id(I2SSourceSpeaker),
+        cv.Optional(
+            CONF_BUFFER_DURATION, default="500ms"
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_SIDECHAIN_DUCKING): SIDECHAIN_DUCKING_SCHEMA,
+        cv.Optional(CONF_FADE, default={}): FADE_SCHEMA,
+        cv.Optional(CONF_DRIFT_COMPENSATION): DRIFT_COMPENSATION_SCHEMA,
+        cv.Optional(CONF_CHANNEL_MATRIX): _validate_channel_matrix,
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
 BASE_SCHEMA = (
     speaker.SPEAKER_SCHEMA.extend(
         i2s_audio_component_schema(
@@ -81,11 +141,19 @@ BASE_SCHEMA = (
 
 
 def _set_num_channels_from_config(config):
-    if config[CONF_CHANNEL] in (CONF_MONO, CONF_LEFT, CONF_RIGHT):
-        config[CONF_NUM_CHANNELS] = 1
-    else:
-        config[CONF_NUM_CHANNELS] = 2
+    config[CONF_NUM_CHANNELS] = i2s.get_num_channels(config)
+    return config
+
 
+def _validate_source_channel_matrices(config):
+    for source_config in config.get(CONF_SOURCE_SPEAKERS, []):
+        if CONF_CHANNEL_MATRIX not in source_config:
+            continue
+        if len(source_config[CONF_CHANNEL_MATRIX]) != config[CONF_NUM_CHANNELS]:
+            raise cv.Invalid(
+                f"channel_matrix of {source_config[CONF_ID]} must have one row per "
+                f"speaker channel ({config[CONF_NUM_CHANNELS]})"
+            )
     return config
 
 
@@ -101,12 +169,16 @@ CONFIG_SCHEMA = cv.All(
                         CONF_I2S_DOUT_PIN
                     ): pins.internal_gpio_output_pin_number,
                     cv.Optional(
-                CONF_BUFFER_DURATION, default="500ms"
-            ): cv.positive_time_period_milliseconds,
-            cv.Optional(CONF_TIMEOUT, default="500ms"): cv.Any(
-                cv.positive_time_period_milliseconds,
-                cv.one_of(CONF_NEVER, lower=True),
-            ),
+                        CONF_BUFFER_DURATION, default="500ms"
+                    ): cv.positive_time_period_milliseconds,
+                    cv.Optional(CONF_TIMEOUT, default="500ms"): cv.Any(
+                        cv.positive_time_period_milliseconds,
+                        cv.one_of(CONF_NEVER, lower=True),
+                    ),
+                    cv.Optional(CONF_KEEP_WARM): cv.positive_time_period_milliseconds,
+                    cv.Optional(CONF_VOLUME_RAMP, default={}): VOLUME_RAMP_SCHEMA,
+                    cv.Optional(CONF_FADE, default={}): FADE_SCHEMA,
+                    cv.Optional(CONF_SOURCE_SPEAKERS): cv.ensure_list(SOURCE_SPEAKER_SCHEMA),
                 }
             )
             .extend(
@@ -118,8 +190,9 @@ CONFIG_SCHEMA = cv.All(
         },
         key=CONF_DAC_TYPE,
     ),
-    validate_esp32_variant,
-    _set_num_channels_from_config
+    i2s.validate_tdm,
+    _set_num_channels_from_config,
+    _validate_source_channel_matrices,
 )
 
 
@@ -134,3 +207,102 @@ async def to_code(config):
     if config[CONF_TIMEOUT] != CONF_NEVER:
         cg.add(var.set_timeout(config[CONF_TIMEOUT]))
     cg.add(var.set_buffer_duration(config[CONF_BUFFER_DURATION]))
+    if CONF_KEEP_WARM in config:
+        cg.add(var.set_keep_warm(config[CONF_KEEP_WARM]))
+    volume_ramp = config[CONF_VOLUME_RAMP]
+    cg.add(var.set_volume_ramp(volume_ramp[CONF_TYPE], volume_ramp[CONF_DURATION]))
+    fade = config[CONF_FADE]
+    cg.add(var.set_fade(fade[CONF_TYPE], fade[CONF_DURATION]))
+
+    for source_config in config.get(CONF_SOURCE_SPEAKERS, []):
+        source = cg.new_Pvariable(source_config[CONF_ID])
+        await cg.register_component(source, source_config)
+        await speaker.register_speaker(source, source_config)
+        cg.add(source.set_parent(var))
+        cg.add(source.set_buffer_duration(source_config[CONF_BUFFER_DURATION]))
+        if sidechain_config := source_config.get(CONF_SIDECHAIN_DUCKING):
+            cg.add(
+                source.set_sidechain_ducking(
+                    sidechain_config[CONF_DECIBEL_REDUCTION],
+                    sidechain_config[CONF_DURATION],
+                )
+            )
+        fade = source_config[CONF_FADE]
+        cg.add(source.set_fade(fade[CONF_TYPE], fade[CONF_DURATION]))
+        if CONF_DRIFT_COMPENSATION in source_config:
+            drift_config = source_config[CONF_DRIFT_COMPENSATION]
+            cg.add(
+                source.set_drift_compensation(drift_config[CONF_TARGET_FILL_LEVEL])
+            )
+        if channel_matrix := source_config.get(CONF_CHANNEL_MATRIX):
+            q15_matrix = [round(gain * 32768) for row in channel_matrix for gain in row]
+            cg.add(source.set_channel_matrix(q15_matrix))
+        cg.add(var.add_source_speaker(source))
+
+
+@automation.register_action(
+    "i2s_audio.apply_ducking",
+    DuckingApplyAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(I2SSourceSpeaker),
+            cv.Required(CONF_DECIBEL_REDUCTION): cv.templatable(
+                cv.int_range(min=0, max=51)
+            ),
+            cv.Optional(CONF_DURATION, default="0s"): cv.templatable(
+                cv.positive_time_period_milliseconds
+            ),
+        }
+    ),
+)
+async def ducking_set_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    decibel_reduction = await cg.templatable(
+        config[CONF_DECIBEL_REDUCTION], args, cg.uint8
+    )
+    cg.add(var.set_decibel_reduction(decibel_reduction))
+    duration = await cg.templatable(config[CONF_DURATION], args, cg.uint32)
+    cg.add(var.set_duration(duration))
+    return var
+
+
+@automation.register_action(
+    "i2s_audio.crossfade",
+    CrossfadeAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(I2SSourceSpeaker),
+            cv.Required(CONF_TO): cv.use_id(I2SSourceSpeaker),
+            cv.Optional(CONF_DURATION, default="2s"): cv.templatable(
+                cv.positive_time_period_milliseconds
+            ),
+        }
+    ),
+)
+async def crossfade_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    next_speaker = await cg.get_variable(config[CONF_TO])
+    cg.add(var.set_next_speaker(next_speaker))
+    duration = await cg.templatable(config[CONF_DURATION], args, cg.uint32)
+    cg.add(var.set_duration(duration))
+    return var
+
+
+@automation.register_action(
+    "i2s_audio.dump_telemetry",
+    DumpTelemetryAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(I2SAudioSpeaker),
+            cv.Optional(CONF_RESET, default=False): cv.templatable(cv.boolean),
+        }
+    ),
+)
+async def dump_telemetry_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    reset = await cg.templatable(config[CONF_RESET], args, bool)
+    cg.add(var.set_reset(reset))
+    return var
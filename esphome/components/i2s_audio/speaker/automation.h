@@ -0,0 +1,47 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "esphome/core/automation.h"
+#include "i2s_audio_speaker.h"
+
+namespace esphome {
+namespace i2s_audio {
+
+template<typename... Ts> class DuckingApplyAction : public Action<Ts...>, public Parented<I2SSourceSpeaker> {
+ public:
+  TEMPLATABLE_VALUE(uint8_t, decibel_reduction)
+  TEMPLATABLE_VALUE(uint32_t, duration)
+
+  void play(Ts... x) override {
+    this->parent_->apply_ducking(this->decibel_reduction_.value(x...), this->duration_.value(x...));
+  }
+};
+
+template<typename... Ts> class CrossfadeAction : public Action<Ts...>, public Parented<I2SSourceSpeaker> {
+ public:
+  void set_next_speaker(I2SSourceSpeaker *next_speaker) { this->next_speaker_ = next_speaker; }
+  TEMPLATABLE_VALUE(uint32_t, duration)
+
+  void play(Ts... x) override { this->parent_->crossfade_to(this->next_speaker_, this->duration_.value(x...)); }
+
+ protected:
+  I2SSourceSpeaker *next_speaker_;
+};
+
+template<typename... Ts> class DumpTelemetryAction : public Action<Ts...>, public Parented<I2SAudioSpeaker> {
+ public:
+  TEMPLATABLE_VALUE(bool, reset)
+
+  void play(Ts... x) override {
+    this->parent_->dump_telemetry();
+    if (this->reset_.value(x...)) {
+      this->parent_->reset_telemetry();
+    }
+  }
+};
+
+}  // namespace i2s_audio
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -2,7 +2,8 @@
 
 #ifdef USE_ESP32
 
-#include <driver/i2s.h>
+
+#include <cstring>
 
 #include "esphome/components/audio/audio.h"
 
@@ -13,21 +14,28 @@
 namespace esphome {
 namespace i2s_audio {
 
-static const uint8_t DMA_BUFFER_DURATION_MS = 15;
-static const size_t DMA_BUFFERS_COUNT = 4;
-
-static const size_t TASK_DELAY_MS = DMA_BUFFER_DURATION_MS * DMA_BUFFERS_COUNT / 2;
-
 static const size_t TASK_STACK_SIZE = 4096;
 static const ssize_t TASK_PRIORITY = 23;
 
 
+// Frames a source speaker reads from its ring buffer at a time when mixing with a matrix or compensating for drift
+static const uint32_t STAGING_FRAMES = 256;
+
 static const char *const TAG = "i2s_audio.speaker";
+static const char *const SOURCE_TAG = "i2s_audio.source_speaker";
+
+// Duration of a number of frames, rounded up so delays and timeouts derived from it are never zero
+static uint32_t frames_to_ms_ceil(const audio::AudioStreamInfo &audio_stream_info, uint32_t frames) {
+  return (frames * 1000 + audio_stream_info.get_sample_rate() - 1) / audio_stream_info.get_sample_rate();
+}
 
 enum SpeakerEventGroupBits : uint32_t {
   COMMAND_START = (1 << 0),            // starts the speaker task
   COMMAND_STOP = (1 << 1),             // stops the speaker task
   COMMAND_STOP_GRACEFULLY = (1 << 2),  // Stops the speaker task once all data has been written
+  COMMAND_CANCEL_STOP = (1 << 3),      // Cancels a pending graceful stop because more audio arrived
+  STATE_IDLE = (1 << 8),               // Parked between streams with the buffers and I2S driver kept warm
+  STATE_STOP_PENDING = (1 << 9),       // A graceful stop was received; the task stops once the ring buffer drains
   STATE_STARTING = (1 << 10),
   STATE_RUNNING = (1 << 11),
   STATE_STOPPING = (1 << 12),
@@ -62,34 +70,80 @@ static esp_err_t err_bit_to_esp_err(uint32_t bit) {
   }
 }
 
-/// @brief Multiplies the input array of Q15 numbers by a Q15 constant factor
-///
-/// Based on `dsps_mulc_s16_ansi` from the esp-dsp library:
-/// https://github.com/espressif/esp-dsp/blob/master/modules/math/mulc/fixed/dsps_mulc_s16_ansi.c
-/// (accessed on 2024-09-30).
-/// @param input Array of Q15 numbers
-/// @param output Array of Q15 numbers
-/// @param len Length of array
-/// @param c Q15 constant factor
-static void q15_multiplication(const int16_t *input, int16_t *output, size_t len, int16_t c) {
-  for (int i = 0; i < len; i++) {
-    int32_t acc = (int32_t) input[i] * (int32_t) c;
-    output[i] = (int16_t) (acc >> 15);
+// Raises max to value, without losing a concurrent reset of max to 0
+static void store_max(std::atomic<uint32_t> &max, uint32_t value) {
+  uint32_t current = max.load(std::memory_order_relaxed);
+  while ((value > current) && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
   }
 }
 
+// Tracks when audio written to the I2S DMA buffers is actually played. The DMA buffers are sent back to back, so a
+// frame plays once every frame queued ahead of it has been sent. The clock is anchored to the moment a DMA buffer
+// finished sending, measured while the speaker task was blocked waiting for that event, so it is accurate to the task's
+// wake up latency rather than off by the DMA queue's duration.
+class DmaPresentationClock {
+ public:
+  DmaPresentationClock(uint32_t sample_rate, uint32_t dma_buffer_frames)
+      : sample_rate_(sample_rate), dma_buffer_frames_(dma_buffer_frames), anchor_us_(micros()) {}
+
+  /// @brief Accounts for DMA buffers that finished sending.
+  /// @param buffers Number of DMA buffers sent
+  /// @param fresh True if the task was waiting for the event, so the buffer finished sending just now
+  void on_buffers_sent(uint32_t buffers, bool fresh) {
+    this->pending_frames_ -= std::min(this->pending_frames_, buffers * this->dma_buffer_frames_);
+    if (fresh && (buffers > 0)) {
+      this->anchor_us_ = micros();
+      this->frames_after_anchor_ = this->pending_frames_;
+    }
+  }
+
+  /// @brief The DMA ran out of audio and sent silence, so nothing written earlier is still queued
+  void on_underflow() { this->pending_frames_ = 0; }
+
+  uint32_t get_pending_frames() const { return this->pending_frames_; }
+
+  /// @brief Accounts for frames written to the DMA buffers
+  /// @return System time in microseconds when the last written frame finishes playing
+  uint32_t on_frames_written(uint32_t frames) {
+    if (this->pending_frames_ == 0) {
+      // The DMA is sending silence, so the new audio starts playing within one DMA buffer
+      this->anchor_us_ = micros();
+      this->frames_after_anchor_ = 0;
+    }
+    this->pending_frames_ += frames;
+    this->frames_after_anchor_ += frames;
+
+    // Move the anchor forward in whole seconds to keep the frame count small
+    while (this->frames_after_anchor_ >= this->sample_rate_) {
+      this->anchor_us_ += 1000000;
+      this->frames_after_anchor_ -= this->sample_rate_;
+    }
+
+    return this->anchor_us_ +
+           static_cast<uint32_t>(static_cast<uint64_t>(this->frames_after_anchor_) * 1000000 / this->sample_rate_);
+  }
+
+ protected:
+  uint32_t sample_rate_;
+  uint32_t dma_buffer_frames_;
+  uint32_t anchor_us_;                // Time when the first of the frames_after_anchor_ frames started playing
+  uint32_t frames_after_anchor_{0};  // Frames written that play after anchor_us_
+  uint32_t pending_frames_{0};       // Frames written to the DMA buffers that haven't been sent yet
+};
+
 // Lists the Q15 fixed point scaling factor for volume reduction.
 // Has 100 values representing silence and a reduction [49, 48.5, ... 0.5, 0] dB.
 // dB to PCM scaling factor formula: floating_point_scale_factor = 2^(-db/6.014)
 // float to Q15 fixed point formula: q15_scale_factor = floating_point_scale_factor * 2^(15)
-static const std::vector<int16_t> Q15_VOLUME_SCALING_FACTORS = {
+// The last value, 0 dB, is exactly audio::Q15_UNITY_GAIN, so full volume skips the gain kernels.
+static const std::vector<int32_t> Q15_VOLUME_SCALING_FACTORS = {
     0,     116,   122,   130,   137,   146,   154,   163,   173,   183,   194,   206,   218,   231,   244,
     259,   274,   291,   308,   326,   345,   366,   388,   411,   435,   461,   488,   517,   548,   580,
     615,   651,   690,   731,   774,   820,   868,   920,   974,   1032,  1094,  1158,  1227,  1300,  1377,
     1459,  1545,  1637,  1734,  1837,  1946,  2061,  2184,  2313,  2450,  2596,  2750,  2913,  3085,  3269,
     3462,  3668,  3885,  4116,  4360,  4619,  4893,  5183,  5490,  5816,  6161,  6527,  6914,  7324,  7758,
     8218,  8706,  9222,  9770,  10349, 10963, 11613, 12302, 13032, 13805, 14624, 15491, 16410, 17384, 18415,
-    19508, 20665, 21891, 23189, 24565, 26022, 27566, 29201, 30933, 32767};
+    19508, 20665, 21891, 23189, 24565, 26022, 27566, 29201, 30933, audio::Q15_UNITY_GAIN};
 
 void I2SAudioSpeaker::setup() {
   ESP_LOGCONFIG(TAG, "Setting up I2S Audio Speaker...");
@@ -101,11 +155,25 @@ void I2SAudioSpeaker::setup() {
     this->mark_failed();
     return;
   }
+
+  this->write_lock_ = xSemaphoreCreateMutex();
+  if (this->write_lock_ == nullptr) {
+    ESP_LOGE(TAG, "Failed to create write lock");
+    this->mark_failed();
+    return;
+  }
 }
 
 void I2SAudioSpeaker::loop() {
   uint32_t event_group_bits = xEventGroupGetBits(this->event_group_);
 
+  // Checked first, since a warm speaker may already be starting the next stream
+  if (event_group_bits & SpeakerEventGroupBits::STATE_IDLE) {
+    ESP_LOGD(TAG, "Speaker idle, keeping the I2S driver warm");
+    this->state_ = speaker::STATE_STOPPED;
+    this->resuming_warm_ = false;
+    xEventGroupClearBits(this->event_group_, SpeakerEventGroupBits::STATE_IDLE);
+  }
   if (event_group_bits & SpeakerEventGroupBits::STATE_STARTING) {
     ESP_LOGD(TAG, "Starting Speaker");
     this->state_ = speaker::STATE_STARTING;
@@ -114,6 +182,7 @@ void I2SAudioSpeaker::loop() {
   if (event_group_bits & SpeakerEventGroupBits::STATE_RUNNING) {
     ESP_LOGD(TAG, "Started Speaker");
     this->state_ = speaker::STATE_RUNNING;
+    this->resuming_warm_ = false;
     xEventGroupClearBits(this->event_group_, SpeakerEventGroupBits::STATE_RUNNING);
     this->status_clear_warning();
     this->status_clear_error();
@@ -127,6 +196,7 @@ void I2SAudioSpeaker::loop() {
     if (!this->task_created_) {
       ESP_LOGD(TAG, "Stopped Speaker");
       this->state_ = speaker::STATE_STOPPED;
+      this->resuming_warm_ = false;
       xEventGroupClearBits(this->event_group_, SpeakerEventGroupBits::ALL_BITS);
       this->speaker_task_handle_ = nullptr;
     }
@@ -167,7 +237,7 @@ void I2SAudioSpeaker::set_volume(float volume) {
   {
     // Fallback to software volume control by using a Q15 fixed point scaling factor
     ssize_t decibel_index = remap<ssize_t, float>(volume, 0.0f, 1.0f, 0, Q15_VOLUME_SCALING_FACTORS.size() - 1);
-    this->q15_volume_factor_ = Q15_VOLUME_SCALING_FACTORS[decibel_index];
+    this->volume_ramp_.set_target(Q15_VOLUME_SCALING_FACTORS[decibel_index]);
   }
 }
 
@@ -185,7 +255,7 @@ void I2SAudioSpeaker::set_mute_state(bool mute_state) {
   {
     if (mute_state) {
       // Fallback to software volume control and scale by 0
-      this->q15_volume_factor_ = 0;
+      this->volume_ramp_.set_target(0);
     } else {
       // Revert to previous volume when unmuting
       this->set_volume(this->volume_);
@@ -193,6 +263,34 @@ void I2SAudioSpeaker::set_mute_state(bool mute_state) {
   }
 }
 
+void I2SAudioSpeaker::dump_telemetry() const {
+  ESP_LOGI(TAG, "Speaker telemetry:");
+  ESP_LOGI(TAG, "  DMA underflows: %" PRIu32, this->telemetry_.dma_underflows.load(std::memory_order_relaxed));
+  ESP_LOGI(TAG, "  Short writes: %" PRIu32, this->telemetry_.short_writes.load(std::memory_order_relaxed));
+  ESP_LOGI(TAG, "  Ring buffer empty reads: %" PRIu32,
+           this->telemetry_.ring_empty_reads.load(std::memory_order_relaxed));
+  ESP_LOGI(TAG, "  Loop time: %" PRIu32 " us, max %" PRIu32 " us",
+           this->telemetry_.loop_time_us.load(std::memory_order_relaxed),
+           this->telemetry_.max_loop_time_us.load(std::memory_order_relaxed));
+  ESP_LOGI(TAG, "  Ring buffer fill level before each read:");
+  const uint32_t bin_percent = 100 / TELEMETRY_FILL_LEVEL_BINS;
+  for (uint8_t i = 0; i < TELEMETRY_FILL_LEVEL_BINS; ++i) {
+    ESP_LOGI(TAG, "    %3" PRIu32 "-%3" PRIu32 "%%: %" PRIu32, i * bin_percent, (i + 1) * bin_percent,
+             this->telemetry_.fill_level_histogram[i].load(std::memory_order_relaxed));
+  }
+}
+
+void I2SAudioSpeaker::reset_telemetry() {
+  this->telemetry_.dma_underflows.store(0);
+  this->telemetry_.short_writes.store(0);
+  this->telemetry_.ring_empty_reads.store(0);
+  for (auto &bin : this->telemetry_.fill_level_histogram) {
+    bin.store(0);
+  }
+  this->telemetry_.loop_time_us.store(0);
+  this->telemetry_.max_loop_time_us.store(0);
+}
+
 size_t I2SAudioSpeaker::play(const uint8_t *data, size_t length, TickType_t ticks_to_wait) {
   if (this->is_failed()) {
     ESP_LOGE(TAG, "Cannot play audio, speaker failed to setup");
@@ -202,29 +300,63 @@ size_t I2SAudioSpeaker::play(const uint8_t *data, size_t length, TickType_t tick
     this->start();
   }
 
-  if ((this->state_ != speaker::STATE_RUNNING) || (this->audio_ring_buffer_.use_count() == 1)) {
+  // A warm speaker's ring buffer is already allocated, so audio can be buffered while its task resumes
+  const bool ready = (this->state_ == speaker::STATE_RUNNING) || this->resuming_warm_;
+
+  if (!ready) {
     // Unable to write data to a running speaker, so delay the max amount of time so it can get ready
     vTaskDelay(ticks_to_wait);
     ticks_to_wait = 0;
   }
 
+  // Only write whole frames, so audio from different producers never splits a frame
+  length -= length % this->audio_stream_info_.frames_to_bytes(1);
+
   size_t bytes_written = 0;
-  if ((this->state_ == speaker::STATE_RUNNING) && (this->audio_ring_buffer_.use_count() == 1)) {
-    // Only one owner of the ring buffer (the speaker task), so the ring buffer is allocated and no other components are
-    // attempting to write to it.
+  if (ready && (length > 0)) {
+    // Producers take turns writing, so a second producer waits for the first one's write instead of dropping its audio
+    const TickType_t lock_start = xTaskGetTickCount();
+    if (xSemaphoreTake(this->write_lock_, ticks_to_wait) != pdTRUE) {
+      return 0;
+    }
+    const TickType_t ticks_waited = xTaskGetTickCount() - lock_start;
+    ticks_to_wait = (ticks_waited < ticks_to_wait) ? ticks_to_wait - ticks_waited : 0;
 
     // Temporarily share ownership of the ring buffer so it won't be deallocated while writing
-    std::shared_ptr<RingBuffer> temp_ring_buffer = this->audio_ring_buffer_;
-    bytes_written = temp_ring_buffer->write_without_replacement((void *) data, length, ticks_to_wait);
-  }
+    std::shared_ptr<RingBuffer> temp_ring_buffer = std::atomic_load(&this->audio_ring_buffer_);
+    if (temp_ring_buffer != nullptr) {
+      bytes_written = temp_ring_buffer->write_without_replacement((void *) data, length, ticks_to_wait);
+    }
+
+    xSemaphoreGive(this->write_lock_);
 
-    return bytes_written;
+    const uint32_t stop_bits =
+        SpeakerEventGroupBits::COMMAND_STOP_GRACEFULLY | SpeakerEventGroupBits::STATE_STOP_PENDING;
+    if ((bytes_written > 0) && (xEventGroupGetBits(this->event_group_) & stop_bits)) {
+      // The next track started before the previous one drained, so keep the task running for gapless playback
+      xEventGroupClearBits(this->event_group_, SpeakerEventGroupBits::COMMAND_STOP_GRACEFULLY);
+      xEventGroupSetBits(this->event_group_, SpeakerEventGroupBits::COMMAND_CANCEL_STOP);
+    }
   }
 
+  return bytes_written;
+}
+
 bool I2SAudioSpeaker::has_buffered_data() const {
-  if (this->audio_ring_buffer_ != nullptr) {
-    return this->audio_ring_buffer_->available() > 0;
-    }
+  std::shared_ptr<RingBuffer> temp_ring_buffer = std::atomic_load(&this->audio_ring_buffer_);
+  if (temp_ring_buffer != nullptr) {
+    return temp_ring_buffer->available() > 0;
+  }
+  return false;
+}
+
+bool I2SAudioSpeaker::get_buffer_level(size_t *buffered_bytes, size_t *capacity_bytes) const {
+  std::shared_ptr<RingBuffer> temp_ring_buffer = std::atomic_load(&this->audio_ring_buffer_);
+  if (temp_ring_buffer != nullptr) {
+    *buffered_bytes = temp_ring_buffer->available();
+    *capacity_bytes = *buffered_bytes + temp_ring_buffer->free();
+    return true;
+  }
   return false;
 }
 
@@ -249,126 +381,301 @@ void I2SAudioSpeaker::speaker_task(void *params) {
 
   audio::AudioStreamInfo audio_stream_info = this_speaker->audio_stream_info_;
 
-  const uint32_t dma_buffers_duration_ms = DMA_BUFFER_DURATION_MS * DMA_BUFFERS_COUNT;
-  // Ensure ring buffer duration is at least the duration of all DMA buffers
-  const uint32_t ring_buffer_duration = std::max(dma_buffers_duration_ms, this_speaker->buffer_duration_ms_);
+  // Audio is read and written one DMA buffer at a time, so the buffers hold the driver's whole DMA queue in frames
+  const uint32_t dma_frame_num = this_speaker->get_dma_frame_num();
+  const uint32_t dma_queue_frames = this_speaker->get_dma_desc_num() * dma_frame_num;
 
   // The DMA buffers may have more bits per sample, so calculate buffer sizes based in the input audio stream info
-  const size_t data_buffer_size = audio_stream_info.ms_to_bytes(dma_buffers_duration_ms);
-  const size_t ring_buffer_size = audio_stream_info.ms_to_bytes(ring_buffer_duration);
+  const size_t stream_buffer_size = audio_stream_info.frames_to_bytes(dma_queue_frames);
+  const size_t ring_buffer_size = this_speaker->ring_buffer_size_for_(audio_stream_info);
+
+  // Also fit a stream in the bus's own format, so a later stream can switch to it without reallocating
+  const audio::AudioStreamInfo bus_stream_info(static_cast<uint8_t>(this_speaker->bits_per_sample_),
+                                               audio_stream_info.get_channels(), this_speaker->sample_rate_);
+  const size_t data_buffer_size = std::max(stream_buffer_size, bus_stream_info.frames_to_bytes(dma_queue_frames));
+
+  // Mixing inputs may be stereo even if the bus is mono, so size the scratch buffer for two channels per frame
+  size_t mix_buffer_size = 0;
+  if (!this_speaker->source_speakers_.empty()) {
+    mix_buffer_size = dma_queue_frames * 2 * sizeof(int16_t);
+  }
 
-  const size_t single_dma_buffer_input_size = data_buffer_size / DMA_BUFFERS_COUNT;
+  // Audio with fewer bits per sample than the bus is widened into a bus buffer, one DMA buffer at a time
+  const size_t bus_bytes_per_sample = static_cast<uint8_t>(this_speaker->bits_per_sample_) / 8;
+  size_t bus_buffer_size = 0;
+  if (audio_stream_info.samples_to_bytes(1) < bus_bytes_per_sample) {
+    bus_buffer_size = bus_stream_info.frames_to_bytes(dma_frame_num);
+  }
 
-  if (this_speaker->send_esp_err_to_event_group_(this_speaker->allocate_buffers_(data_buffer_size, ring_buffer_size))) {
+  if (this_speaker->send_esp_err_to_event_group_(this_speaker->allocate_buffers_(
+          data_buffer_size, ring_buffer_size, mix_buffer_size, bus_buffer_size))) {
     // Failed to allocate buffers
     xEventGroupSetBits(this_speaker->event_group_, SpeakerEventGroupBits::ERR_ESP_NO_MEM);
     this_speaker->delete_task_(data_buffer_size);
   }
 
   if (!this_speaker->send_esp_err_to_event_group_(this_speaker->start_i2s_driver_(audio_stream_info))) {
-    xEventGroupSetBits(this_speaker->event_group_, SpeakerEventGroupBits::STATE_RUNNING);
-
+    bool stream_info_changed = false;
+    bool stop_after_fade = false;
     bool stop_gracefully = false;
-    uint32_t last_data_received_time = millis();
-    bool tx_dma_underflow = false;
 
-    this_speaker->accumulated_frames_written_ = 0;
-
-    // Keep looping if paused, there is no timeout configured, or data was received more recently than the configured
-    // timeout
-    while (this_speaker->pause_state_ || !this_speaker->timeout_.has_value() ||
-           (millis() - last_data_received_time) <= this_speaker->timeout_.value()) {
-      event_group_bits = xEventGroupGetBits(this_speaker->event_group_);
+    // Plays one stream per pass. With keep warm, the task parks between streams with the I2S driver still installed. A
+    // new stream with a different sample rate or bits per sample reuses the buffers and driver if they fit.
+    do {
+      xEventGroupSetBits(this_speaker->event_group_, SpeakerEventGroupBits::STATE_RUNNING);
+
+      // The stream's format may change between passes, so the sizes derived from it are recomputed
+      const size_t pass_buffer_size = audio_stream_info.frames_to_bytes(dma_queue_frames);
+      const size_t single_dma_buffer_input_size = audio_stream_info.frames_to_bytes(dma_frame_num);
+      const uint32_t dma_buffer_duration_ms = frames_to_ms_ceil(audio_stream_info, dma_frame_num);
+      const uint32_t task_delay_ms = frames_to_ms_ceil(audio_stream_info, dma_queue_frames / 2);
+      // The fill level is relative to the buffer duration in this stream's format, which fits in the allocated ring
+      const size_t pass_ring_buffer_size = this_speaker->ring_buffer_size_for_(audio_stream_info);
+      const size_t input_bytes_per_sample = audio_stream_info.samples_to_bytes(1);
+      const bool widen = input_bytes_per_sample < bus_bytes_per_sample;
+
+      stream_info_changed = false;
+      stop_gracefully = false;
+      uint32_t last_data_received_time = millis();
+      bool tx_dma_underflow = false;
+
+      // Underflows only count as telemetry once audio is playing, not while the bus idles before a stream or paused
+      bool playing_audio = false;
+      bool ring_had_audio = false;
+      uint32_t loop_start_us = micros();
+
+      this_speaker->accumulated_frames_written_ = 0;
+#ifdef USE_AUDIO_TRACE
+      this_speaker->trace_blocks_ = 0;
+      this_speaker->trace_convert_blocks_ = 0;
+#endif
 
-      if (event_group_bits & SpeakerEventGroupBits::COMMAND_STOP) {
-        xEventGroupClearBits(this_speaker->event_group_, SpeakerEventGroupBits::COMMAND_STOP);
-        break;
-      }
-      if (event_group_bits & SpeakerEventGroupBits::COMMAND_STOP_GRACEFULLY) {
-        xEventGroupClearBits(this_speaker->event_group_, SpeakerEventGroupBits::COMMAND_STOP_GRACEFULLY);
-        stop_gracefully = true;
-      }
+      // Start the new stream at the requested volume rather than ramping from the previous stream's gain
+      this_speaker->volume_ramp_.jump_to_target();
+
+      // Start silent if paused, so resuming fades in
+      this_speaker->fade_ramp_.set_target(this_speaker->pause_state_ ? 0 : audio::Q15_UNITY_GAIN);
+      this_speaker->fade_ramp_.jump_to_target();
+      stop_after_fade = false;
+
+      DmaPresentationClock presentation_clock(audio_stream_info.get_sample_rate(), dma_frame_num);
+      // Writing more than this blocks until a DMA buffer finishes sending
+      const uint32_t dma_wait_frames = dma_queue_frames - dma_frame_num;
+
+      // Keep looping if paused, there is no timeout configured, or data was received more recently than the configured
+      // timeout
+      while (this_speaker->pause_state_ || !this_speaker->timeout_.has_value() ||
+             (millis() - last_data_received_time) <= this_speaker->timeout_.value()) {
+        const uint32_t now_us = micros();
+        this_speaker->telemetry_.loop_time_us.store(now_us - loop_start_us, std::memory_order_relaxed);
+        store_max(this_speaker->telemetry_.max_loop_time_us, now_us - loop_start_us);
+        loop_start_us = now_us;
+
+        event_group_bits = xEventGroupGetBits(this_speaker->event_group_);
+
+        if (event_group_bits & SpeakerEventGroupBits::COMMAND_STOP) {
+          xEventGroupClearBits(this_speaker->event_group_, SpeakerEventGroupBits::COMMAND_STOP);
+          // Keep playing until the output fades to silence
+          stop_after_fade = true;
+          if ((this_speaker->fade_duration_ms_ == 0) || (this_speaker->fade_ramp_.get_current() == 0)) {
+            break;
+          }
+        }
+        if (event_group_bits & SpeakerEventGroupBits::COMMAND_CANCEL_STOP) {
+          xEventGroupClearBits(this_speaker->event_group_,
+                               SpeakerEventGroupBits::COMMAND_CANCEL_STOP | SpeakerEventGroupBits::STATE_STOP_PENDING);
+          stop_gracefully = false;
+        }
+        if (event_group_bits & SpeakerEventGroupBits::COMMAND_STOP_GRACEFULLY) {
+          // Checked after the cancel command, so a stop requested after the latest play() still wins
+          xEventGroupClearBits(this_speaker->event_group_, SpeakerEventGroupBits::COMMAND_STOP_GRACEFULLY);
+          xEventGroupSetBits(this_speaker->event_group_, SpeakerEventGroupBits::STATE_STOP_PENDING);
+          stop_gracefully = true;
+        }
 
-      if (this_speaker->audio_stream_info_ != audio_stream_info) {
-        // Audio stream info changed, stop the speaker task so it will restart with the proper settings.
-        break;
-      }
+        if (this_speaker->audio_stream_info_ != audio_stream_info) {
+          // Audio stream info changed, so reconfigure for the new stream or restart the task with the proper settings
+          stream_info_changed = true;
+          break;
+        }
 
-      this_speaker->parent_->process_i2s_events(tx_dma_underflow);
-      
+        presentation_clock.on_buffers_sent(this_speaker->parent_->process_i2s_events(tx_dma_underflow), false);
+        if (tx_dma_underflow) {
+          presentation_clock.on_underflow();
+        }
 
-      if (this_speaker->pause_state_) {
-        // Pause state is accessed atomically, so thread safe
-        // Delay so the task can yields, then skip transferring audio data
-        delay(TASK_DELAY_MS);
-        continue;
-      }
 
-      size_t bytes_read = this_speaker->audio_ring_buffer_->read((void *) this_speaker->data_buffer_, data_buffer_size,
-                                                                 pdMS_TO_TICKS(TASK_DELAY_MS));
-      
-      if ( bytes_read > 0) {
-        if ((audio_stream_info.get_bits_per_sample() == 16) && (this_speaker->q15_volume_factor_ < INT16_MAX)) {
-          // Scale samples by the volume factor in place
-          q15_multiplication((int16_t *) this_speaker->data_buffer_, (int16_t *) this_speaker->data_buffer_,
-                             bytes_read / sizeof(int16_t), this_speaker->q15_volume_factor_);
+        // Fade out before pausing or stopping and fade back in when resuming
+        const int32_t fade_target = (stop_after_fade || this_speaker->pause_state_) ? 0 : audio::Q15_UNITY_GAIN;
+        if (this_speaker->fade_ramp_.get_target() != fade_target) {
+          this_speaker->fade_ramp_.set_target(fade_target);
         }
+        const bool faded_out = (this_speaker->fade_duration_ms_ == 0) || (this_speaker->fade_ramp_.get_current() == 0);
 
-        // Write the audio data to a single DMA buffer at a time to reduce latency for the audio duration played
-        // callback.
-        const uint32_t batches = (bytes_read + single_dma_buffer_input_size - 1) / single_dma_buffer_input_size;
-
-        for (uint32_t i = 0; i < batches; ++i) {
-          size_t bytes_written = 0;
-          size_t bytes_to_write = std::min(single_dma_buffer_input_size, bytes_read);
-
-        if (audio_stream_info.get_bits_per_sample() == (uint8_t) this_speaker->bits_per_sample_) {
-            i2s_write(this_speaker->parent_->get_port(), this_speaker->data_buffer_ + i * single_dma_buffer_input_size,
-                      bytes_to_write, &bytes_written, pdMS_TO_TICKS(DMA_BUFFER_DURATION_MS * 5));
-        } else if (audio_stream_info.get_bits_per_sample() < (uint8_t) this_speaker->bits_per_sample_) {
-            i2s_write_expand(this_speaker->parent_->get_port(),
-                             this_speaker->data_buffer_ + i * single_dma_buffer_input_size, bytes_to_write,
-                           audio_stream_info.get_bits_per_sample(), this_speaker->bits_per_sample_, &bytes_written,
-                             pdMS_TO_TICKS(DMA_BUFFER_DURATION_MS * 5));
+        if (stop_after_fade && faded_out) {
+          break;
         }
 
-          uint32_t write_timestamp = micros();
-
-          if (bytes_written != bytes_to_write) {
-          xEventGroupSetBits(this_speaker->event_group_, SpeakerEventGroupBits::ERR_ESP_INVALID_SIZE);
+        if (this_speaker->pause_state_ && faded_out) {
+          // Pause state is accessed atomically, so thread safe
+          // Delay so the task can yields, then skip transferring audio data
+          playing_audio = false;
+          delay(task_delay_ms);
+          continue;
         }
 
-          bytes_read -= bytes_written;
+        // Don't block on the speaker's own ring buffer while mixing inputs are waiting to be played
+        const bool mixing = this_speaker->has_active_sources_();
+        const size_t buffered_bytes = this_speaker->audio_ring_buffer_->available();
+        const size_t fill_level_bin = std::min<size_t>(
+            buffered_bytes * TELEMETRY_FILL_LEVEL_BINS / pass_ring_buffer_size, TELEMETRY_FILL_LEVEL_BINS - 1);
+        this_speaker->telemetry_.fill_level_histogram[fill_level_bin].fetch_add(1, std::memory_order_relaxed);
 
-          this_speaker->accumulated_frames_written_ += audio_stream_info.bytes_to_frames(bytes_written);
-          const uint32_t new_playback_ms =
-              audio_stream_info.frames_to_milliseconds_with_remainder(&this_speaker->accumulated_frames_written_);
-          const uint32_t remainder_us =
-              audio_stream_info.frames_to_microseconds(this_speaker->accumulated_frames_written_);
+        size_t bytes_read = this_speaker->audio_ring_buffer_->read(
+            (void *) this_speaker->data_buffer_, pass_buffer_size, mixing ? 0 : pdMS_TO_TICKS(task_delay_ms));
 
-          uint32_t pending_frames =
-              audio_stream_info.bytes_to_frames(bytes_read + this_speaker->audio_ring_buffer_->available());
-          const uint32_t pending_ms = audio_stream_info.frames_to_milliseconds_with_remainder(&pending_frames);
+        // Only the speaker's own audio counts toward its audio output callback
+        size_t main_bytes_pending = bytes_read;
 
-          this_speaker->audio_output_callback_(new_playback_ms, remainder_us, pending_ms, write_timestamp);
+        if ((bytes_read == 0) && ring_had_audio && !stop_gracefully && !stop_after_fade) {
+          this_speaker->telemetry_.ring_empty_reads.fetch_add(1, std::memory_order_relaxed);
+        }
+        ring_had_audio = bytes_read > 0;
 
-        tx_dma_underflow = false;
-        last_data_received_time = millis();
+        if (mixing) {
+          bytes_read = this_speaker->mix_sources_(bytes_read, audio_stream_info, pass_buffer_size);
+        }
+
+        if (bytes_read > 0) {
+          int32_t bus_gain = audio::Q15_UNITY_GAIN;
+          if (widen && !this_speaker->volume_ramp_.is_ramping() && !this_speaker->fade_ramp_.is_ramping()) {
+            // The gain is steady, so scale while widening instead of making a separate pass over the samples
+            bus_gain = static_cast<int32_t>((static_cast<int64_t>(this_speaker->volume_ramp_.get_steady_gain()) *
+                                             this_speaker->fade_ramp_.get_steady_gain()) >>
+                                            15);
+          } else {
+            // Scale samples by the software volume in place, ramping toward the latest volume to avoid zipper noise
+            this_speaker->volume_ramp_.apply(this_speaker->data_buffer_, bytes_read, audio_stream_info);
+            this_speaker->fade_ramp_.apply(this_speaker->data_buffer_, bytes_read, audio_stream_info);
+          }
+
+          // Write the audio data to a single DMA buffer at a time to reduce latency for the audio duration played
+          // callback.
+          const uint32_t batches = (bytes_read + single_dma_buffer_input_size - 1) / single_dma_buffer_input_size;
+          uint32_t presentation_timestamp = micros();
+          // Offset of the next unwritten byte, so a short write is retried from where it stopped
+          size_t bytes_consumed = 0;
+
+          for (uint32_t i = 0; i < batches; ++i) {
+            AUDIO_TRACE_SCOPE(trace, SPEAKER_WRITE, this_speaker, &this_speaker->trace_blocks_);
+
+            size_t bytes_written = 0;
+            size_t bytes_to_write = std::min(single_dma_buffer_input_size, bytes_read);
+
+            const uint32_t frames_to_write = audio_stream_info.bytes_to_frames(bytes_to_write);
+            presentation_clock.on_buffers_sent(this_speaker->parent_->process_i2s_events(tx_dma_underflow), false);
+            if (presentation_clock.get_pending_frames() + frames_to_write > dma_wait_frames) {
+              // The write would block until a DMA buffer is sent, so wait for that event instead to timestamp it
+              presentation_clock.on_buffers_sent(this_speaker->parent_->process_i2s_events(
+                                                     tx_dma_underflow, pdMS_TO_TICKS(dma_buffer_duration_ms * 5)),
+                                                 true);
+            }
+            if (tx_dma_underflow) {
+              presentation_clock.on_underflow();
+              if (playing_audio) {
+                this_speaker->telemetry_.dma_underflows.fetch_add(1, std::memory_order_relaxed);
+              }
+            }
+
+            const uint8_t *bus_data = this_speaker->data_buffer_ + bytes_consumed;
+            if (audio_stream_info.get_bits_per_sample() == (uint8_t) this_speaker->bits_per_sample_) {
+              i2s_channel_write(this_speaker->parent_->get_tx_handle(), bus_data, bytes_to_write, &bytes_written,
+                                dma_buffer_duration_ms * 5);
+            } else if (widen) {
+              const size_t samples = audio_stream_info.bytes_to_samples(bytes_to_write);
+              {
+                AUDIO_TRACE_SCOPE(convert_trace, SPEAKER_CONVERT, this_speaker, &this_speaker->trace_convert_blocks_);
+                audio::widen_audio_samples(bus_data, input_bytes_per_sample, this_speaker->bus_buffer_,
+                                           bus_bytes_per_sample, samples, bus_gain);
+                AUDIO_TRACE_ADD_BYTES(convert_trace, bytes_to_write);
+              }
+
+              size_t bus_bytes_written = 0;
+              i2s_channel_write(this_speaker->parent_->get_tx_handle(), this_speaker->bus_buffer_,
+                                samples * bus_bytes_per_sample, &bus_bytes_written, dma_buffer_duration_ms * 5);
+              bytes_written = bus_bytes_written / bus_bytes_per_sample * input_bytes_per_sample;
+              bus_data = this_speaker->bus_buffer_;
+            }
+
+            const uint32_t frames_written = audio_stream_info.bytes_to_frames(bytes_written);
+            presentation_timestamp = presentation_clock.on_frames_written(frames_written);
+            if (frames_written > 0) {
+              this_speaker->stamp_tx_block_(bus_data, frames_written, presentation_timestamp);
+            }
+            AUDIO_TRACE_ADD_BYTES(trace, bytes_written);
+
+            if (bytes_written != bytes_to_write) {
+              xEventGroupSetBits(this_speaker->event_group_, SpeakerEventGroupBits::ERR_ESP_INVALID_SIZE);
+              this_speaker->telemetry_.short_writes.fetch_add(1, std::memory_order_relaxed);
+            }
+            playing_audio = playing_audio || (bytes_written > 0);
+
+            bytes_consumed += bytes_written;
+            bytes_read -= bytes_written;
+
+            const size_t main_bytes_written = std::min(bytes_written, main_bytes_pending);
+            main_bytes_pending -= main_bytes_written;
+
+            if (main_bytes_written > 0) {
+              this_speaker->accumulated_frames_written_ += audio_stream_info.bytes_to_frames(main_bytes_written);
+              const uint32_t new_playback_ms =
+                  audio_stream_info.frames_to_milliseconds_with_remainder(&this_speaker->accumulated_frames_written_);
+              const uint32_t remainder_us =
+                  audio_stream_info.frames_to_microseconds(this_speaker->accumulated_frames_written_);
+
+              uint32_t pending_frames =
+                  audio_stream_info.bytes_to_frames(main_bytes_pending + this_speaker->audio_ring_buffer_->available());
+              const uint32_t pending_ms = audio_stream_info.frames_to_milliseconds_with_remainder(&pending_frames);
+
+              this_speaker->audio_output_callback_(new_playback_ms, remainder_us, pending_ms, presentation_timestamp);
+            }
+
+            tx_dma_underflow = false;
+            last_data_received_time = millis();
+          }
+
+          if (mixing) {
+            for (auto *source_speaker : this_speaker->source_speakers_) {
+              source_speaker->report_mixed_frames_(presentation_timestamp);
+            }
+          }
+        } else {
+          // No data received
+          if (stop_after_fade) {
+            // Nothing left to fade out
+            break;
+          }
+          if (stop_gracefully && tx_dma_underflow) {
+            break;
+          }
+          if (mixing) {
+            // The ring buffer reads didn't block, so yield while the active inputs wait for more audio
+            delay(dma_buffer_duration_ms);
+          }
         }
-      } else {
-        // No data received
-        if (stop_gracefully && tx_dma_underflow) {
-      break;
-    }
       }
-    }
+      // A stream whose format changed mid playback continues in place unless it was stopping anyway; otherwise the task
+      // parks if keep warm is set. Either way, it restarts from scratch if the new format can't reuse the driver.
+    } while ((stream_info_changed ? !stop_gracefully
+                                  : this_speaker->wait_while_warm_(audio_stream_info, stop_after_fade)) &&
+             this_speaker->reconfigure_stream_(audio_stream_info, data_buffer_size));
 
     xEventGroupSetBits(this_speaker->event_group_, SpeakerEventGroupBits::STATE_STOPPING);
 
     this_speaker->uninstall_i2s_driver();
     this_speaker->release_i2s_access();
   }
-  
+
   this_speaker->delete_task_(data_buffer_size);
 }
 
@@ -378,14 +685,25 @@ void I2SAudioSpeaker::start() {
   if ((this->state_ == speaker::STATE_STARTING) || (this->state_ == speaker::STATE_RUNNING))
     return;
 
+  if (this->warm_.exchange(false)) {
+    // Resume the parked task. It stops instead if the stream needs different I2S settings, and the next play()
+    // restarts it.
+    if (this->audio_stream_info_ == this->warm_stream_info_) {
+      this->state_ = speaker::STATE_STARTING;
+      this->resuming_warm_ = true;
+    }
+    xEventGroupSetBits(this->event_group_, SpeakerEventGroupBits::COMMAND_START);
+    return;
+  }
+
   if (!this->task_created_ && (this->speaker_task_handle_ == nullptr)) {
     xTaskCreate(I2SAudioSpeaker::speaker_task, "speaker_task", TASK_STACK_SIZE, (void *) this, TASK_PRIORITY,
                 &this->speaker_task_handle_);
 
-  if (this->speaker_task_handle_ != nullptr) {
-    xEventGroupSetBits(this->event_group_, SpeakerEventGroupBits::COMMAND_START);
-  } else {
-    xEventGroupSetBits(this->event_group_, SpeakerEventGroupBits::ERR_TASK_FAILED_TO_START);
+    if (this->speaker_task_handle_ != nullptr) {
+      xEventGroupSetBits(this->event_group_, SpeakerEventGroupBits::COMMAND_START);
+    } else {
+      xEventGroupSetBits(this->event_group_, SpeakerEventGroupBits::ERR_TASK_FAILED_TO_START);
     }
   }
 }
@@ -407,6 +725,109 @@ void I2SAudioSpeaker::stop_(bool wait_on_empty) {
   }
 }
 
+bool I2SAudioSpeaker::wait_while_warm_(const audio::AudioStreamInfo &audio_stream_info, bool discard_buffered) {
+  if (this->keep_warm_ms_ == 0) {
+    return false;
+  }
+
+  if (discard_buffered) {
+    this->audio_ring_buffer_->reset();
+  }
+
+  // Commands sent for the finished stream don't apply to the next one
+  xEventGroupClearBits(this->event_group_,
+                       SpeakerEventGroupBits::COMMAND_START | SpeakerEventGroupBits::COMMAND_STOP |
+                           SpeakerEventGroupBits::COMMAND_STOP_GRACEFULLY | SpeakerEventGroupBits::COMMAND_CANCEL_STOP |
+                           SpeakerEventGroupBits::STATE_STOP_PENDING);
+
+  this->warm_stream_info_ = audio_stream_info;
+  this->warm_ = true;
+  xEventGroupSetBits(this->event_group_, SpeakerEventGroupBits::STATE_IDLE);
+
+  // The driver clears each DMA buffer after sending it, so the bus outputs silence without any writes
+  const uint32_t task_delay_ms =
+      frames_to_ms_ceil(audio_stream_info, this->get_dma_desc_num() * this->get_dma_frame_num() / 2);
+  const uint32_t idle_start = millis();
+  bool tx_dma_underflow = false;
+  while ((millis() - idle_start) < this->keep_warm_ms_) {
+    const uint32_t event_group_bits =
+        xEventGroupWaitBits(this->event_group_, SpeakerEventGroupBits::COMMAND_START, pdFALSE, pdFALSE,
+                            pdMS_TO_TICKS(task_delay_ms));
+    this->parent_->process_i2s_events(tx_dma_underflow);
+    if (event_group_bits & SpeakerEventGroupBits::COMMAND_START) {
+      break;
+    }
+  }
+
+  if (this->warm_.exchange(false)) {
+    // Nothing started the speaker while it was warm
+    return false;
+  }
+
+  // start() resumed the task, possibly just as the keep warm duration ran out, so wait for its command
+  xEventGroupWaitBits(this->event_group_, SpeakerEventGroupBits::COMMAND_START, pdTRUE, pdFALSE, portMAX_DELAY);
+
+  xEventGroupSetBits(this->event_group_, SpeakerEventGroupBits::STATE_STARTING);
+  return true;
+}
+
+bool I2SAudioSpeaker::reconfigure_stream_(audio::AudioStreamInfo &audio_stream_info, size_t data_buffer_size) {
+  const audio::AudioStreamInfo new_stream_info = this->audio_stream_info_;
+  if (new_stream_info == audio_stream_info) {
+    return true;
+  }
+
+  if (new_stream_info.get_channels() != audio_stream_info.get_channels()) {
+    // The driver's channel format must change
+    return false;
+  }
+
+  // The new stream's DMA buffers must fit in the allocated data and bus buffers
+  const size_t stream_buffer_size =
+      new_stream_info.frames_to_bytes(this->get_dma_desc_num() * this->get_dma_frame_num());
+  const size_t input_bytes_per_sample = new_stream_info.samples_to_bytes(1);
+  const size_t bus_bytes_per_sample = static_cast<uint8_t>(this->bits_per_sample_) / 8;
+  if ((stream_buffer_size > data_buffer_size) || (input_bytes_per_sample > bus_bytes_per_sample)) {
+    return false;
+  }
+  if (this->ring_buffer_size_for_(new_stream_info) > this->ring_buffer_size_) {
+    // The ring buffer was sized for an earlier stream's format and can't hold the buffer duration of this one
+    return false;
+  }
+  if (input_bytes_per_sample < bus_bytes_per_sample) {
+    // Sized like the speaker task sizes it, one DMA buffer in the bus's format
+    const audio::AudioStreamInfo bus_stream_info(static_cast<uint8_t>(this->bits_per_sample_),
+                                                 new_stream_info.get_channels(), this->sample_rate_);
+    if ((this->bus_buffer_ == nullptr) &&
+        (this->allocate_buffers_(data_buffer_size, 0, 0, bus_stream_info.frames_to_bytes(this->get_dma_frame_num())) !=
+         ESP_OK)) {
+      return false;
+    }
+  }
+
+  if (new_stream_info.get_sample_rate() != audio_stream_info.get_sample_rate()) {
+    if (this->i2s_role_ == I2S_ROLE_SLAVE) {
+      if (new_stream_info.get_sample_rate() != this->sample_rate_) {
+        // Restarting reports that the externally clocked bus can't play the stream
+        return false;
+      }
+    } else if (this->is_adjustable() && !this->reconfigure_i2s_clock(new_stream_info.get_sample_rate())) {
+      return false;
+    }
+  }
+
+  // Audio buffered for the previous stream is in the old format
+  this->audio_ring_buffer_->reset();
+  audio_stream_info = new_stream_info;
+  return true;
+}
+
+size_t I2SAudioSpeaker::ring_buffer_size_for_(const audio::AudioStreamInfo &audio_stream_info) const {
+  const uint32_t dma_buffers_duration_ms =
+      frames_to_ms_ceil(audio_stream_info, this->get_dma_desc_num() * this->get_dma_frame_num());
+  return audio_stream_info.ms_to_bytes(std::max(dma_buffers_duration_ms, this->buffer_duration_ms_));
+}
+
 bool I2SAudioSpeaker::send_esp_err_to_event_group_(esp_err_t err) {
   switch (err) {
     case ESP_OK:
@@ -432,7 +853,8 @@ bool I2SAudioSpeaker::send_esp_err_to_event_group_(esp_err_t err) {
   }
 }
 
-esp_err_t I2SAudioSpeaker::allocate_buffers_(size_t data_buffer_size, size_t ring_buffer_size) {
+esp_err_t I2SAudioSpeaker::allocate_buffers_(size_t data_buffer_size, size_t ring_buffer_size,
+                                             size_t mix_buffer_size, size_t bus_buffer_size) {
   if (this->data_buffer_ == nullptr) {
     // Allocate data buffer for temporarily storing audio from the ring buffer before writing to the I2S bus
     ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
@@ -443,40 +865,197 @@ esp_err_t I2SAudioSpeaker::allocate_buffers_(size_t data_buffer_size, size_t rin
     return ESP_ERR_NO_MEM;
   }
 
-  if (this->audio_ring_buffer_.use_count() == 0) {
-    // Allocate ring buffer. Uses a shared_ptr to ensure it isn't improperly deallocated.
-    this->audio_ring_buffer_ = RingBuffer::create(ring_buffer_size);
+  if (this->audio_ring_buffer_ == nullptr) {
+    // Allocate ring buffer. Uses a shared_ptr to ensure it isn't improperly deallocated, and is published atomically
+    // since producers load it from other tasks.
+    std::atomic_store(&this->audio_ring_buffer_, std::shared_ptr<RingBuffer>(RingBuffer::create(ring_buffer_size)));
+    this->ring_buffer_size_ = ring_buffer_size;
   }
 
   if (this->audio_ring_buffer_ == nullptr) {
     return ESP_ERR_NO_MEM;
   }
 
+  if ((mix_buffer_size > 0) && (this->mix_buffer_ == nullptr)) {
+    ExternalRAMAllocator<int16_t> allocator(ExternalRAMAllocator<int16_t>::ALLOW_FAILURE);
+    this->mix_buffer_ = allocator.allocate(mix_buffer_size / sizeof(int16_t));
+    if (this->mix_buffer_ == nullptr) {
+      return ESP_ERR_NO_MEM;
+    }
+    this->mix_buffer_size_ = mix_buffer_size;
+  }
+
+  if ((bus_buffer_size > 0) && (this->bus_buffer_ == nullptr)) {
+    // Allocated in internal RAM, since it is written and handed to the I2S driver for every DMA buffer
+    RAMAllocator<uint8_t> allocator(RAMAllocator<uint8_t>::ALLOW_FAILURE | RAMAllocator<uint8_t>::ALLOC_INTERNAL);
+    this->bus_buffer_ = allocator.allocate(bus_buffer_size);
+    if (this->bus_buffer_ == nullptr) {
+      return ESP_ERR_NO_MEM;
+    }
+    this->bus_buffer_size_ = bus_buffer_size;
+  }
+
   return ESP_OK;
 }
 
 esp_err_t I2SAudioSpeaker::start_i2s_driver_(audio::AudioStreamInfo &audio_stream_info) {
-  if ((this->i2s_clk_mode_ & I2S_MODE_SLAVE) && (this->sample_rate_ != audio_stream_info.get_sample_rate())) {  // NOLINT
+  AUDIO_TRACE_START_SCOPE(trace, SPEAKER_START, this);
+
+  if ((this->i2s_role_ == I2S_ROLE_SLAVE) && (this->sample_rate_ != audio_stream_info.get_sample_rate())) {
     // Can't reconfigure I2S bus, so the sample rate must match the configured value
     return ESP_ERR_NOT_SUPPORTED;
   }
-  
+
+  if (audio_stream_info.get_bits_per_sample() > (uint8_t) this->bits_per_sample_) {
+    // Samples are only widened to the bus's bits per sample, never narrowed
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+
   if (!this->claim_i2s_access()) {
     return ESP_ERR_INVALID_STATE;
   }
 
-  i2s_driver_config_t config = this->get_i2s_cfg();
-  if(!this->install_i2s_driver(config))
+  uint32_t sample_rate = this->sample_rate_;
+  if (this->is_adjustable() && (this->i2s_role_ == I2S_ROLE_MASTER)) {
+    // Clock the bus at the stream's sample rate, so the stream can later switch rates by reconfiguring the clock
+    sample_rate = audio_stream_info.get_sample_rate();
+  }
+  if(!this->install_i2s_driver(sample_rate))
   {
     this->release_i2s_access();
     return ESP_ERR_INVALID_STATE;
   }
-  
+
   return ESP_OK;
 }
 
+bool I2SAudioSpeaker::has_active_sources_() const {
+  for (auto *source_speaker : this->source_speakers_) {
+    if (source_speaker->active_) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t I2SAudioSpeaker::mix_sources_(size_t main_bytes, const audio::AudioStreamInfo &audio_stream_info,
+                                     size_t data_buffer_size) {
+  if (this->mix_buffer_ == nullptr) {
+    return main_bytes;
+  }
+
+  const uint32_t max_frames = std::min<uint32_t>(audio_stream_info.bytes_to_frames(data_buffer_size),
+                                                 this->mix_buffer_size_ / (2 * sizeof(int16_t)));
+  int16_t *output = reinterpret_cast<int16_t *>(this->data_buffer_);
+  size_t mixed_bytes = main_bytes;
+
+  for (auto *source_speaker : this->source_speakers_) {
+    if (!source_speaker->active_) {
+      continue;
+    }
+
+    audio::GainRamp &fade_ramp = source_speaker->fade_ramp_;
+    if (source_speaker->started_.exchange(false)) {
+      const uint32_t start_fade_ms = source_speaker->start_fade_ms_.load(std::memory_order_relaxed);
+      fade_ramp.set_ramp(source_speaker->fade_type_, start_fade_ms);
+      fade_ramp.set_current(start_fade_ms > 0 ? 0 : audio::Q15_UNITY_GAIN);
+      fade_ramp.set_target(audio::Q15_UNITY_GAIN);
+      // A new stream may have a different format or come from a producer with a different clock offset
+      source_speaker->stream_configured_ = false;
+    }
+
+    // Fade out before pausing or stopping and fade back in when resuming
+    const bool stopping = source_speaker->stop_requested_;
+    const uint32_t fade_ms =
+        stopping ? source_speaker->stop_fade_ms_.load(std::memory_order_relaxed) : source_speaker->fade_duration_ms_;
+    const int32_t fade_target = (stopping || source_speaker->pause_state_) ? 0 : audio::Q15_UNITY_GAIN;
+    if (fade_ramp.get_target() != fade_target) {
+      fade_ramp.set_ramp(source_speaker->fade_type_, fade_ms);
+      fade_ramp.set_target(fade_target);
+    }
+    const bool faded_out = (fade_ms == 0) || (fade_ramp.get_current() == 0);
+
+    if (stopping && faded_out) {
+      if (source_speaker->stop_requested_.exchange(false)) {
+        source_speaker->reset_stream_();
+      }
+      continue;
+    }
+
+    if (source_speaker->pause_state_ && faded_out) {
+      continue;
+    }
+
+    const audio::AudioStreamInfo &source_stream_info = source_speaker->audio_stream_info_;
+    if ((audio_stream_info.get_bits_per_sample() != 16) || (source_stream_info.get_bits_per_sample() != 16) ||
+        (source_stream_info.get_sample_rate() != audio_stream_info.get_sample_rate()) ||
+        (source_stream_info.get_channels() > 2)) {
+      // Can't mix this input into the current stream, so discard its audio rather than stalling its producer
+      source_speaker->ring_buffer_->reset();
+      source_speaker->format_mismatch_ = true;
+      continue;
+    }
+
+    // Duck by the strongest reduction requested for this input or by any other active input's sidechain
+    int32_t duck_gain = source_speaker->requested_duck_gain_.load(std::memory_order_relaxed);
+    uint32_t duck_duration_ms = source_speaker->requested_duck_duration_ms_.load(std::memory_order_relaxed);
+    for (auto *other_speaker : this->source_speakers_) {
+      if ((other_speaker != source_speaker) && other_speaker->active_ && !other_speaker->pause_state_ &&
+          (other_speaker->sidechain_duck_gain_ < duck_gain)) {
+        duck_gain = other_speaker->sidechain_duck_gain_;
+        duck_duration_ms = other_speaker->sidechain_duck_duration_ms_;
+      }
+    }
+    if (duck_gain != source_speaker->duck_ramp_.get_target()) {
+      if (duck_gain > source_speaker->duck_ramp_.get_target()) {
+        // Releasing a sidechain duck has no duration of its own, so reuse the duration it was applied with
+        duck_duration_ms = std::max(duck_duration_ms, source_speaker->duck_duration_ms_);
+      }
+      source_speaker->duck_duration_ms_ = duck_duration_ms;
+      source_speaker->duck_ramp_.set_ramp(audio::GainRampType::LINEAR, duck_duration_ms);
+      source_speaker->duck_ramp_.set_target(duck_gain);
+    }
+
+    const uint32_t frames_read =
+        source_speaker->read_frames_(this->mix_buffer_, max_frames, audio_stream_info.get_channels());
+    const audio::AudioStreamInfo &mix_stream_info = source_speaker->mix_stream_info_;
+
+    if (frames_read == 0) {
+      if (stopping) {
+        // Nothing left to fade out
+        if (source_speaker->stop_requested_.exchange(false)) {
+          source_speaker->reset_stream_();
+        }
+      } else if (source_speaker->finish_requested_.exchange(false)) {
+        source_speaker->active_ = false;
+      }
+      continue;
+    }
+
+    const size_t mix_bytes = mix_stream_info.frames_to_bytes(frames_read);
+    source_speaker->duck_ramp_.apply(reinterpret_cast<uint8_t *>(this->mix_buffer_), mix_bytes, mix_stream_info);
+    fade_ramp.apply(reinterpret_cast<uint8_t *>(this->mix_buffer_), mix_bytes, mix_stream_info);
+
+    // Silence the part of the data buffer that no earlier input has written to
+    const size_t output_bytes = audio_stream_info.frames_to_bytes(frames_read);
+    if (output_bytes > mixed_bytes) {
+      memset(this->data_buffer_ + mixed_bytes, 0, output_bytes - mixed_bytes);
+      mixed_bytes = output_bytes;
+    }
+
+    audio::mix_audio_s16(this->mix_buffer_, mix_stream_info.get_channels(), output,
+                         audio_stream_info.get_channels(), frames_read);
+    source_speaker->frames_mixed_ += frames_read;
+  }
+
+  return mixed_bytes;
+}
+
 void I2SAudioSpeaker::delete_task_(size_t buffer_size) {
-  this->audio_ring_buffer_.reset();  // Releases ownership of the shared_ptr
+  // Releases ownership of the shared_ptr; a producer that is still writing keeps the ring buffer alive until it
+  // finishes
+  std::atomic_store(&this->audio_ring_buffer_, std::shared_ptr<RingBuffer>());
+  this->ring_buffer_size_ = 0;
 
   if (this->data_buffer_ != nullptr) {
     ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
@@ -484,12 +1063,326 @@ void I2SAudioSpeaker::delete_task_(size_t buffer_size) {
     this->data_buffer_ = nullptr;
   }
 
+  if (this->mix_buffer_ != nullptr) {
+    ExternalRAMAllocator<int16_t> allocator(ExternalRAMAllocator<int16_t>::ALLOW_FAILURE);
+    allocator.deallocate(this->mix_buffer_, this->mix_buffer_size_ / sizeof(int16_t));
+    this->mix_buffer_ = nullptr;
+    this->mix_buffer_size_ = 0;
+  }
+
+  if (this->bus_buffer_ != nullptr) {
+    RAMAllocator<uint8_t> allocator(RAMAllocator<uint8_t>::ALLOW_FAILURE | RAMAllocator<uint8_t>::ALLOC_INTERNAL);
+    allocator.deallocate(this->bus_buffer_, this->bus_buffer_size_);
+    this->bus_buffer_ = nullptr;
+    this->bus_buffer_size_ = 0;
+  }
+
   xEventGroupSetBits(this->event_group_, SpeakerEventGroupBits::STATE_STOPPED);
 
   this->task_created_ = false;
   vTaskDelete(nullptr);
 }
 
+void I2SSourceSpeaker::setup() {
+  ESP_LOGCONFIG(SOURCE_TAG, "Setting up I2S Source Speaker...");
+
+  this->audio_stream_info_ = this->parent_->get_mixing_stream_info();
+
+  // Size the ring buffer for stereo audio, so either mono or stereo input holds at least the configured duration
+  const audio::AudioStreamInfo ring_buffer_stream_info(16, 2, this->audio_stream_info_.get_sample_rate());
+  this->ring_buffer_ = RingBuffer::create(ring_buffer_stream_info.ms_to_bytes(this->buffer_duration_ms_));
+
+  if (this->ring_buffer_ == nullptr) {
+    ESP_LOGE(SOURCE_TAG, "Failed to allocate ring buffer");
+    this->mark_failed();
+    return;
+  }
+
+  if (this->drift_compensation_) {
+    this->drift_compensator_ = make_unique<audio::DriftCompensator>();
+    this->drift_compensator_->set_target_fill_level(this->drift_target_fill_level_);
+  }
+
+  if (this->drift_compensation_ || !this->channel_matrix_.empty()) {
+    // Read for every mixed frame, so keep it in internal memory
+    RAMAllocator<int16_t> allocator(RAMAllocator<int16_t>::ALLOC_INTERNAL);
+    this->staging_buffer_ = allocator.allocate(STAGING_FRAMES * 2);
+    if (this->staging_buffer_ == nullptr) {
+      ESP_LOGE(SOURCE_TAG, "Failed to allocate staging buffer");
+      this->mark_failed();
+      return;
+    }
+  }
+}
+
+void I2SSourceSpeaker::dump_config() {
+  ESP_LOGCONFIG(SOURCE_TAG, "I2S Source Speaker:");
+  ESP_LOGCONFIG(SOURCE_TAG, "  Buffer duration: %" PRIu32 " ms", this->buffer_duration_ms_);
+  if (this->sidechain_decibel_reduction_ > 0) {
+    ESP_LOGCONFIG(SOURCE_TAG, "  Sidechain ducking: %" PRIu8 " dB over %" PRIu32 " ms",
+                  this->sidechain_decibel_reduction_, this->sidechain_duck_duration_ms_);
+  }
+  if (this->fade_duration_ms_ > 0) {
+    ESP_LOGCONFIG(SOURCE_TAG, "  Fade duration: %" PRIu32 " ms", this->fade_duration_ms_);
+  }
+  if (this->drift_compensation_) {
+    ESP_LOGCONFIG(SOURCE_TAG, "  Drift compensation target fill level: %.0f%%",
+                  this->drift_target_fill_level_ * 100.0f);
+  }
+  if (!this->channel_matrix_.empty()) {
+    ESP_LOGCONFIG(SOURCE_TAG, "  Channel matrix: %u weights", (unsigned) this->channel_matrix_.size());
+  }
+}
+
+void I2SSourceSpeaker::loop() {
+  if (this->format_mismatch_.exchange(false)) {
+    ESP_LOGW(SOURCE_TAG, "Discarded audio; inputs must be 16 bits per sample at %" PRIu32 " Hz with 1 or 2 channels",
+             this->parent_->get_audio_stream_info().get_sample_rate());
+    this->status_set_warning();
+  }
+
+  if (this->matrix_mismatch_.exchange(false)) {
+    ESP_LOGW(SOURCE_TAG, "Channel matrix doesn't match the %u channel input; using the default channel mapping",
+             (unsigned) this->audio_stream_info_.get_channels());
+  }
+
+  if (this->active_ && this->parent_->is_stopped()) {
+    // The parent's speaker task isn't running, so handle requests it would otherwise handle
+    if (this->stop_requested_.exchange(false)) {
+      this->reset_stream_();
+    } else if ((this->ring_buffer_->available() == 0) && this->finish_requested_.exchange(false)) {
+      this->active_ = false;
+    } else {
+      // The parent stopped, e.g., after its timeout, while this input still has audio to play
+      this->parent_->set_audio_stream_info(this->parent_->get_mixing_stream_info());
+      this->parent_->start();
+    }
+  }
+
+  if (!this->active_) {
+    this->state_ = speaker::STATE_STOPPED;
+  } else if (this->parent_->is_running()) {
+    if (this->state_ != speaker::STATE_RUNNING) {
+      this->status_clear_warning();
+    }
+    this->state_ = speaker::STATE_RUNNING;
+  } else {
+    this->state_ = speaker::STATE_STARTING;
+  }
+}
+
+void I2SSourceSpeaker::set_sidechain_ducking(uint8_t decibel_reduction, uint32_t duration_ms) {
+  this->sidechain_decibel_reduction_ = decibel_reduction;
+  this->sidechain_duck_gain_ = audio::decibels_to_q15_gain(-static_cast<float>(decibel_reduction));
+  this->sidechain_duck_duration_ms_ = duration_ms;
+}
+
+void I2SSourceSpeaker::apply_ducking(uint8_t decibel_reduction, uint32_t duration_ms) {
+  this->requested_duck_duration_ms_.store(duration_ms, std::memory_order_relaxed);
+  this->requested_duck_gain_.store(audio::decibels_to_q15_gain(-static_cast<float>(decibel_reduction)),
+                                   std::memory_order_relaxed);
+}
+
+void I2SSourceSpeaker::start_with_fade_in(uint32_t duration_ms) {
+  if (this->is_failed())
+    return;
+
+  if (this->stop_requested_.exchange(false)) {
+    // The parent's task hasn't handled the stop yet, so discard the stopped audio here
+    this->ring_buffer_->reset();
+  }
+  this->finish_requested_ = false;
+  if (!this->active_ || (duration_ms > 0)) {
+    // Restart the fade for a new stream. An input that is already playing only restarts it if asked to fade in.
+    this->start_fade_ms_.store(duration_ms, std::memory_order_relaxed);
+    this->started_ = true;
+  }
+  this->active_ = true;
+
+  if (this->parent_->is_stopped()) {
+    // Only set the stream info on a stopped parent; changing it while running would restart its task
+    this->parent_->set_audio_stream_info(this->parent_->get_mixing_stream_info());
+    this->parent_->start();
+  }
+}
+
+void I2SSourceSpeaker::stop_with_fade_out(uint32_t duration_ms) {
+  if (this->active_) {
+    this->stop_fade_ms_.store(duration_ms, std::memory_order_relaxed);
+    this->stop_requested_ = true;
+  }
+}
+
+void I2SSourceSpeaker::crossfade_to(I2SSourceSpeaker *next_speaker, uint32_t duration_ms) {
+  if (next_speaker == this) {
+    return;
+  }
+  this->stop_with_fade_out(duration_ms);
+  next_speaker->start_with_fade_in(duration_ms);
+}
+
+void I2SSourceSpeaker::finish() {
+  if (this->active_) {
+    this->finish_requested_ = true;
+  }
+}
+
+size_t I2SSourceSpeaker::play(const uint8_t *data, size_t length, TickType_t ticks_to_wait) {
+  if (this->is_failed()) {
+    ESP_LOGE(SOURCE_TAG, "Cannot play audio, speaker failed to setup");
+    return 0;
+  }
+
+  // More audio continues the track, so cancel any pending finish before the parent's task sees the buffer drain
+  this->finish_requested_ = false;
+  if (!this->active_ || this->stop_requested_) {
+    this->start();
+  }
+
+  return this->ring_buffer_->write_without_replacement((void *) data, length, ticks_to_wait);
+}
+
+bool I2SSourceSpeaker::has_buffered_data() const {
+  if (this->ring_buffer_ != nullptr) {
+    return this->ring_buffer_->available() > 0;
+  }
+  return false;
+}
+
+void I2SSourceSpeaker::set_volume(float volume) {
+  this->volume_ = volume;
+  this->parent_->set_volume(volume);
+}
+
+void I2SSourceSpeaker::set_mute_state(bool mute_state) {
+  this->mute_state_ = mute_state;
+  this->parent_->set_mute_state(mute_state);
+}
+
+bool I2SSourceSpeaker::configure_stream_(uint8_t bus_channels) {
+  const audio::AudioStreamInfo &stream_info = this->audio_stream_info_;
+
+  this->staged_frames_ = 0;
+  this->mix_stream_info_ = stream_info;
+  this->apply_channel_matrix_ = false;
+
+  if (!this->channel_matrix_.empty()) {
+    this->apply_channel_matrix_ = this->channel_mixer_.configure(stream_info.get_channels(), bus_channels) &&
+                                  this->channel_mixer_.set_matrix(this->channel_matrix_);
+    if (this->apply_channel_matrix_) {
+      this->mix_stream_info_ = audio::AudioStreamInfo(16, bus_channels, stream_info.get_sample_rate());
+    } else {
+      this->matrix_mismatch_ = true;
+    }
+  }
+
+  if (this->drift_compensator_ != nullptr) {
+    const audio::ChannelMixer *channel_mixer = this->apply_channel_matrix_ ? &this->channel_mixer_ : nullptr;
+    if (!this->drift_compensator_->initialize(stream_info, this->mix_stream_info_, channel_mixer)) {
+      return false;
+    }
+  }
+
+  this->stream_configured_ = true;
+  return true;
+}
+
+uint32_t I2SSourceSpeaker::read_frames_(int16_t *buffer, uint32_t max_frames, uint8_t bus_channels) {
+  const audio::AudioStreamInfo &stream_info = this->audio_stream_info_;
+
+  if (!this->stream_configured_ && !this->configure_stream_(bus_channels)) {
+    return 0;
+  }
+
+  if ((this->drift_compensator_ == nullptr) && !this->apply_channel_matrix_) {
+    // Only read whole frames, leaving any partially written frame for the next pass
+    const uint32_t frames_to_read = std::min(stream_info.bytes_to_frames(this->ring_buffer_->available()), max_frames);
+    if (frames_to_read == 0) {
+      return 0;
+    }
+    const size_t bytes_read = this->ring_buffer_->read((void *) buffer, stream_info.frames_to_bytes(frames_to_read), 0);
+    return stream_info.bytes_to_frames(bytes_read);
+  }
+
+  // Stage the ring buffer's audio, as mixing can't run in place and the compensator consumes slightly more or fewer
+  // frames than it generates. Whatever isn't used stays staged for the next pass.
+  uint32_t frames_generated = 0;
+  while (frames_generated < max_frames) {
+    const uint32_t frames_to_read = std::min(stream_info.bytes_to_frames(this->ring_buffer_->available()),
+                                             STAGING_FRAMES - this->staged_frames_);
+    if (frames_to_read > 0) {
+      uint8_t *staging_end =
+          reinterpret_cast<uint8_t *>(this->staging_buffer_) + stream_info.frames_to_bytes(this->staged_frames_);
+      const size_t bytes_read =
+          this->ring_buffer_->read((void *) staging_end, stream_info.frames_to_bytes(frames_to_read), 0);
+      this->staged_frames_ += stream_info.bytes_to_frames(bytes_read);
+    }
+
+    uint8_t *output = reinterpret_cast<uint8_t *>(buffer) + this->mix_stream_info_.frames_to_bytes(frames_generated);
+    uint32_t frames_used;
+    uint32_t frames_output;
+    if (this->drift_compensator_ != nullptr) {
+      const audio::DriftCompensatorResults results =
+          this->drift_compensator_->resample(reinterpret_cast<const uint8_t *>(this->staging_buffer_), output,
+                                             this->staged_frames_, max_frames - frames_generated);
+      frames_used = results.frames_used;
+      frames_output = results.frames_generated;
+    } else {
+      frames_used = std::min(this->staged_frames_, max_frames - frames_generated);
+      frames_output = frames_used;
+      this->channel_mixer_.mix_frames(reinterpret_cast<const uint8_t *>(this->staging_buffer_), sizeof(int16_t), output,
+                                      sizeof(int16_t), frames_used);
+    }
+
+    this->staged_frames_ -= frames_used;
+    if ((frames_used > 0) && (this->staged_frames_ > 0)) {
+      const uint8_t *unused =
+          reinterpret_cast<const uint8_t *>(this->staging_buffer_) + stream_info.frames_to_bytes(frames_used);
+      memmove(this->staging_buffer_, unused, stream_info.frames_to_bytes(this->staged_frames_));
+    }
+    frames_generated += frames_output;
+
+    if ((frames_used == 0) && (frames_output == 0)) {
+      break;
+    }
+  }
+
+  if (this->drift_compensator_ != nullptr) {
+    const size_t buffered_bytes = this->ring_buffer_->available();
+    const size_t capacity_bytes = buffered_bytes + this->ring_buffer_->free();
+    this->drift_compensator_->update_buffer_level(stream_info.bytes_to_frames(buffered_bytes) + this->staged_frames_,
+                                                  stream_info.bytes_to_frames(capacity_bytes));
+  }
+
+  return frames_generated;
+}
+
+void I2SSourceSpeaker::reset_stream_() {
+  this->ring_buffer_->reset();
+  this->stream_configured_ = false;
+  this->accumulated_frames_written_ = 0;
+  this->frames_mixed_ = 0;
+  this->active_ = false;
+}
+
+void I2SSourceSpeaker::report_mixed_frames_(uint32_t presentation_timestamp) {
+  if (this->frames_mixed_ == 0) {
+    return;
+  }
+
+  this->accumulated_frames_written_ += this->frames_mixed_;
+  this->frames_mixed_ = 0;
+
+  const uint32_t new_playback_ms =
+      this->audio_stream_info_.frames_to_milliseconds_with_remainder(&this->accumulated_frames_written_);
+  const uint32_t remainder_us = this->audio_stream_info_.frames_to_microseconds(this->accumulated_frames_written_);
+
+  uint32_t pending_frames = this->audio_stream_info_.bytes_to_frames(this->ring_buffer_->available());
+  const uint32_t pending_ms = this->audio_stream_info_.frames_to_milliseconds_with_remainder(&pending_frames);
+
+  this->audio_output_callback_(new_playback_ms, remainder_us, pending_ms, presentation_timestamp);
+}
+
 }  // namespace i2s_audio
 }  // namespace esphome
 
@@ -4,13 +4,21 @@
 
 #include "../i2s_audio.h"
 
-#include <driver/i2s.h>
 
 #include <freertos/event_groups.h>
 #include <freertos/queue.h>
+#include <freertos/semphr.h>
 #include <freertos/FreeRTOS.h>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "esphome/components/audio/audio.h"
+#include "esphome/components/audio/audio_channel_mixer.h"
+#include "esphome/components/audio/audio_drift_compensator.h"
+#include "esphome/components/audio/audio_gain.h"
+#include "esphome/components/audio/audio_trace.h"
 #include "esphome/components/speaker/speaker.h"
 
 #include "esphome/core/component.h"
@@ -21,6 +29,24 @@
 namespace esphome {
 namespace i2s_audio {
 
+class I2SSourceSpeaker;
+
+static const uint8_t TELEMETRY_FILL_LEVEL_BINS = 10;
+
+struct I2SSpeakerTelemetry {
+  /*
+   * @brief Counters for triaging stutter, updated by the speaker task and read from other tasks.
+   * They accumulate across streams until reset.
+   */
+  std::atomic<uint32_t> dma_underflows{0};    // DMA ran out of audio in the middle of playing and output silence
+  std::atomic<uint32_t> short_writes{0};      // The I2S write timed out before writing all of the audio
+  std::atomic<uint32_t> ring_empty_reads{0};  // Ring buffer ran empty while playing with no stop pending
+  // Ring buffer fill level before each read, in bins of 100 / TELEMETRY_FILL_LEVEL_BINS percent
+  std::atomic<uint32_t> fill_level_histogram[TELEMETRY_FILL_LEVEL_BINS]{};
+  std::atomic<uint32_t> loop_time_us{0};      // Duration of the latest speaker task loop iteration
+  std::atomic<uint32_t> max_loop_time_us{0};  // Longest loop iteration since it was last taken
+};
+
 class I2SAudioSpeaker : public I2SWriter, public speaker::Speaker, public Component {
  public:
   float get_setup_priority() const override { return esphome::setup_priority::PROCESSOR; }
@@ -31,6 +57,21 @@ class I2SAudioSpeaker : public I2SWriter, public speaker::Speaker, public Compon
 
   void set_buffer_duration(uint32_t buffer_duration_ms) { this->buffer_duration_ms_ = buffer_duration_ms; }
   void set_timeout(uint32_t ms) { this->timeout_ = ms; }
+  /// @brief Keeps the speaker task, its buffers, and the I2S driver alive for a while after a stream stops, so the next
+  /// stream starts within about one DMA buffer. The idle bus outputs silence. Holds the I2S port while idle.
+  /// @param idle_ms How long to stay ready after a stream stops. 0 releases everything immediately.
+  void set_keep_warm(uint32_t idle_ms) { this->keep_warm_ms_ = idle_ms; }
+  void set_volume_ramp(audio::GainRampType ramp_type, uint32_t duration_ms) {
+    this->volume_ramp_.set_ramp(ramp_type, duration_ms);
+  }
+
+  /// @brief Sets the fade applied when pausing, resuming, or stopping, so the output doesn't cut off with a click.
+  /// @param ramp_type GainRampType::LINEAR or GainRampType::EXPONENTIAL
+  /// @param duration_ms Duration of a fade from full scale to silence. 0 disables fading.
+  void set_fade(audio::GainRampType ramp_type, uint32_t duration_ms) {
+    this->fade_ramp_.set_ramp(ramp_type, duration_ms);
+    this->fade_duration_ms_ = duration_ms;
+  }
 
   void start() override;
   void stop() override;
@@ -40,7 +81,10 @@ class I2SAudioSpeaker : public I2SWriter, public speaker::Speaker, public Compon
   bool get_pause_state() const override { return this->pause_state_; }
 
   /// @brief Plays the provided audio data.
-  /// Starts the speaker task, if necessary. Writes the audio data to the ring buffer.
+  /// Starts the speaker task, if necessary. Writes the audio data to the ring buffer. Writing audio while a graceful
+  /// stop is pending cancels the stop, so the next track continues without restarting the speaker. Safe to call from
+  /// several tasks; writes are serialized and only whole frames are written, so a producer waits up to ticks_to_wait
+  /// for another's write to finish rather than dropping its audio. Use source speakers to mix simultaneous streams.
   /// @param data Audio data in the format set by the parent speaker classes ``set_audio_stream_info`` method.
   /// @param length The length of the audio data in bytes.
   /// @param ticks_to_wait The FreeRTOS ticks to wait before writing as much data as possible to the ring buffer.
@@ -50,9 +94,26 @@ class I2SAudioSpeaker : public I2SWriter, public speaker::Speaker, public Compon
 
   bool has_buffered_data() const override;
 
+  /// @brief Reports how much audio is waiting in the ring buffer. Used to compensate for clock drift upstream.
+  /// @param buffered_bytes Pointer to store the number of bytes in the ring buffer
+  /// @param capacity_bytes Pointer to store the ring buffer's total capacity in bytes
+  /// @return True if the ring buffer is allocated, false otherwise
+  bool get_buffer_level(size_t *buffered_bytes, size_t *capacity_bytes) const;
+
+  /// @brief Adds a mixing input. The speaker task mixes the audio of every active input into the bus just before
+  /// writing it to the I2S port.
+  /// @param source_speaker Input speaker whose parent is this speaker
+  void add_source_speaker(I2SSourceSpeaker *source_speaker) { this->source_speakers_.push_back(source_speaker); }
+
+  /// @brief Returns the stream info the mixing inputs should use: 16 bits per sample at the bus's sample rate and
+  /// channels.
+  audio::AudioStreamInfo get_mixing_stream_info() const {
+    return audio::AudioStreamInfo(16, this->num_of_channels(), this->sample_rate_);
+  }
+
   /// @brief Sets the volume of the speaker. Uses the speaker's configured audio dac component. If unavailble, it is
-  /// implemented as a software volume control. Overrides the default setter to convert the floating point volume to a
-  /// Q15 fixed-point factor.
+  /// implemented as a software volume control that ramps toward the new volume. Overrides the default setter to
+  /// convert the floating point volume to a Q15 fixed-point factor.
   /// @param volume between 0.0 and 1.0
   void set_volume(float volume) override;
 
@@ -62,17 +123,53 @@ class I2SAudioSpeaker : public I2SWriter, public speaker::Speaker, public Compon
   /// @param mute_state true for muting, false for unmuting
   void set_mute_state(bool mute_state) override;
 
+  /// @brief Returns the counters the speaker task updates while playing
+  const I2SSpeakerTelemetry &get_telemetry() const { return this->telemetry_; }
+
+  /// @brief Returns the longest speaker task loop iteration since the last call, in microseconds
+  uint32_t take_max_loop_time_us() { return this->telemetry_.max_loop_time_us.exchange(0); }
+
+  /// @brief Logs the telemetry counters and the ring buffer fill level histogram
+  void dump_telemetry() const;
+
+  /// @brief Zeroes the telemetry counters and the ring buffer fill level histogram
+  void reset_telemetry();
+
  protected:
   /// @brief Function for the FreeRTOS task handling audio output.
   /// After receiving the COMMAND_START signal, allocates space for the buffers, starts the I2S driver, and reads
   /// audio from the ring buffer and writes audio to the I2S port. Stops immmiately after receiving the COMMAND_STOP
-  /// signal and stops only after the ring buffer is empty after receiving the COMMAND_STOP_GRACEFULLY signal. Stops if
-  /// the ring buffer hasn't read data for more than timeout_ milliseconds. When stopping, it deallocates the buffers,
-  /// stops the I2S driver, unlocks the I2S port, and deletes the task. It communicates the state and any errors via
-  /// event_group_.
+  /// signal and stops only after the ring buffer is empty after receiving the COMMAND_STOP_GRACEFULLY signal, unless
+  /// play() cancels the graceful stop with the COMMAND_CANCEL_STOP signal. Stops if
+  /// the ring buffer hasn't read data for more than timeout_ milliseconds. With keep_warm_ms_ set, it then parks until
+  /// the next COMMAND_START or until the keep warm duration passes. The audio output callback reports each write with
+  /// the time its last frame finishes playing, found by timestamping DMA buffer completions from the I2S event queue.
+  /// When stopping, it deallocates the buffers, stops the I2S driver, unlocks the I2S port, and deletes the task. It
+  /// communicates the state and any errors via event_group_.
   /// @param params I2SAudioSpeaker component
   static void speaker_task(void *params);
 
+  /// @brief Parks the speaker task between streams with the buffers allocated and the I2S driver installed. Should only
+  /// be called by the speaker_task itself.
+  /// @param audio_stream_info Stream information the I2S driver is configured for
+  /// @param discard_buffered If true, discards any audio left in the ring buffer, e.g., after a hard stop.
+  /// @return True if a new stream started within the keep warm duration, false if the task should stop.
+  bool wait_while_warm_(const audio::AudioStreamInfo &audio_stream_info, bool discard_buffered);
+
+  /// @brief Switches the running task to the latest audio_stream_info_ without reinstalling the I2S driver or
+  /// reallocating buffers. Changes the bus clock if the sample rate changed and the bus is adjustable, which the parent
+  /// refuses while the microphone shares the port. Should only be called by the speaker_task itself.
+  /// @param audio_stream_info Stream information the task is playing; updated to the new stream's on success
+  /// @param data_buffer_size Allocated size of the data buffer in bytes
+  /// @return True if the task can play the new stream, false if it must restart with new buffers or driver settings
+  bool reconfigure_stream_(audio::AudioStreamInfo &audio_stream_info, size_t data_buffer_size);
+
+  /// @brief Returns the ring buffer size a stream needs: the configured buffer duration, but at least the duration of
+  /// all the DMA buffers.
+  /// @param audio_stream_info Stream information of the audio in the ring buffer
+  /// @return Number of bytes
+  size_t ring_buffer_size_for_(const audio::AudioStreamInfo &audio_stream_info) const;
+
   /// @brief Sends a stop command to the speaker task via event_group_.
   /// @param wait_on_empty If false, sends the COMMAND_STOP signal. If true, sends the COMMAND_STOP_GRACEFULLY signal.
   void stop_(bool wait_on_empty);
@@ -82,27 +179,43 @@ class I2SAudioSpeaker : public I2SWriter, public speaker::Speaker, public Compon
   /// @return True if an ERR_ESP bit is set and false if err == ESP_OK
   bool send_esp_err_to_event_group_(esp_err_t err);
 
-  /// @brief Allocates the data buffer and ring buffer
+  /// @brief Allocates the data buffer, ring buffer, mix buffer, and bus buffer
   /// @param data_buffer_size Number of bytes to allocate for the data buffer.
   /// @param ring_buffer_size Number of bytes to allocate for the ring buffer.
-  /// @return ESP_ERR_NO_MEM if either buffer fails to allocate
+  /// @param mix_buffer_size Number of bytes to allocate for the mix buffer. 0 if there are no source speakers.
+  /// @param bus_buffer_size Number of bytes to allocate for the bus buffer. 0 if the audio already matches the bus.
+  /// @return ESP_ERR_NO_MEM if any buffer fails to allocate
   ///         ESP_OK if successful
-  esp_err_t allocate_buffers_(size_t data_buffer_size, size_t ring_buffer_size);
+  esp_err_t allocate_buffers_(size_t data_buffer_size, size_t ring_buffer_size, size_t mix_buffer_size,
+                              size_t bus_buffer_size);
 
   /// @brief Starts the ESP32 I2S driver.
   /// Attempts to lock the I2S port, starts the I2S driver using the passed in stream information, and sets the data out
   /// pin. If it fails, it will unlock the I2S port and uninstall the driver, if necessary.
   /// @param audio_stream_info Stream information for the I2S driver.
-  /// @return ESP_ERR_NOT_ALLOWED if the I2S port can't play the incoming audio stream.
+  /// @return ESP_ERR_NOT_SUPPORTED if the I2S port can't play the incoming audio stream, e.g., its samples are wider
+  ///         than the bus's bits per sample.
   ///         ESP_ERR_INVALID_STATE if the I2S port is already locked.
   ///         ESP_ERR_INVALID_ARG if nstalling the driver or setting the data outpin fails due to a parameter error.
   ///         ESP_ERR_NO_MEM if the driver fails to install due to a memory allocation error.
   ///         ESP_FAIL if setting the data out pin fails due to an IO error ESP_OK if successful
   esp_err_t start_i2s_driver_(audio::AudioStreamInfo &audio_stream_info);
-  
+
+  /// @brief Mixes the audio of every active source speaker into the data buffer. Called by the speaker task.
+  /// Each source is scaled by its ducking gain ramp, and the sum saturates rather than wraps. Sources that don't match
+  /// the stream's sample rate are skipped, and mixing is only supported for 16 bit streams.
+  /// @param main_bytes Number of bytes of the speaker's own audio already in the data buffer
+  /// @param audio_stream_info Stream information of the data buffer
+  /// @param data_buffer_size Allocated size of the data buffer in bytes
+  /// @return Number of valid bytes in the data buffer after mixing
+  size_t mix_sources_(size_t main_bytes, const audio::AudioStreamInfo &audio_stream_info, size_t data_buffer_size);
+
+  /// @brief Returns true if any source speaker has audio to mix
+  bool has_active_sources_() const;
+
   /// @brief Deletes the speaker's task.
-  /// Deallocates the data_buffer_ and audio_ring_buffer_, if necessary, and deletes the task. Should only be called by
-  /// the speaker_task itself.
+  /// Deallocates the data_buffer_, mix_buffer_, bus_buffer_, and audio_ring_buffer_, if necessary, and deletes the task.
+  /// Should only be called by the speaker_task itself.
   /// @param buffer_size The allocated size of the data_buffer_.
   void delete_task_(size_t buffer_size);
 
@@ -112,20 +225,207 @@ class I2SAudioSpeaker : public I2SWriter, public speaker::Speaker, public Compon
   QueueHandle_t i2s_event_queue_;
 
   uint8_t *data_buffer_;
-  std::shared_ptr<RingBuffer> audio_ring_buffer_;
+  std::shared_ptr<RingBuffer> audio_ring_buffer_;  // Loaded and stored atomically, as producers use it from other tasks
+  SemaphoreHandle_t write_lock_{nullptr};           // Serializes producers writing to audio_ring_buffer_
+  size_t ring_buffer_size_{0};                      // Allocated size of audio_ring_buffer_ in bytes
+
+  // Scratch buffer each source's audio is read into before it is scaled and mixed into the data buffer
+  int16_t *mix_buffer_{nullptr};
+  size_t mix_buffer_size_{0};
+  std::vector<I2SSourceSpeaker *> source_speakers_;
+
+  // One DMA buffer of audio widened to the bus's bits per sample, used when the stream has fewer bits per sample
+  uint8_t *bus_buffer_{nullptr};
+  size_t bus_buffer_size_{0};
 
   uint32_t buffer_duration_ms_;
 
   optional<uint32_t> timeout_;
+  uint32_t keep_warm_ms_{0};
+
+  // True while the speaker task is parked between streams. Whoever clears it, start() or the idle task, decides whether
+  // the task resumes or stops.
+  std::atomic<bool> warm_{false};
+  audio::AudioStreamInfo warm_stream_info_;
+  bool resuming_warm_{false};
 
 
   bool task_created_{false};
   bool pause_state_{false};
 
-  int16_t q15_volume_factor_{INT16_MAX};
-  
+  // Software volume control; the speaker task ramps the applied gain toward the target set by set_volume
+  audio::GainRamp volume_ramp_;
+
+  // Fades the output out before pausing or stopping and back in when resuming. Only accessed by the speaker task.
+  audio::GainRamp fade_ramp_;
+  uint32_t fade_duration_ms_{0};
+
   size_t bytes_written_{0};
   uint32_t accumulated_frames_written_{0};
+
+  I2SSpeakerTelemetry telemetry_;
+
+#ifdef USE_AUDIO_TRACE
+  uint32_t trace_blocks_{0};
+  uint32_t trace_convert_blocks_{0};
+#endif
+};
+
+class I2SSourceSpeaker : public speaker::Speaker, public Component, public Parented<I2SAudioSpeaker> {
+  /*
+   * @brief Mixing input of an I2SAudioSpeaker.
+   * Audio written to this speaker is buffered in its own ring buffer, and the parent's speaker task mixes it with the
+   * parent's audio and any other inputs just before writing to the I2S port, so no extra task or intermediate buffer
+   * is needed. Starting an input doesn't restart the parent if it is already running.
+   *   - Audio must be 16 bits per sample at the parent's sample rate, with 1 or 2 channels.
+   *   - Ducking attenuates this input, either on request or automatically while another input with sidechain ducking
+   *     is active. The strongest reduction wins, and the gain ramps to avoid clicks.
+   *   - Pausing, resuming, and stopping fade this input out and in when a fade is configured. Stopping one input
+   *     while starting another with the same fade duration crossfades between them.
+   *   - Volume and mute are forwarded to the parent, since they apply to the mixed output.
+   *   - With drift compensation, audio from a producer on another clock (e.g., a network stream) is converted to the
+   *     I2S clock while it is mixed, holding this input's ring buffer at a target fill level.
+   *   - A channel matrix can replace the default channel mapping (mono is duplicated, stereo passes through), e.g., to
+   *     swap or blend channels. With drift compensation, the mixing is fused into the compensator's filter.
+   */
+ public:
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+
+  void set_buffer_duration(uint32_t buffer_duration_ms) { this->buffer_duration_ms_ = buffer_duration_ms; }
+
+  /// @brief Compensates for clock drift between this input's producer and the I2S clock. Only useful for producers
+  /// that write in real time on their own clock; a producer that writes faster than real time keeps the ring buffer
+  /// full, which only holds the correction at its limit.
+  /// @param target_fill_level Fraction of the ring buffer to hold filled
+  void set_drift_compensation(float target_fill_level) {
+    this->drift_compensation_ = true;
+    this->drift_target_fill_level_ = target_fill_level;
+  }
+
+  /// @brief Mixes this input's channels into the bus's channels with a custom matrix. Only applies while the input's
+  /// channel count matches the matrix's columns; otherwise the default mapping is used.
+  /// @param q15_matrix Row-major (bus channels) x (input channels) matrix of Q15 fixed-point weights. 1 << 15 is unity.
+  void set_channel_matrix(std::vector<int32_t> q15_matrix) { this->channel_matrix_ = std::move(q15_matrix); }
+
+  /// @brief Sets how much this input reduces the volume of the other inputs while it plays audio.
+  /// @param decibel_reduction Reduction in dB applied to the other inputs
+  /// @param duration_ms Duration of the gain ramp when ducking starts and ends
+  void set_sidechain_ducking(uint8_t decibel_reduction, uint32_t duration_ms);
+
+  /// @brief Reduces this input's volume until it is called again with a reduction of 0.
+  /// @param decibel_reduction Reduction in dB; 0 restores the full volume
+  /// @param duration_ms Duration of the gain ramp to the new volume
+  void apply_ducking(uint8_t decibel_reduction, uint32_t duration_ms);
+
+  /// @brief Sets the fade applied when pausing, resuming, or stopping this input.
+  /// @param ramp_type GainRampType::LINEAR or GainRampType::EXPONENTIAL
+  /// @param duration_ms Duration of a fade from full scale to silence. 0 disables fading.
+  void set_fade(audio::GainRampType ramp_type, uint32_t duration_ms) {
+    this->fade_type_ = ramp_type;
+    this->fade_duration_ms_ = duration_ms;
+  }
+
+  void start() override { this->start_with_fade_in(0); }
+  /// @brief Stops the input after fading out over the configured fade duration
+  void stop() override { this->stop_with_fade_out(this->fade_duration_ms_); }
+  void finish() override;
+
+  /// @brief Starts the input, fading its audio in from silence.
+  /// @param duration_ms Duration of the fade in. 0 starts at full volume.
+  void start_with_fade_in(uint32_t duration_ms);
+
+  /// @brief Fades the input out, then stops it and discards any remaining audio.
+  /// @param duration_ms Duration of the fade out. 0 stops immediately.
+  void stop_with_fade_out(uint32_t duration_ms);
+
+  /// @brief Fades this input out while fading another input in over the same duration, e.g., to blend the end of one
+  /// track into the start of the next. The next track's audio should be written to the other input.
+  /// @param next_speaker Input to start
+  /// @param duration_ms Duration of the crossfade
+  void crossfade_to(I2SSourceSpeaker *next_speaker, uint32_t duration_ms);
+
+  size_t play(const uint8_t *data, size_t length, TickType_t ticks_to_wait) override;
+  size_t play(const uint8_t *data, size_t length) override { return this->play(data, length, 0); }
+
+  bool has_buffered_data() const override;
+
+  void set_pause_state(bool pause_state) override { this->pause_state_ = pause_state; }
+  bool get_pause_state() const override { return this->pause_state_; }
+
+  void set_volume(float volume) override;
+  void set_mute_state(bool mute_state) override;
+
+ protected:
+  friend I2SAudioSpeaker;
+
+  /// @brief Reports the frames mixed since the last report through the audio output callback. Called by the parent's
+  /// speaker task after writing the mixed audio to the I2S port.
+  /// @param presentation_timestamp Time in microseconds when the last mixed frame finishes playing
+  void report_mixed_frames_(uint32_t presentation_timestamp);
+
+  /// @brief Reads whole frames of audio to mix, applying the channel matrix and converting them to the I2S clock if
+  /// configured. The frames are in the format of mix_stream_info_. Called by the parent's speaker task.
+  /// @param buffer Pointer to store the frames
+  /// @param max_frames Number of frames that fit in the buffer
+  /// @param bus_channels Number of channels on the bus; at most 2
+  /// @return Number of frames stored in the buffer
+  uint32_t read_frames_(int16_t *buffer, uint32_t max_frames, uint8_t bus_channels);
+
+  /// @brief Sets up the channel mixer and drift compensator for the current stream. Called by read_frames_.
+  /// @return True if successful, false if the drift compensator can't convert the stream
+  bool configure_stream_(uint8_t bus_channels);
+
+  /// @brief Discards any buffered audio and marks the input inactive. Called after stopping.
+  void reset_stream_();
+
+  std::unique_ptr<RingBuffer> ring_buffer_;
+  uint32_t buffer_duration_ms_;
+
+  // Set by this component's methods and handled by the parent's speaker task
+  std::atomic<bool> active_{false};
+  std::atomic<bool> stop_requested_{false};
+  std::atomic<bool> finish_requested_{false};
+  std::atomic<bool> format_mismatch_{false};
+  std::atomic<bool> started_{false};
+  std::atomic<uint32_t> start_fade_ms_{0};
+  std::atomic<uint32_t> stop_fade_ms_{0};
+  bool pause_state_{false};
+
+  audio::GainRampType fade_type_{audio::GainRampType::LINEAR};
+  uint32_t fade_duration_ms_{0};
+
+  std::atomic<int32_t> requested_duck_gain_{audio::Q15_UNITY_GAIN};
+  std::atomic<uint32_t> requested_duck_duration_ms_{0};
+  int32_t sidechain_duck_gain_{audio::Q15_UNITY_GAIN};
+  uint32_t sidechain_duck_duration_ms_{0};
+  uint8_t sidechain_decibel_reduction_{0};
+
+  // Only accessed by the parent's speaker task
+  audio::GainRamp duck_ramp_;
+  uint32_t duck_duration_ms_{0};
+  audio::GainRamp fade_ramp_;
+  uint32_t frames_mixed_{0};
+  uint32_t accumulated_frames_written_{0};
+
+  bool drift_compensation_{false};
+  float drift_target_fill_level_{0.5f};
+  std::unique_ptr<audio::DriftCompensator> drift_compensator_;
+
+  std::vector<int32_t> channel_matrix_;
+  audio::ChannelMixer channel_mixer_;
+  bool apply_channel_matrix_{false};
+  std::atomic<bool> matrix_mismatch_{false};
+
+  // The remaining members are only accessed by the parent's speaker task, or by this component while the parent is
+  // stopped
+  // Format of the frames read_frames_ returns: the input's channels, or the bus's with the channel matrix applied
+  audio::AudioStreamInfo mix_stream_info_;
+  // Frames read from the ring buffer that haven't been mixed or converted yet
+  int16_t *staging_buffer_{nullptr};
+  uint32_t staged_frames_{0};
+  bool stream_configured_{false};
 };
 
 }  // namespace i2s_audio
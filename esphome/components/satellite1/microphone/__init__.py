@@ -13,7 +13,7 @@ from esphome.components.i2s_audio.i2s_settings import (
     EXTERNAL_CLK,
     CONF_CHANNEL,
     CONF_FIXED_SETTINGS,
-    CHANNEL_FORMAT,
+    CHANNELS,
     _validate_bits,
 ) 
 
@@ -45,13 +45,6 @@ NabuMicrophoneChannel = nabu_microphone_ns.class_(
     "NabuMicrophoneChannel", microphone.Microphone, cg.Component
 )
 
-i2s_channel_fmt_t = cg.global_ns.enum("i2s_channel_fmt_t")
-CHANNELS = {
-    "left": i2s_channel_fmt_t.I2S_CHANNEL_FMT_ONLY_LEFT,
-    "right": i2s_channel_fmt_t.I2S_CHANNEL_FMT_ONLY_RIGHT,
-}
-
-
 
 MICROPHONE_CHANNEL_SCHEMA = microphone.MICROPHONE_SCHEMA.extend(
     {
@@ -71,7 +64,7 @@ CONFIG_SCHEMA = cv.Schema(
             _validate_bits, cv.enum(BITS_PER_SAMPLE)
         ),
         cv.Optional(CONF_CLK_MODE, default=EXTERNAL_CLK): cv.enum(I2S_CLK_MODES),
-        cv.Optional(CONF_CHANNEL, default="right_left"): cv.enum(CHANNEL_FORMAT),
+        cv.Optional(CONF_CHANNEL, default="right_left"): cv.one_of(*CHANNELS, lower=True),
         cv.Optional(CONF_USE_APLL, default=False): cv.boolean,
         cv.Optional(CONF_CHANNEL_0): MICROPHONE_CHANNEL_SCHEMA,
         cv.Optional(CONF_CHANNEL_1): MICROPHONE_CHANNEL_SCHEMA,
@@ -2,8 +2,6 @@
 
 #ifdef USE_ESP32
 
-#include <driver/i2s.h>
-
 #include "esphome/core/hal.h"
 #include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
@@ -122,8 +120,7 @@ esp_err_t NabuMicrophone::start_i2s_driver_() {
     return ESP_ERR_INVALID_STATE;
   }
 
-  i2s_driver_config_t config = this->get_i2s_cfg();
-  if(!this->install_i2s_driver(config))
+  if(!this->install_i2s_driver())
   {
     this->release_i2s_access();
     return ESP_ERR_INVALID_STATE;
@@ -210,16 +207,21 @@ void NabuMicrophone::read_task_(void *params) {
             }
 
             size_t bytes_read;
+            const uint32_t read_start_us = micros();
             esp_err_t err =
-                i2s_read(this_microphone->parent_->get_port(), buffer, DMA_BUFFER_SIZE * sizeof(int32_t) * 4,
-                         &bytes_read, pdMS_TO_TICKS(TASK_DELAY_MS));
-            if (err != ESP_OK) {
+                i2s_channel_read(this_microphone->parent_->get_rx_handle(), buffer,
+                                 DMA_BUFFER_SIZE * sizeof(int32_t) * 4, &bytes_read, TASK_DELAY_MS);
+            if ((err != ESP_OK) && (err != ESP_ERR_TIMEOUT)) {
               event.type = TaskEventType::WARNING;
               event.err = err;
               xQueueSend(this_microphone->event_queue_, &event, portMAX_DELAY);
             }
 
             if (bytes_read > 0) {
+              // Counted in bus frames, each a 32 bit left and right slot, so the stamps line up with the speaker's
+              this_microphone->stamp_rx_block_(buffer, bytes_read / (NUMBER_OF_CHANNELS * sizeof(int32_t)),
+                                               read_start_us);
+
               // TODO: Handle 16 bits per sample, currently it won't allow that option at codegen stage
 
               const size_t samples_read = bytes_read / sizeof(int32_t) / 3;
@@ -0,0 +1,66 @@
+import argparse
+import json
+import re
+import sys
+
+"""
+Extract the events logged by the audio.dump_trace action into a Chrome trace file. Open the result in
+chrome://tracing or https://ui.perfetto.dev. Each pipeline object (reader, decoder, resampler, speaker) is shown as
+a process with one track per stage; timestamps are shifted so the first event starts at 0.
+"""
+EVENT_PATTERN = re.compile(r'(\{"name":.*\})')
+ANSI_PATTERN = re.compile(r"\x1b\[[0-9;]*m")
+
+
+def parse_events(lines):
+    events = []
+    for line in lines:
+        match = EVENT_PATTERN.search(ANSI_PATTERN.sub("", line))
+        if match is None:
+            continue
+        try:
+            events.append(json.loads(match.group(1)))
+        except json.JSONDecodeError:
+            # The logger may drop or truncate lines when the dump floods it
+            print(f"skipping malformed line: {line.strip()}", file=sys.stderr)
+    return events
+
+
+def build_trace(events):
+    if not events:
+        return {"traceEvents": []}
+
+    start = min(event["ts"] for event in events)
+    metadata = []
+    for pid in sorted({event["pid"] for event in events}):
+        stages = sorted({event["name"] for event in events if event["pid"] == pid})
+        name = "/".join(stage for stage in stages if not stage.endswith("_start")) or stages[0]
+        metadata.append({"name": "process_name", "ph": "M", "pid": pid, "args": {"name": f"{name} @{pid:#x}"}})
+    for pid, tid, name in sorted({(event["pid"], event["tid"], event["name"]) for event in events}):
+        metadata.append({"name": "thread_name", "ph": "M", "pid": pid, "tid": tid, "args": {"name": name}})
+
+    for event in events:
+        event["ts"] -= start
+    events.sort(key=lambda event: event["ts"])
+    return {"traceEvents": metadata + events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("log", nargs="?", help="device log containing the dump; reads stdin if omitted")
+    parser.add_argument("-o", "--output", default="audio_trace.json", help="Chrome trace file to write")
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log, encoding="utf-8", errors="replace") as f:
+            events = parse_events(f)
+    else:
+        events = parse_events(sys.stdin)
+
+    with open(args.output, "w", encoding="utf-8") as f:
+        json.dump(build_trace(events), f)
+    print(f"wrote {len(events)} events to {args.output}")
+
+
+if __name__ == "__main__":
+    main()
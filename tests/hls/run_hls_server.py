@@ -0,0 +1,113 @@
+import argparse
+import os
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+"""
+Serve an audio file as a synthetic HLS stream. The file is cut into fixed size segments listed in an m3u8
+playlist, either as a complete (VOD) playlist or as a live playlist whose window slides forward in real time.
+Each request is logged with the client's port, so reused keep-alive connections are visible.
+"""
+PORT = 8080
+SEGMENT_BYTES = 32 * 1024
+TARGET_DURATION_S = 2
+LIVE_WINDOW_SEGMENTS = 4
+
+CONTENT_TYPES = {
+    ".mp3": "audio/mpeg",
+    ".flac": "audio/flac",
+    ".opus": "audio/ogg",
+    ".ogg": "audio/ogg",
+}
+
+
+class HlsHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # Keep connections alive between requests
+
+    segments = []
+    content_type = "application/octet-stream"
+    extension = ""
+    live = False
+    master = False
+    start_time = 0.0
+
+    def log_message(self, format, *args):
+        print(f"{self.client_address[0]}:{self.client_address[1]} {format % args}")
+
+    def send_body(self, content_type, body):
+        self.send_response(200)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def media_playlist(self):
+        lines = ["#EXTM3U", "#EXT-X-VERSION:3", f"#EXT-X-TARGETDURATION:{TARGET_DURATION_S}"]
+        if self.live:
+            # The window advances one segment per target duration, looping over the file
+            newest = int((time.monotonic() - self.start_time) / TARGET_DURATION_S) + LIVE_WINDOW_SEGMENTS
+            first = max(0, newest - LIVE_WINDOW_SEGMENTS)
+            sequences = range(first, newest)
+        else:
+            first = 0
+            sequences = range(len(self.segments))
+        lines.append(f"#EXT-X-MEDIA-SEQUENCE:{first}")
+        for sequence in sequences:
+            lines.append(f"#EXTINF:{TARGET_DURATION_S}.0,")
+            lines.append(f"segment{sequence}{self.extension}")
+        if not self.live:
+            lines.append("#EXT-X-ENDLIST")
+        return ("\n".join(lines) + "\n").encode()
+
+    def do_GET(self):
+        path = self.path.split("?")[0].lstrip("/")
+
+        if path == "stream.m3u8" and self.master:
+            playlist = ("#EXTM3U\n"
+                        "#EXT-X-STREAM-INF:BANDWIDTH=256000\nhigh/media.m3u8\n"
+                        "#EXT-X-STREAM-INF:BANDWIDTH=128000\nlow/media.m3u8\n")
+            self.send_body("application/vnd.apple.mpegurl", playlist.encode())
+        elif path in ("stream.m3u8", "low/media.m3u8", "high/media.m3u8"):
+            self.send_body("application/vnd.apple.mpegurl", self.media_playlist())
+        elif os.path.basename(path).startswith("segment"):
+            name = os.path.splitext(os.path.basename(path))[0]
+            try:
+                sequence = int(name[len("segment"):])
+            except ValueError:
+                self.send_error(404)
+                return
+            if not self.live and sequence >= len(self.segments):
+                self.send_error(404)
+                return
+            self.send_body(self.content_type, self.segments[sequence % len(self.segments)])
+        else:
+            self.send_error(404)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("file", help="audio file to serve as segments, e.g., an mp3")
+    parser.add_argument("--port", type=int, default=PORT)
+    parser.add_argument("--segment-bytes", type=int, default=SEGMENT_BYTES, help="size of each segment")
+    parser.add_argument("--live", action="store_true", help="serve a sliding window live playlist without an end")
+    parser.add_argument("--master", action="store_true", help="serve a master playlist with two variants")
+    args = parser.parse_args()
+
+    with open(args.file, "rb") as f:
+        data = f.read()
+
+    HlsHandler.segments = [data[i:i + args.segment_bytes] for i in range(0, len(data), args.segment_bytes)]
+    HlsHandler.extension = os.path.splitext(args.file)[1].lower()
+    HlsHandler.content_type = CONTENT_TYPES.get(HlsHandler.extension, "application/octet-stream")
+    HlsHandler.live = args.live
+    HlsHandler.master = args.master
+    HlsHandler.start_time = time.monotonic()
+
+    server = ThreadingHTTPServer(("", args.port), HlsHandler)
+    print(f"Serving {len(HlsHandler.segments)} segments of {args.file} as "
+          f"http://<this machine's ip>:{args.port}/stream.m3u8 ({'live' if args.live else 'vod'})")
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,31 @@
+#pragma once
+
+// Minimal assertions for the host tests. A test binary returns the number of failed checks, so the runner treats any
+// non-zero exit as a failure.
+
+#include <chrono>
+#include <cstdio>
+
+namespace host_test {
+
+inline int failures = 0;
+
+inline void check(bool condition, const char *expression, const char *file, int line) {
+  if (!condition) {
+    printf("%s:%d: check failed: %s\n", file, line, expression);
+    ++failures;
+  }
+}
+
+inline double now_seconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline int finish(const char *name) {
+  printf("%s: %s (%d failed checks)\n", name, failures == 0 ? "passed" : "FAILED", failures);
+  return failures;
+}
+
+}  // namespace host_test
+
+#define HOST_CHECK(condition) host_test::check((condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,91 @@
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+"""
+Compile and run the host tests. Each test is built from its own source file plus the component sources it exercises,
+using the stand-ins in tests/host/stubs for the ESPHome core and ESP-IDF headers. Benchmarks print their timings; the
+numbers depend on the host and are only meaningful relative to each other.
+"""
+HOST_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_DIR = os.path.dirname(os.path.dirname(HOST_DIR))
+AUDIO_DIR = "esphome/components/audio"
+
+# Test source -> component sources it links against, relative to the repository root
+TESTS = {
+    "test_audio_buffer_pool.cpp": [
+        f"{AUDIO_DIR}/audio_buffer_pool.cpp",
+    ],
+    "test_audio_file_cache.cpp": [
+        f"{AUDIO_DIR}/audio_file_cache.cpp",
+    ],
+    "test_audio_reader.cpp": [
+        f"{AUDIO_DIR}/audio.cpp",
+        f"{AUDIO_DIR}/audio_gain.cpp",
+        f"{AUDIO_DIR}/audio_buffer_pool.cpp",
+        f"{AUDIO_DIR}/audio_hls_playlist.cpp",
+        f"{AUDIO_DIR}/audio_reader.cpp",
+        f"{AUDIO_DIR}/audio_transfer_buffer.cpp",
+    ],
+    "test_drift_compensator.cpp": [
+        f"{AUDIO_DIR}/audio.cpp",
+        f"{AUDIO_DIR}/audio_gain.cpp",
+        f"{AUDIO_DIR}/audio_channel_mixer.cpp",
+        f"{AUDIO_DIR}/audio_drift_compensator.cpp",
+    ],
+    "test_i2s_access_state.cpp": [],
+    "test_ogg_demuxer.cpp": [
+        f"{AUDIO_DIR}/audio_ogg_demuxer.cpp",
+    ],
+    "test_polyphase_resampler.cpp": [
+        f"{AUDIO_DIR}/audio.cpp",
+        f"{AUDIO_DIR}/audio_gain.cpp",
+        f"{AUDIO_DIR}/audio_channel_mixer.cpp",
+        f"{AUDIO_DIR}/audio_polyphase_resampler.cpp",
+    ],
+}
+
+CXX_FLAGS = ["-std=gnu++17", "-O2", "-Wall", "-pthread", "-DUSE_ESP32", "-DUSE_ESP_IDF"]
+
+
+def build(compiler, test, sources, output, extra_flags):
+    command = [compiler, *CXX_FLAGS, *extra_flags]
+    command += ["-I", os.path.join(HOST_DIR, "stubs"), "-I", HOST_DIR, "-I", REPO_DIR]
+    command += [os.path.join(HOST_DIR, test)]
+    command += [os.path.join(REPO_DIR, source) for source in sources]
+    command += ["-o", output]
+    return subprocess.run(command, check=False).returncode == 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build and run the host tests")
+    parser.add_argument("tests", nargs="*", help="names of the tests to run, e.g. test_polyphase_resampler; default all")
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "g++"), help="C++ compiler")
+    parser.add_argument("--sanitize", action="store_true", help="build with the address and undefined sanitizers")
+    args = parser.parse_args()
+
+    selected = [test for test in TESTS if not args.tests or os.path.splitext(test)[0] in args.tests]
+    extra_flags = ["-g", "-fsanitize=address,undefined"] if args.sanitize else []
+
+    failed = []
+    with tempfile.TemporaryDirectory() as build_dir:
+        for test in selected:
+            name = os.path.splitext(test)[0]
+            binary = os.path.join(build_dir, name)
+            print(f"=== {name}", flush=True)
+            if not build(args.cxx, test, TESTS[test], binary, extra_flags):
+                failed.append(name)
+                continue
+            if subprocess.run([binary], check=False).returncode != 0:
+                failed.append(name)
+
+    print(f"{len(selected) - len(failed)} of {len(selected)} host tests passed")
+    if failed:
+        print("failed: " + ", ".join(failed))
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
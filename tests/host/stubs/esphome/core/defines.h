@@ -0,0 +1,3 @@
+#pragma once
+
+// Host builds have no generated defines; tests enable the features they need with -D flags
@@ -0,0 +1,19 @@
+#pragma once
+
+// Host stand-in for esphome/core/hal.h. Time is simulated: it only advances when code calls delay, so tests of
+// timeouts and backoffs run instantly and can check how long the code waited.
+
+#include <atomic>
+#include <cstdint>
+
+namespace esphome {
+
+struct HostClock {
+  static inline std::atomic<uint32_t> now_ms{0};
+};
+
+inline uint32_t millis() { return HostClock::now_ms; }
+inline uint32_t micros() { return HostClock::now_ms * 1000; }
+inline void delay(uint32_t ms) { HostClock::now_ms += ms; }
+
+}  // namespace esphome
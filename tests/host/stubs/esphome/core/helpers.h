@@ -0,0 +1,130 @@
+#pragma once
+
+// Host stand-ins for the parts of esphome/core/helpers.h that the audio components use
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <cctype>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace esphome {
+
+template<typename T> T clamp(T value, T min, T max) { return value < min ? min : (value > max ? max : value); }
+
+using std::make_unique;
+
+inline std::string str_lower_case(const std::string &str) {
+  std::string lower = str;
+  std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+  return lower;
+}
+
+inline bool str_endswith(const std::string &str, const std::string &end) {
+  return (str.size() >= end.size()) && (str.compare(str.size() - end.size(), end.size(), end) == 0);
+}
+
+// Accounts for the heap used through RAMAllocator, so tests can check for leaks and simulate running out of memory.
+// Allocations that would take the live bytes past the limit fail.
+struct HostHeap {
+  static inline std::atomic<size_t> limit{SIZE_MAX};
+  static inline std::atomic<size_t> live_bytes{0};
+  static inline std::atomic<size_t> live_allocations{0};
+  static inline std::atomic<uint32_t> total_allocations{0};
+};
+
+template<class T> class RAMAllocator {
+ public:
+  enum Flags {
+    NONE = 0,
+    ALLOC_EXTERNAL = 1 << 0,
+    ALLOC_INTERNAL = 1 << 1,
+    ALLOW_FAILURE = 1 << 2,
+  };
+
+  RAMAllocator(uint8_t flags = 0) {}
+
+  T *allocate(size_t n) {
+    if (HostHeap::live_bytes + n * sizeof(T) > HostHeap::limit) {
+      return nullptr;
+    }
+    T *p = static_cast<T *>(malloc(n * sizeof(T)));
+    if (p != nullptr) {
+      HostHeap::live_bytes += malloc_usable_size(p);
+      ++HostHeap::live_allocations;
+      ++HostHeap::total_allocations;
+    }
+    return p;
+  }
+  T *reallocate(T *p, size_t n) {
+    const size_t old_bytes = (p != nullptr) ? malloc_usable_size(p) : 0;
+    if (HostHeap::live_bytes - old_bytes + n * sizeof(T) > HostHeap::limit) {
+      return nullptr;
+    }
+    T *reallocated = static_cast<T *>(realloc(p, n * sizeof(T)));
+    if (reallocated != nullptr) {
+      HostHeap::live_bytes += malloc_usable_size(reallocated);
+      HostHeap::live_bytes -= old_bytes;
+      if (p == nullptr) {
+        ++HostHeap::live_allocations;
+      }
+      ++HostHeap::total_allocations;
+    }
+    return reallocated;
+  }
+  void deallocate(T *p, size_t n) {
+    if (p != nullptr) {
+      HostHeap::live_bytes -= malloc_usable_size(p);
+      --HostHeap::live_allocations;
+    }
+    free(p);
+  }
+};
+
+template<class T> class ExternalRAMAllocator : public RAMAllocator<T> {
+ public:
+  using RAMAllocator<T>::RAMAllocator;
+};
+
+class Mutex {
+ public:
+  void lock() { this->mutex_.lock(); }
+  bool try_lock() { return this->mutex_.try_lock(); }
+  void unlock() { this->mutex_.unlock(); }
+
+ protected:
+  std::mutex mutex_;
+};
+
+class LockGuard {
+ public:
+  LockGuard(Mutex &mutex) : mutex_(mutex) { this->mutex_.lock(); }
+  ~LockGuard() { this->mutex_.unlock(); }
+
+ protected:
+  Mutex &mutex_;
+};
+
+template<typename... X> class CallbackManager;
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+ public:
+  void add(std::function<void(Ts...)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+  void call(Ts... args) {
+    for (auto &callback : this->callbacks_)
+      callback(args...);
+  }
+  size_t size() const { return this->callbacks_.size(); }
+
+ protected:
+  std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+}  // namespace esphome
@@ -0,0 +1,23 @@
+#pragma once
+
+// Host stand-in for esphome/core/log.h; warnings and errors are printed, everything else is dropped
+
+#include <cinttypes>
+#include <cstdio>
+
+#define ESPHOME_HOST_LOG(level, tag, format, ...) printf("[%s][%s] " format "\n", level, tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, ...) ESPHOME_HOST_LOG("E", tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ESPHOME_HOST_LOG("W", tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ((void) 0)
+#define ESP_LOGCONFIG(tag, ...) ((void) 0)
+#define ESP_LOGD(tag, ...) ((void) 0)
+#define ESP_LOGV(tag, ...) ((void) 0)
+#define ESP_LOGVV(tag, ...) ((void) 0)
+
+#define esph_log_e(tag, ...) ESPHOME_HOST_LOG("E", tag, __VA_ARGS__)
+#define esph_log_w(tag, ...) ESPHOME_HOST_LOG("W", tag, __VA_ARGS__)
+#define esph_log_i(tag, ...) ((void) 0)
+#define esph_log_config(tag, ...) ((void) 0)
+#define esph_log_d(tag, ...) ((void) 0)
+#define esph_log_v(tag, ...) ((void) 0)
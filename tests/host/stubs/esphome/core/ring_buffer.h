@@ -0,0 +1,74 @@
+#pragma once
+
+// Host stand-in for esphome/core/ring_buffer.h. Never blocks: reads and writes transfer what fits immediately.
+
+#include "esp_err.h"
+
+#include <freertos/FreeRTOS.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace esphome {
+
+class RingBuffer {
+ public:
+  size_t read(void *data, size_t len, TickType_t ticks_to_wait = 0) {
+    std::lock_guard<std::mutex> guard(this->mutex_);
+    const size_t bytes = std::min(len, this->data_.size());
+    std::copy(this->data_.begin(), this->data_.begin() + bytes, static_cast<uint8_t *>(data));
+    this->data_.erase(this->data_.begin(), this->data_.begin() + bytes);
+    return bytes;
+  }
+
+  size_t write(const void *data, size_t len) {
+    std::lock_guard<std::mutex> guard(this->mutex_);
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    this->data_.insert(this->data_.end(), bytes, bytes + len);
+    if (this->data_.size() > this->size_) {
+      // Overwrites the oldest data, like the real ring buffer
+      this->data_.erase(this->data_.begin(), this->data_.begin() + (this->data_.size() - this->size_));
+    }
+    return len;
+  }
+
+  size_t write_without_replacement(const void *data, size_t len, TickType_t ticks_to_wait = 0) {
+    std::lock_guard<std::mutex> guard(this->mutex_);
+    const size_t bytes = std::min(len, this->size_ - this->data_.size());
+    const uint8_t *source = static_cast<const uint8_t *>(data);
+    this->data_.insert(this->data_.end(), source, source + bytes);
+    return bytes;
+  }
+
+  size_t available() const {
+    std::lock_guard<std::mutex> guard(this->mutex_);
+    return this->data_.size();
+  }
+
+  size_t free() const {
+    std::lock_guard<std::mutex> guard(this->mutex_);
+    return this->size_ - this->data_.size();
+  }
+
+  void reset() {
+    std::lock_guard<std::mutex> guard(this->mutex_);
+    this->data_.clear();
+  }
+
+  static std::unique_ptr<RingBuffer> create(size_t len) {
+    std::unique_ptr<RingBuffer> ring_buffer(new RingBuffer());
+    ring_buffer->size_ = len;
+    return ring_buffer;
+  }
+
+ protected:
+  mutable std::mutex mutex_;
+  std::deque<uint8_t> data_;
+  size_t size_{0};
+};
+
+}  // namespace esphome
@@ -0,0 +1,11 @@
+#pragma once
+
+// Host stand-in for the FreeRTOS types that appear in component interfaces; host code never blocks on ticks
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+typedef int32_t BaseType_t;
+
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+#define portMAX_DELAY ((TickType_t) 0xffffffffUL)
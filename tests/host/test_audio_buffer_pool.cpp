@@ -0,0 +1,229 @@
+// Reuse, budget, and out of memory behavior of the audio buffer pool, plus a simulated playback session that reports
+// how many heap allocations the pool saves.
+//
+// The stub RAMAllocator accounts for every allocation in HostHeap, so the tests can check for leaks and lower the heap
+// limit to make allocations fail.
+
+#include "host_test.h"
+
+#include "esphome/components/audio/audio_buffer_pool.h"
+
+#include <thread>
+#include <vector>
+
+using esphome::HostHeap;
+using esphome::audio::AudioBufferPool;
+using esphome::audio::AudioBufferPoolStats;
+
+// Transfer buffers a track's pipeline acquires: reader output, decoder input and output, and speaker input
+static const size_t TRACK_BUFFER_SIZES[] = {8 * 1024, 8 * 1024, 8 * 1024, 4 * 1024};
+// The decoder grows its output buffer once it knows the stream's frame size
+static const size_t DECODER_REALLOCATED_SIZE = 12 * 1024;
+
+static void test_reuse() {
+  AudioBufferPool pool;
+
+  uint8_t *buffer = pool.acquire(1000);
+  HOST_CHECK(buffer != nullptr);
+  pool.release(buffer, 1000);
+  HOST_CHECK(pool.get_stats().cached_bytes == 1024);
+
+  // Any request in the same size class reuses the cached block without touching the heap
+  const uint32_t allocations = HostHeap::total_allocations;
+  uint8_t *reused = pool.acquire(1024);
+  HOST_CHECK(reused == buffer);
+  HOST_CHECK(HostHeap::total_allocations == allocations);
+
+  // The next class up needs a new block
+  uint8_t *larger = pool.acquire(1025);
+  HOST_CHECK(larger != nullptr && larger != buffer);
+  HOST_CHECK(HostHeap::total_allocations == allocations + 1);
+
+  AudioBufferPoolStats stats = pool.get_stats();
+  HOST_CHECK(stats.hits == 1);
+  HOST_CHECK(stats.misses == 2);
+  HOST_CHECK(stats.cached_bytes == 0);
+
+  pool.release(reused, 1024);
+  pool.release(larger, 1025);
+  HOST_CHECK(pool.get_stats().cached_bytes == 1024 + 1536);
+  pool.trim();
+  HOST_CHECK(pool.get_stats().cached_bytes == 0);
+}
+
+static void test_limits() {
+  const size_t live_allocations = HostHeap::live_allocations;
+  AudioBufferPool pool;
+
+  // Only AUDIO_BUFFER_POOL_BLOCKS_PER_CLASS blocks of a class are cached; the rest are freed
+  std::vector<uint8_t *> buffers;
+  for (uint8_t i = 0; i < esphome::audio::AUDIO_BUFFER_POOL_BLOCKS_PER_CLASS + 2; ++i) {
+    buffers.push_back(pool.acquire(2048));
+  }
+  for (uint8_t *buffer : buffers) {
+    pool.release(buffer, 2048);
+  }
+  HOST_CHECK(pool.get_stats().cached_bytes == esphome::audio::AUDIO_BUFFER_POOL_BLOCKS_PER_CLASS * 2048);
+  HOST_CHECK(HostHeap::live_allocations == live_allocations + esphome::audio::AUDIO_BUFFER_POOL_BLOCKS_PER_CLASS);
+
+  // Lowering the budget frees cached blocks immediately, and later releases respect it
+  pool.set_max_cached_bytes(4096);
+  HOST_CHECK(pool.get_stats().cached_bytes <= 4096);
+  uint8_t *buffer = pool.acquire(16 * 1024);
+  pool.release(buffer, 16 * 1024);
+  HOST_CHECK(pool.get_stats().cached_bytes <= 4096);
+
+  // Requests larger than the largest class bypass the pool entirely
+  const size_t huge_size = 256 * 1024;
+  uint8_t *huge = pool.acquire(huge_size);
+  HOST_CHECK(huge != nullptr);
+  pool.release(huge, huge_size);
+  HOST_CHECK(pool.get_stats().bypasses == 1);
+  HOST_CHECK(pool.get_stats().cached_bytes <= 4096);
+
+  pool.trim();
+  HOST_CHECK(HostHeap::live_allocations == live_allocations);
+}
+
+static void test_exhausted_heap() {
+  AudioBufferPool pool;
+
+  // Fill the cache with small blocks, then cap the heap so a large block only fits once they are freed
+  std::vector<uint8_t *> buffers;
+  for (size_t size = 1024; size <= 16 * 1024; size *= 2) {
+    buffers.push_back(pool.acquire(size));
+  }
+  size_t size = 1024;
+  for (uint8_t *buffer : buffers) {
+    pool.release(buffer, size);
+    size *= 2;
+  }
+  const size_t cached_bytes = pool.get_stats().cached_bytes;
+  HOST_CHECK(cached_bytes == 31 * 1024);
+
+  // Even with the cache freed, the request doesn't fit
+  const size_t request_size = 24 * 1024;
+  HostHeap::limit = HostHeap::live_bytes - cached_bytes;
+  uint8_t *buffer = pool.acquire(request_size);
+  HOST_CHECK(buffer == nullptr);
+  HOST_CHECK(pool.get_stats().cached_bytes == 0);
+
+  // Fill the cache again; this time the request fits once the cache is freed
+  HostHeap::limit = SIZE_MAX;
+  buffers.clear();
+  for (size = 1024; size <= 16 * 1024; size *= 2) {
+    buffers.push_back(pool.acquire(size));
+  }
+  size = 1024;
+  for (uint8_t *cached : buffers) {
+    pool.release(cached, size);
+    size *= 2;
+  }
+  HostHeap::limit = HostHeap::live_bytes - cached_bytes + request_size + 1024;
+  buffer = pool.acquire(request_size);
+  HOST_CHECK(buffer != nullptr);
+  HOST_CHECK(pool.get_stats().cached_bytes == 0);
+
+  // A failed allocation leaves the pool usable once memory is available again
+  HOST_CHECK(pool.acquire(request_size) == nullptr);
+  HostHeap::limit = SIZE_MAX;
+  uint8_t *second = pool.acquire(request_size);
+  HOST_CHECK(second != nullptr);
+
+  pool.release(buffer, request_size);
+  pool.release(second, request_size);
+  pool.trim();
+}
+
+static void test_threads() {
+  const size_t live_allocations = HostHeap::live_allocations;
+  AudioBufferPool pool;
+  pool.set_max_cached_bytes(64 * 1024);
+
+  std::vector<std::thread> threads;
+  for (uint8_t thread = 0; thread < 4; ++thread) {
+    threads.emplace_back([&pool, thread]() {
+      for (uint32_t i = 0; i < 20000; ++i) {
+        const size_t size = 512 + ((i * 7919 + thread * 104729) % (48 * 1024));
+        uint8_t *buffer = pool.acquire(size);
+        HOST_CHECK(buffer != nullptr);
+        buffer[0] = thread;
+        buffer[size - 1] = thread;
+        pool.release(buffer, size);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  const AudioBufferPoolStats stats = pool.get_stats();
+  HOST_CHECK(stats.hits + stats.misses == 4 * 20000);
+  HOST_CHECK(stats.cached_bytes <= 64 * 1024);
+  pool.trim();
+  HOST_CHECK(HostHeap::live_allocations == live_allocations);
+}
+
+// Plays a number of tracks through the pool and through the heap directly, and reports the heap allocations and time
+// spent getting buffers for each
+static void simulate_session(uint32_t tracks) {
+  AudioBufferPool pool;
+  esphome::RAMAllocator<uint8_t> allocator;
+
+  const uint32_t pool_allocations_start = HostHeap::total_allocations;
+  const double pool_start = host_test::now_seconds();
+  for (uint32_t track = 0; track < tracks; ++track) {
+    uint8_t *buffers[4];
+    for (uint8_t i = 0; i < 4; ++i) {
+      buffers[i] = pool.acquire(TRACK_BUFFER_SIZES[i]);
+    }
+    pool.release(buffers[2], TRACK_BUFFER_SIZES[2]);
+    buffers[2] = pool.acquire(DECODER_REALLOCATED_SIZE);
+    for (uint8_t i = 0; i < 4; ++i) {
+      pool.release(buffers[i], i == 2 ? DECODER_REALLOCATED_SIZE : TRACK_BUFFER_SIZES[i]);
+    }
+  }
+  const double pool_seconds = host_test::now_seconds() - pool_start;
+  const uint32_t pool_allocations = HostHeap::total_allocations - pool_allocations_start;
+
+  const uint32_t heap_allocations_start = HostHeap::total_allocations;
+  const double heap_start = host_test::now_seconds();
+  for (uint32_t track = 0; track < tracks; ++track) {
+    uint8_t *buffers[4];
+    for (uint8_t i = 0; i < 4; ++i) {
+      buffers[i] = allocator.allocate(TRACK_BUFFER_SIZES[i]);
+    }
+    allocator.deallocate(buffers[2], TRACK_BUFFER_SIZES[2]);
+    buffers[2] = allocator.allocate(DECODER_REALLOCATED_SIZE);
+    for (uint8_t i = 0; i < 4; ++i) {
+      allocator.deallocate(buffers[i], i == 2 ? DECODER_REALLOCATED_SIZE : TRACK_BUFFER_SIZES[i]);
+    }
+  }
+  const double heap_seconds = host_test::now_seconds() - heap_start;
+  const uint32_t heap_allocations = HostHeap::total_allocations - heap_allocations_start;
+
+  const AudioBufferPoolStats stats = pool.get_stats();
+  printf("  %u tracks: pool %u hits, %u misses, %u heap allocations; heap only %u allocations\n", tracks, stats.hits,
+         stats.misses, pool_allocations, heap_allocations);
+  printf("  %.0f ns per buffer from the pool, %.0f ns from the host heap\n", 1e9 * pool_seconds / (tracks * 5),
+         1e9 * heap_seconds / (tracks * 5));
+
+  // Only the first track allocates; every later one is served from the cache
+  HOST_CHECK(stats.misses == 5);
+  HOST_CHECK(stats.hits == 5 * (tracks - 1));
+  HOST_CHECK(pool_allocations == 5);
+  HOST_CHECK(heap_allocations == 5 * tracks);
+  pool.trim();
+}
+
+int main() {
+  test_reuse();
+  test_limits();
+  test_exhausted_heap();
+  test_threads();
+  simulate_session(50);
+  simulate_session(10000);
+
+  HOST_CHECK(HostHeap::live_allocations == 0);
+  return host_test::finish("test_audio_buffer_pool");
+}
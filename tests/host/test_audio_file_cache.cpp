@@ -0,0 +1,222 @@
+// LRU eviction, hits and misses of the in-memory audio file cache, and the file-backed store it persists files to,
+// including stored files that are truncated, corrupt, or left over from an interrupted write.
+//
+// The store is backed by a temporary directory on the host, standing in for a filesystem mounted in the VFS.
+
+#include "host_test.h"
+
+#include "esphome/components/audio/audio_file_cache.h"
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using esphome::HostHeap;
+using esphome::make_unique;
+using esphome::audio::AudioCacheEntry;
+using esphome::audio::AudioFile;
+using esphome::audio::AudioFileCache;
+using esphome::audio::AudioFileStore;
+using esphome::audio::AudioFileType;
+
+static const size_t FILE_SIZE = 1000;
+
+// Inserts a file filled with a byte derived from the url, as AudioReader does once a download completes
+static void insert_file(AudioFileCache &cache, const std::string &url, const std::string &etag = "",
+                        size_t length = FILE_SIZE) {
+  uint8_t *data = cache.allocate(length);
+  HOST_CHECK(data != nullptr);
+  if (data != nullptr) {
+    memset(data, static_cast<uint8_t>(url.back()), length);
+  }
+  cache.insert(url, etag, AudioFileType::WAV, data, length);
+}
+
+static bool holds_file(const std::shared_ptr<AudioCacheEntry> &entry, const std::string &url,
+                       size_t length = FILE_SIZE) {
+  if (entry == nullptr) {
+    return false;
+  }
+  const AudioFile *file = entry->get_audio_file();
+  if ((file->length != length) || (file->file_type != AudioFileType::WAV)) {
+    return false;
+  }
+  for (size_t i = 0; i < length; ++i) {
+    if (file->data[i] != static_cast<uint8_t>(url.back())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static std::vector<std::string> list_directory(const std::string &directory) {
+  std::vector<std::string> names;
+  DIR *dir = opendir(directory.c_str());
+  struct dirent *dir_entry;
+  while ((dir != nullptr) && ((dir_entry = readdir(dir)) != nullptr)) {
+    if (dir_entry->d_name[0] != '.') {
+      names.push_back(dir_entry->d_name);
+    }
+  }
+  if (dir != nullptr) {
+    closedir(dir);
+  }
+  return names;
+}
+
+static void clear_directory(const std::string &directory) {
+  for (const auto &name : list_directory(directory)) {
+    std::remove((directory + "/" + name).c_str());
+  }
+}
+
+static void test_memory_lru() {
+  AudioFileCache cache;
+  cache.set_max_bytes(3 * FILE_SIZE);
+
+  HOST_CHECK(cache.lookup("http://host/a") == nullptr);
+  HOST_CHECK(!cache.can_cache(3 * FILE_SIZE + 1));
+  HOST_CHECK(cache.allocate(3 * FILE_SIZE + 1) == nullptr);
+
+  insert_file(cache, "http://host/a");
+  insert_file(cache, "http://host/b");
+  insert_file(cache, "http://host/c");
+  HOST_CHECK(cache.get_cached_bytes() == 3 * FILE_SIZE);
+
+  // Using a makes b the least recently used, so b is evicted to fit d
+  HOST_CHECK(holds_file(cache.lookup("http://host/a"), "http://host/a"));
+  insert_file(cache, "http://host/d");
+  HOST_CHECK(cache.get_cached_bytes() == 3 * FILE_SIZE);
+  HOST_CHECK(cache.lookup("http://host/b") == nullptr);
+  HOST_CHECK(holds_file(cache.lookup("http://host/a"), "http://host/a"));
+  HOST_CHECK(holds_file(cache.lookup("http://host/c"), "http://host/c"));
+  HOST_CHECK(holds_file(cache.lookup("http://host/d"), "http://host/d"));
+
+  // The same ETag from another url shares the stored copy
+  insert_file(cache, "http://host/e", "\"etag\"");
+  insert_file(cache, "http://mirror/e", "\"etag\"");
+  HOST_CHECK(cache.get_cached_bytes() == 3 * FILE_SIZE);
+  HOST_CHECK(cache.lookup("http://host/e") == cache.lookup("http://mirror/e"));
+
+  // An entry evicted while it is being read stays valid until the reader releases it
+  auto playing = cache.lookup("http://host/e");
+  cache.clear();
+  HOST_CHECK(cache.get_cached_bytes() == 0);
+  HOST_CHECK(cache.lookup("http://host/e") == nullptr);
+  HOST_CHECK(holds_file(playing, "http://host/e"));
+}
+
+static void test_store(const std::string &directory) {
+  const size_t live_allocations = HostHeap::live_allocations;
+  {
+    AudioFileCache cache;
+    cache.set_max_bytes(2 * FILE_SIZE);
+    cache.set_store(make_unique<AudioFileStore>(directory, 3 * (FILE_SIZE + 100)));
+
+    insert_file(cache, "http://host/a", "\"a\"");
+    insert_file(cache, "http://host/b");
+    insert_file(cache, "http://host/c");
+    HOST_CHECK(list_directory(directory).size() == 3);
+
+    // a was evicted from memory to fit c, but is reloaded from the store
+    HOST_CHECK(cache.get_cached_bytes() == 2 * FILE_SIZE);
+    HOST_CHECK(holds_file(cache.lookup("http://host/a"), "http://host/a"));
+
+    // The store evicts its least recently used file, b, to fit d
+    insert_file(cache, "http://host/d");
+    HOST_CHECK(list_directory(directory).size() == 3);
+    cache.clear();
+    HOST_CHECK(cache.lookup("http://host/b") == nullptr);
+    HOST_CHECK(holds_file(cache.lookup("http://host/a"), "http://host/a"));
+    HOST_CHECK(holds_file(cache.lookup("http://host/d"), "http://host/d"));
+  }
+  HOST_CHECK(HostHeap::live_allocations == live_allocations);
+
+  // A new cache and store on the same directory, as after a reboot, finds the stored files
+  AudioFileCache cache;
+  cache.set_max_bytes(2 * FILE_SIZE);
+  cache.set_store(make_unique<AudioFileStore>(directory, 3 * (FILE_SIZE + 100)));
+  HOST_CHECK(holds_file(cache.lookup("http://host/c"), "http://host/c"));
+  HOST_CHECK(cache.lookup("http://host/missing") == nullptr);
+  cache.clear();
+}
+
+static void test_store_damaged_files(const std::string &directory) {
+  clear_directory(directory);
+  {
+    AudioFileCache cache;
+    cache.set_max_bytes(4 * FILE_SIZE);
+    cache.set_store(make_unique<AudioFileStore>(directory, 4 * (FILE_SIZE + 100)));
+    insert_file(cache, "http://host/a");
+    insert_file(cache, "http://host/b");
+    insert_file(cache, "http://host/c");
+  }
+  const auto names = list_directory(directory);
+  HOST_CHECK(names.size() == 3);
+  if (names.size() != 3) {
+    return;
+  }
+
+  // Flip a byte in the audio data of one file and cut another short, as a failing flash or power loss might
+  const std::string corrupt_path = directory + "/" + names[0];
+  FILE *file = fopen(corrupt_path.c_str(), "r+b");
+  fseek(file, -10, SEEK_END);
+  fputc(0x5a, file);
+  fclose(file);
+  const std::string truncated_path = directory + "/" + names[1];
+  HOST_CHECK(truncate(truncated_path.c_str(), 600) == 0);
+
+  // A write interrupted before the rename leaves only a temporary file
+  file = fopen((directory + "/0badf11e.acf.tmp").c_str(), "wb");
+  fputs("partial", file);
+  fclose(file);
+
+  AudioFileCache cache;
+  cache.set_max_bytes(4 * FILE_SIZE);
+  cache.set_store(make_unique<AudioFileStore>(directory, 4 * (FILE_SIZE + 100)));
+
+  // Exactly one file is still intact; the damaged ones are misses and are deleted when found
+  uint8_t hits = 0;
+  for (const char *url : {"http://host/a", "http://host/b", "http://host/c"}) {
+    if (holds_file(cache.lookup(url), url)) {
+      ++hits;
+    }
+  }
+  HOST_CHECK(hits == 1);
+  const auto remaining = list_directory(directory);
+  HOST_CHECK(remaining.size() == 1);
+  HOST_CHECK((remaining.size() == 1) && (remaining[0] == names[2]));
+
+  // The damaged urls can be downloaded and stored again
+  insert_file(cache, "http://host/a");
+  insert_file(cache, "http://host/b");
+  insert_file(cache, "http://host/c");
+  cache.clear();
+  for (const char *url : {"http://host/a", "http://host/b", "http://host/c"}) {
+    HOST_CHECK(holds_file(cache.lookup(url), url));
+  }
+  cache.clear();
+}
+
+int main() {
+  char directory_template[] = "/tmp/audio_file_cache_XXXXXX";
+  const char *directory = mkdtemp(directory_template);
+  HOST_CHECK(directory != nullptr);
+  if (directory == nullptr) {
+    return host_test::finish("test_audio_file_cache");
+  }
+
+  test_memory_lru();
+  test_store(directory);
+  test_store_damaged_files(directory);
+
+  clear_directory(directory);
+  rmdir(directory);
+
+  HOST_CHECK(HostHeap::live_allocations == 0);
+  return host_test::finish("test_audio_file_cache");
+}
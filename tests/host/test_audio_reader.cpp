@@ -0,0 +1,362 @@
+// Resuming and seeking http downloads in AudioReader. The reader runs against a scripted fake server that implements
+// the esp_http_client API: it can drop the connection at chosen offsets, ignore Range requests and reply 200 with the
+// whole file instead of 206, refuse connections, or omit the content length like a live stream.
+//
+// Every test drains the sink ring buffer while reading and checks it received exactly the bytes of the file, in
+// order, from the offset it started or seeked to.
+
+#include "host_test.h"
+
+#include "esphome/components/audio/audio_buffer_pool.h"
+#include "esphome/components/audio/audio_reader.h"
+#include "esphome/core/hal.h"
+
+#include <esp_http_client.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using esphome::HostClock;
+using esphome::HostHeap;
+using esphome::RingBuffer;
+using esphome::audio::AudioFileType;
+using esphome::audio::AudioReader;
+using esphome::audio::AudioReaderState;
+
+static const size_t FILE_SIZE = 20000;
+static const size_t TRANSFER_BUFFER_SIZE = 1024;
+static const size_t SINK_BUFFER_SIZE = 4096;
+// The fake server returns at most this many bytes per read, so reads don't line up with the transfer buffer
+static const int SERVER_CHUNK_SIZE = 700;
+static const char *const FILE_URL = "http://host/file.wav";
+
+static uint8_t file_byte(size_t offset) { return static_cast<uint8_t>((offset * 7) ^ (offset >> 8)); }
+
+// Behavior of the fake server, shared by every connection the reader opens
+struct FakeServer {
+  // Connections drop with a read error once they have sent up to these offsets, each only once
+  std::vector<size_t> drop_offsets;
+  // Number of requests, counting from the first, that honor Range headers; later ones reply 200 with the whole file
+  size_t ranged_requests{SIZE_MAX};
+  // Number of upcoming requests that fail to open
+  size_t failed_opens{0};
+  bool send_content_length{true};
+
+  // Offset requested by each successful request, 0 if it had no Range header
+  std::vector<size_t> requested_offsets;
+  size_t open_clients{0};
+};
+
+static FakeServer server;
+
+struct esp_http_client {
+  std::string url;
+  http_event_handle_cb event_handler;
+  void *user_data;
+  std::string range;
+  int status_code{0};
+  size_t position{0};
+  bool open{false};
+};
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config) {
+  esp_http_client_handle_t client = new esp_http_client();
+  client->url = config->url;
+  client->event_handler = config->event_handler;
+  client->user_data = config->user_data;
+  ++server.open_clients;
+  return client;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url) {
+  client->url = url;
+  return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value) {
+  if (strcmp(key, "Range") == 0) {
+    client->range = value;
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key) {
+  if (strcmp(key, "Range") == 0) {
+    client->range.clear();
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len) {
+  if (server.failed_opens > 0) {
+    --server.failed_opens;
+    return ESP_FAIL;
+  }
+
+  size_t offset = 0;
+  if (!client->range.empty()) {
+    sscanf(client->range.c_str(), "bytes=%zu-", &offset);
+  }
+  server.requested_offsets.push_back(offset);
+
+  if ((offset > 0) && (server.requested_offsets.size() <= server.ranged_requests)) {
+    client->status_code = (offset < FILE_SIZE) ? 206 : 416;
+    client->position = offset;
+  } else {
+    client->status_code = 200;
+    client->position = 0;
+  }
+  client->open = true;
+  return ESP_OK;
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client) {
+  char key[] = "Content-Type";
+  char value[] = "audio/wav";
+  esp_http_client_event_t event = {};
+  event.event_id = HTTP_EVENT_ON_HEADER;
+  event.client = client;
+  event.user_data = client->user_data;
+  event.header_key = key;
+  event.header_value = value;
+  client->event_handler(&event);
+  return esp_http_client_get_content_length(client);
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client) { return client->status_code; }
+
+int64_t esp_http_client_get_content_length(esp_http_client_handle_t client) {
+  if (!server.send_content_length) {
+    // Like a response without a Content-Length header
+    return 0;
+  }
+  return FILE_SIZE - client->position;
+}
+
+esp_err_t esp_http_client_set_redirection(esp_http_client_handle_t client) { return ESP_ERR_INVALID_ARG; }
+
+esp_err_t esp_http_client_get_url(esp_http_client_handle_t client, char *url, const int len) {
+  snprintf(url, len, "%s", client->url.c_str());
+  return ESP_OK;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len) {
+  if (!client->open) {
+    return -1;
+  }
+
+  size_t end = std::min(FILE_SIZE, client->position + std::min(len, SERVER_CHUNK_SIZE));
+  for (auto drop = server.drop_offsets.begin(); drop != server.drop_offsets.end(); ++drop) {
+    if ((*drop >= client->position) && (*drop < end)) {
+      end = *drop;
+      if (end == client->position) {
+        server.drop_offsets.erase(drop);
+        client->open = false;
+        return -1;
+      }
+      break;
+    }
+  }
+
+  for (size_t offset = client->position; offset < end; ++offset) {
+    buffer[offset - client->position] = static_cast<char>(file_byte(offset));
+  }
+  const int bytes = end - client->position;
+  client->position = end;
+  return bytes;
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client) {
+  return client->open && (client->position == FILE_SIZE);
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client) {
+  client->open = false;
+  return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client) {
+  delete client;
+  --server.open_clients;
+  return ESP_OK;
+}
+
+// Starts reading FILE_URL into a fresh sink
+static std::shared_ptr<RingBuffer> start_reader(AudioReader &reader) {
+  AudioFileType file_type;
+  HOST_CHECK(reader.start(FILE_URL, file_type) == ESP_OK);
+  HOST_CHECK(file_type == AudioFileType::WAV);
+
+  std::shared_ptr<RingBuffer> sink = RingBuffer::create(SINK_BUFFER_SIZE);
+  HOST_CHECK(reader.add_sink(sink) == ESP_OK);
+  return sink;
+}
+
+// Reads until the reader finishes or fails, or the sink has received max_bytes, moving the sink's data to received
+static AudioReaderState read_into(AudioReader &reader, RingBuffer &sink, std::vector<uint8_t> &received,
+                                  size_t max_bytes = SIZE_MAX) {
+  uint8_t chunk[512];
+  AudioReaderState state = AudioReaderState::READING;
+  for (uint32_t i = 0; (i < 100000) && (state == AudioReaderState::READING) && (received.size() < max_bytes); ++i) {
+    state = reader.read();
+    while (size_t bytes = sink.read(chunk, std::min(sizeof(chunk), max_bytes - received.size()))) {
+      received.insert(received.end(), chunk, chunk + bytes);
+    }
+  }
+  return state;
+}
+
+static bool matches_file(const std::vector<uint8_t> &received, size_t start_offset) {
+  if (received.size() != FILE_SIZE - start_offset) {
+    return false;
+  }
+  for (size_t i = 0; i < received.size(); ++i) {
+    if (received[i] != file_byte(start_offset + i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void reset_server() {
+  server = FakeServer();
+  HostClock::now_ms = 0;
+}
+
+static void test_clean_download() {
+  reset_server();
+  AudioReader reader(TRANSFER_BUFFER_SIZE);
+  std::shared_ptr<RingBuffer> sink = start_reader(reader);
+  HOST_CHECK(reader.get_content_length() == FILE_SIZE);
+
+  std::vector<uint8_t> received;
+  HOST_CHECK(read_into(reader, *sink, received) == AudioReaderState::FINISHED);
+  HOST_CHECK(matches_file(received, 0));
+  HOST_CHECK(server.requested_offsets == std::vector<size_t>({0}));
+  HOST_CHECK(server.open_clients == 0);
+}
+
+static void test_resume_with_range() {
+  reset_server();
+  server.drop_offsets = {3000, 3000, 11111};
+  AudioReader reader(TRANSFER_BUFFER_SIZE);
+  std::shared_ptr<RingBuffer> sink = start_reader(reader);
+
+  std::vector<uint8_t> received;
+  HOST_CHECK(read_into(reader, *sink, received) == AudioReaderState::FINISHED);
+  HOST_CHECK(matches_file(received, 0));
+  // The resumed connection drops again before sending anything, so 3000 is requested twice
+  HOST_CHECK(server.requested_offsets == std::vector<size_t>({0, 3000, 3000, 11111}));
+  HOST_CHECK(reader.get_byte_offset() == FILE_SIZE);
+}
+
+static void test_resume_without_range_support() {
+  reset_server();
+  // The first request has no Range header, so only it is "honored"; every resume gets the whole file again
+  server.ranged_requests = 1;
+  server.drop_offsets = {5000, 12345};
+  AudioReader reader(TRANSFER_BUFFER_SIZE);
+  std::shared_ptr<RingBuffer> sink = start_reader(reader);
+
+  std::vector<uint8_t> received;
+  HOST_CHECK(read_into(reader, *sink, received) == AudioReaderState::FINISHED);
+  HOST_CHECK(matches_file(received, 0));
+  HOST_CHECK(server.requested_offsets == std::vector<size_t>({0, 5000, 12345}));
+  // The length comes from the 200 reply, which covers the whole file
+  HOST_CHECK(reader.get_content_length() == FILE_SIZE);
+}
+
+static void test_reconnect_backoff() {
+  reset_server();
+  server.drop_offsets = {8000};
+  AudioReader reader(TRANSFER_BUFFER_SIZE);
+  std::shared_ptr<RingBuffer> sink = start_reader(reader);
+
+  std::vector<uint8_t> received;
+  HOST_CHECK(read_into(reader, *sink, received, 6000) == AudioReaderState::READING);
+  server.failed_opens = 3;
+  const uint32_t start_ms = HostClock::now_ms;
+  HOST_CHECK(read_into(reader, *sink, received) == AudioReaderState::FINISHED);
+  HOST_CHECK(matches_file(received, 0));
+  // Three failed attempts and the successful fourth, waiting 250, 500, 1000, then 2000 ms before them
+  HOST_CHECK(HostClock::now_ms - start_ms == 3750);
+  HOST_CHECK(server.requested_offsets == std::vector<size_t>({0, 8000}));
+
+  // Gives up after five failed attempts
+  reset_server();
+  server.drop_offsets = {8000};
+  AudioReader failing_reader(TRANSFER_BUFFER_SIZE);
+  sink = start_reader(failing_reader);
+  received.clear();
+  server.failed_opens = 5;
+  HOST_CHECK(read_into(failing_reader, *sink, received) == AudioReaderState::FAILED);
+  HOST_CHECK(received.size() == 8000);
+  HOST_CHECK(HostClock::now_ms == 7750);
+  HOST_CHECK(server.open_clients == 0);
+}
+
+static void test_resume_live_stream() {
+  reset_server();
+  // Without a content length, a resume can't be placed, so the reader reconnects from the start without a Range
+  server.send_content_length = false;
+  server.drop_offsets = {4000};
+  AudioReader reader(TRANSFER_BUFFER_SIZE);
+  std::shared_ptr<RingBuffer> sink = start_reader(reader);
+  HOST_CHECK(reader.get_content_length() == 0);
+
+  std::vector<uint8_t> received;
+  HOST_CHECK(read_into(reader, *sink, received) == AudioReaderState::FINISHED);
+  HOST_CHECK(server.requested_offsets == std::vector<size_t>({0, 0}));
+  // The sink gets the first 4000 bytes, then the whole stream again
+  HOST_CHECK(received.size() == 4000 + FILE_SIZE);
+  received.erase(received.begin(), received.begin() + std::min<size_t>(4000, received.size()));
+  HOST_CHECK(matches_file(received, 0));
+}
+
+static void test_seek(size_t ranged_requests) {
+  reset_server();
+  server.ranged_requests = ranged_requests;
+  AudioReader reader(TRANSFER_BUFFER_SIZE);
+  HOST_CHECK(reader.seek(100) == ESP_ERR_INVALID_STATE);
+  std::shared_ptr<RingBuffer> sink = start_reader(reader);
+
+  std::vector<uint8_t> received;
+  HOST_CHECK(read_into(reader, *sink, received, 3000) == AudioReaderState::READING);
+  HOST_CHECK(reader.seek(FILE_SIZE) == ESP_ERR_INVALID_ARG);
+
+  // Seeking discards what the sink hasn't consumed yet, then continues from the new offset; a drop after the seek
+  // resumes from there too
+  server.drop_offsets = {15000};
+  HOST_CHECK(reader.seek(9000) == ESP_OK);
+  HOST_CHECK(reader.get_byte_offset() == 9000);
+  HOST_CHECK(sink->available() == 0);
+  received.clear();
+  HOST_CHECK(read_into(reader, *sink, received) == AudioReaderState::FINISHED);
+  HOST_CHECK(matches_file(received, 9000));
+  HOST_CHECK(reader.get_content_length() == FILE_SIZE);
+  HOST_CHECK(server.requested_offsets == std::vector<size_t>({0, 9000, 15000}));
+
+  // Seeking backwards after finishing isn't possible, as the connection is closed
+  HOST_CHECK(reader.seek(0) == ESP_ERR_INVALID_STATE);
+}
+
+int main() {
+  test_clean_download();
+  test_resume_with_range();
+  test_resume_without_range_support();
+  test_reconnect_backoff();
+  test_resume_live_stream();
+  test_seek(SIZE_MAX);
+  // A server that ignores Range requests still lands the seek on the right byte
+  test_seek(1);
+
+  // Transfer buffers come from the pool, which keeps released ones for reuse
+  esphome::audio::AudioBufferPool::get().trim();
+  HOST_CHECK(server.open_clients == 0);
+  HOST_CHECK(HostHeap::live_allocations == 0);
+  return host_test::finish("test_audio_reader");
+}
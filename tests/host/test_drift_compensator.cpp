@@ -0,0 +1,266 @@
+// Simulates a stream whose producer and consumer clocks differ by up to +/-200 ppm and checks that the drift
+// compensator's servo locks onto the drift and holds the buffer at its target fill level.
+//
+// The compensator is simulated as an I2SSourceSpeaker uses it: the producer writes into a buffer on its own clock, and
+// the compensator reads it to generate exactly what the local clock consumes. The buffer starts primed to the target
+// fill level, as a stream's jitter buffer would be. The correction is limited to 500 ppm, so the servo can only move
+// the fill level by 0.5 ms per second; it is meant to absorb drift, not to fill an empty buffer.
+//
+// Also checks the channel matrix a source speaker fuses into the compensator's filter.
+
+#include "host_test.h"
+
+#include "esphome/components/audio/audio.h"
+#include "esphome/components/audio/audio_channel_mixer.h"
+#include "esphome/components/audio/audio_drift_compensator.h"
+
+#include <cmath>
+#include <deque>
+#include <vector>
+
+using esphome::audio::AudioStreamInfo;
+using esphome::audio::ChannelMixer;
+using esphome::audio::DriftCompensator;
+
+static const double PI = 3.14159265358979323846;
+
+static const uint32_t SAMPLE_RATE = 16000;
+static const uint32_t BLOCK_FRAMES = SAMPLE_RATE / 100;  // 10 ms blocks, like the speaker task's loop
+static const uint32_t SIMULATED_SECONDS = 20 * 60;
+static const uint32_t LOCK_SECONDS = 180;
+
+struct SimulationResults {
+  double final_correction_ppm;
+  double worst_locked_correction_error_ppm;  // After LOCK_SECONDS
+  double worst_locked_fill_error;            // After LOCK_SECONDS, as a fraction of the capacity
+  uint32_t underruns;                        // Blocks the consumer couldn't fully fill
+  uint32_t overflows;                        // Blocks the producer couldn't fully write
+};
+
+// Generates a continuous tone one block at a time
+class ToneSource {
+ public:
+  explicit ToneSource(double frequency) : frequency_(frequency) {}
+
+  void generate(int16_t *output, uint32_t frames) {
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      output[frame] = static_cast<int16_t>(std::lround(16000.0 * std::sin(this->phase_)));
+      this->phase_ += 2.0 * PI * this->frequency_ / SAMPLE_RATE;
+      if (this->phase_ > 2.0 * PI) {
+        this->phase_ -= 2.0 * PI;
+      }
+    }
+  }
+
+ protected:
+  double frequency_;
+  double phase_{0.0};
+};
+
+// Frames per 10 ms block on a clock that runs drift_ppm fast, carrying the fraction to the next block
+class DriftingClock {
+ public:
+  explicit DriftingClock(double drift_ppm) : frames_per_block_(BLOCK_FRAMES * (1.0 + drift_ppm * 1e-6)) {}
+
+  uint32_t next_block_frames() {
+    this->accumulated_ += this->frames_per_block_;
+    const uint32_t frames = static_cast<uint32_t>(this->accumulated_);
+    this->accumulated_ -= frames;
+    return frames;
+  }
+
+ protected:
+  double frames_per_block_;
+  double accumulated_{0.0};
+};
+
+static void track_locked(SimulationResults &results, uint32_t block, const DriftCompensator &compensator,
+                         double expected_correction_ppm, size_t buffered_frames, uint32_t capacity_frames) {
+  if (block * BLOCK_FRAMES < LOCK_SECONDS * SAMPLE_RATE) {
+    return;
+  }
+  results.worst_locked_correction_error_ppm =
+      std::max(results.worst_locked_correction_error_ppm,
+               std::fabs(compensator.get_correction_ppm() - expected_correction_ppm));
+  results.worst_locked_fill_error =
+      std::max(results.worst_locked_fill_error,
+               std::fabs(static_cast<double>(buffered_frames) / capacity_frames - 0.5));
+}
+
+static SimulationResults simulate_source_side(double producer_drift_ppm, uint32_t capacity_frames) {
+  const AudioStreamInfo stream_info(16, 1, SAMPLE_RATE);
+  DriftCompensator compensator;
+  HOST_CHECK(compensator.initialize(stream_info, stream_info));
+
+  SimulationResults results{};
+  ToneSource source(440.0);
+  DriftingClock producer_clock(producer_drift_ppm);
+
+  std::deque<int16_t> buffer(capacity_frames / 2);
+  std::vector<int16_t> input(2 * BLOCK_FRAMES);
+  std::vector<int16_t> staged;
+  std::vector<int16_t> output(BLOCK_FRAMES);
+
+  const uint32_t blocks = SIMULATED_SECONDS * SAMPLE_RATE / BLOCK_FRAMES;
+  for (uint32_t block = 0; block < blocks; ++block) {
+    // The producer writes on its own clock, dropping what doesn't fit
+    const uint32_t produced = producer_clock.next_block_frames();
+    source.generate(input.data(), produced);
+    const uint32_t written = std::min<uint32_t>(produced, capacity_frames - buffer.size());
+    if (written < produced) {
+      ++results.overflows;
+    }
+    buffer.insert(buffer.end(), input.begin(), input.begin() + written);
+
+    // The local clock pulls exactly one block through the compensator
+    uint32_t generated = 0;
+    while (generated < BLOCK_FRAMES) {
+      const size_t to_stage = std::min<size_t>(buffer.size(), 256 - staged.size());
+      staged.insert(staged.end(), buffer.begin(), buffer.begin() + to_stage);
+      buffer.erase(buffer.begin(), buffer.begin() + to_stage);
+
+      auto converted = compensator.resample(reinterpret_cast<const uint8_t *>(staged.data()),
+                                            reinterpret_cast<uint8_t *>(output.data() + generated), staged.size(),
+                                            BLOCK_FRAMES - generated);
+      staged.erase(staged.begin(), staged.begin() + converted.frames_used);
+      generated += converted.frames_generated;
+      if ((converted.frames_used == 0) && (converted.frames_generated == 0)) {
+        break;
+      }
+    }
+    if (generated < BLOCK_FRAMES) {
+      ++results.underruns;
+    }
+
+    compensator.update_buffer_level(buffer.size() + staged.size(), capacity_frames);
+    // A fast producer fills the buffer, so the compensator consumes input faster than nominal
+    track_locked(results, block, compensator, producer_drift_ppm, buffer.size() + staged.size(), capacity_frames);
+  }
+
+  results.final_correction_ppm = compensator.get_correction_ppm();
+  return results;
+}
+
+static void check_results(const char *name, double drift_ppm, uint32_t capacity_frames,
+                          const SimulationResults &results) {
+  printf("  %s %+.0f ppm, %u ms buffer: correction %+.1f ppm, locked within %.1f ppm, fill within %.1f%%, "
+         "%u underruns, %u overflows\n",
+         name, drift_ppm, capacity_frames * 1000 / SAMPLE_RATE, results.final_correction_ppm,
+         results.worst_locked_correction_error_ppm, 100.0 * results.worst_locked_fill_error, results.underruns,
+         results.overflows);
+  HOST_CHECK(results.worst_locked_correction_error_ppm < 10.0);
+  HOST_CHECK(results.worst_locked_fill_error < 0.1);
+  HOST_CHECK(results.underruns == 0);
+  HOST_CHECK(results.overflows == 0);
+}
+
+// Converts a tone with the servo held at a constant +200 ppm correction and fits the expected tone to the output to
+// measure the interpolation error
+static double measure_snr_db(double frequency) {
+  const AudioStreamInfo stream_info(16, 1, SAMPLE_RATE);
+  DriftCompensator compensator;
+  HOST_CHECK(compensator.initialize(stream_info, stream_info));
+
+  ToneSource source(frequency);
+  std::vector<int16_t> input(BLOCK_FRAMES);
+  std::vector<int16_t> output(2 * BLOCK_FRAMES);
+  std::vector<int16_t> converted_audio;
+
+  // Hold the sink over its target, so the servo winds up to its maximum correction and stays there
+  const uint32_t capacity_frames = SAMPLE_RATE;
+  compensator.update_buffer_level(capacity_frames, capacity_frames);
+  for (uint32_t block = 0; block < 400 * 100; ++block) {
+    source.generate(input.data(), BLOCK_FRAMES);
+    auto converted = compensator.resample(reinterpret_cast<const uint8_t *>(input.data()),
+                                          reinterpret_cast<uint8_t *>(output.data()), BLOCK_FRAMES, output.size());
+    HOST_CHECK(converted.frames_used == BLOCK_FRAMES);
+    if (block >= 399 * 100) {
+      converted_audio.insert(converted_audio.end(), output.begin(), output.begin() + converted.frames_generated);
+    }
+    compensator.update_buffer_level(capacity_frames, capacity_frames);
+  }
+
+  // Least squares fit of a tone at the converted frequency; everything else is error
+  const double output_frequency = frequency * (1.0 + compensator.get_correction_ppm() * 1e-6);
+  double cos_cos = 0.0, sin_sin = 0.0, cos_sin = 0.0, cos_y = 0.0, sin_y = 0.0;
+  for (size_t n = 0; n < converted_audio.size(); ++n) {
+    const double phase = 2.0 * PI * output_frequency * n / SAMPLE_RATE;
+    const double c = std::cos(phase);
+    const double s = std::sin(phase);
+    cos_cos += c * c;
+    sin_sin += s * s;
+    cos_sin += c * s;
+    cos_y += c * converted_audio[n];
+    sin_y += s * converted_audio[n];
+  }
+  const double determinant = cos_cos * sin_sin - cos_sin * cos_sin;
+  const double a = (cos_y * sin_sin - sin_y * cos_sin) / determinant;
+  const double b = (sin_y * cos_cos - cos_y * cos_sin) / determinant;
+
+  double signal = 0.0;
+  double error = 0.0;
+  for (size_t n = 0; n < converted_audio.size(); ++n) {
+    const double phase = 2.0 * PI * output_frequency * n / SAMPLE_RATE;
+    const double fitted = a * std::cos(phase) + b * std::sin(phase);
+    signal += fitted * fitted;
+    error += (converted_audio[n] - fitted) * (converted_audio[n] - fitted);
+  }
+  return 10.0 * std::log10(signal / error);
+}
+
+// Converts constant stereo input through a fused channel matrix and checks the settled output against the matrix
+static void check_fused_matrix(const std::vector<int32_t> &q15_matrix, uint8_t output_channels,
+                               const std::vector<int16_t> &expected) {
+  const int16_t left = 8000;
+  const int16_t right = -2000;
+
+  ChannelMixer channel_mixer;
+  HOST_CHECK(channel_mixer.configure(2, output_channels));
+  HOST_CHECK(channel_mixer.set_matrix(q15_matrix));
+
+  DriftCompensator compensator;
+  HOST_CHECK(compensator.initialize(AudioStreamInfo(16, 2, SAMPLE_RATE),
+                                    AudioStreamInfo(16, output_channels, SAMPLE_RATE), &channel_mixer));
+
+  std::vector<int16_t> input(2 * BLOCK_FRAMES);
+  for (uint32_t frame = 0; frame < BLOCK_FRAMES; ++frame) {
+    input[2 * frame] = left;
+    input[2 * frame + 1] = right;
+  }
+  std::vector<int16_t> output(output_channels * 2 * BLOCK_FRAMES);
+  uint32_t frames_generated = 0;
+  // Long enough for the filter's history to fill with the constant input
+  for (uint32_t block = 0; block < 10; ++block) {
+    auto converted = compensator.resample(reinterpret_cast<const uint8_t *>(input.data()),
+                                          reinterpret_cast<uint8_t *>(output.data()), BLOCK_FRAMES, 2 * BLOCK_FRAMES);
+    frames_generated = converted.frames_generated;
+  }
+  HOST_CHECK(frames_generated > 0);
+
+  const int16_t *last_frame = output.data() + (frames_generated - 1) * output_channels;
+  for (uint8_t channel = 0; channel < output_channels; ++channel) {
+    // The filter's DC gain is within a fraction of a percent of unity
+    HOST_CHECK(std::abs(last_frame[channel] - expected[channel]) <= 40);
+  }
+}
+
+int main() {
+  for (double drift_ppm : {-200.0, 200.0}) {
+    for (uint32_t capacity_frames : {SAMPLE_RATE / 10, SAMPLE_RATE / 2}) {
+      check_results("source side", drift_ppm, capacity_frames, simulate_source_side(drift_ppm, capacity_frames));
+    }
+  }
+
+  for (double frequency : {1000.0, 4000.0}) {
+    const double snr_db = measure_snr_db(frequency);
+    printf("  interpolation SNR at %.0f Hz: %.1f dB\n", frequency, snr_db);
+    HOST_CHECK(snr_db > 60.0);
+  }
+
+  // Swap the channels, then downmix to mono with an averaging and a left-heavy matrix
+  check_fused_matrix({0, 1 << 15, 1 << 15, 0}, 2, {-2000, 8000});
+  check_fused_matrix({1 << 14, 1 << 14}, 1, {3000});
+  check_fused_matrix({24576, 8192}, 1, {5500});
+
+  return host_test::finish("test_drift_compensator");
+}
@@ -0,0 +1,130 @@
+// Stress test of the lock-free claims on an I2S port. Reader and writer threads repeatedly claim and release the port
+// through I2SAccessState, in both duplex and exclusive mode, and check the claim counts it keeps.
+//
+// Only the compare-and-swap counts are tested; installing and uninstalling the drivers is up to I2SAudioComponent.
+// Every thread finishing shows the claims can't deadlock.
+
+#include "host_test.h"
+
+#include "esphome/components/i2s_audio/i2s_access_state.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using esphome::i2s_audio::I2SAccess;
+using esphome::i2s_audio::I2SAccessState;
+
+static const uint8_t THREADS_PER_SIDE = 3;
+static const uint32_t ITERATIONS = 100000;
+
+struct SideCounts {
+  std::atomic<uint32_t> claims{0};
+  std::atomic<uint32_t> refusals{0};
+  // Threads currently holding a claim, tracked independently of the state under test
+  std::atomic<uint32_t> holders{0};
+};
+
+struct Port {
+  I2SAccessState state;
+  std::atomic<uint32_t> exclusive_overlaps{0};
+  std::atomic<uint32_t> uncounted_claims{0};
+  std::atomic<uint32_t> failed_releases{0};
+  SideCounts rx;
+  SideCounts tx;
+
+  SideCounts &side(uint8_t access) { return access == I2SAccess::RX ? this->rx : this->tx; }
+};
+
+static void run_side(Port &port, uint8_t access, bool exclusive, uint32_t seed) {
+  SideCounts &counts = port.side(access);
+  SideCounts &other = port.side(access == I2SAccess::RX ? I2SAccess::TX : I2SAccess::RX);
+  for (uint32_t i = 0; i < ITERATIONS; ++i) {
+    if (!port.state.claim(access, exclusive)) {
+      counts.refusals.fetch_add(1, std::memory_order_relaxed);
+      std::this_thread::yield();
+      continue;
+    }
+    counts.claims.fetch_add(1, std::memory_order_relaxed);
+    counts.holders.fetch_add(1);
+
+    if (exclusive && (port.state.is_claimed_by_other(access) || (other.holders > 0))) {
+      port.exclusive_overlaps.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!port.state.is_claimed(access)) {
+      // The claim this thread holds must be counted
+      port.uncounted_claims.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Vary how long the claim is held, so claims of both sides overlap in every combination
+    for (uint32_t spin = (i * 2654435761u + seed) % 64; spin > 0; --spin) {
+      std::atomic_signal_fence(std::memory_order_seq_cst);
+    }
+
+    counts.holders.fetch_sub(1);
+    if (!port.state.release(access)) {
+      port.failed_releases.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+static void test_mode(bool exclusive) {
+  Port port;
+  std::vector<std::thread> threads;
+  for (uint8_t i = 0; i < THREADS_PER_SIDE; ++i) {
+    threads.emplace_back(run_side, std::ref(port), I2SAccess::RX, exclusive, 2 * i);
+    threads.emplace_back(run_side, std::ref(port), I2SAccess::TX, exclusive, 2 * i + 1);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  HOST_CHECK(port.exclusive_overlaps == 0);
+  HOST_CHECK(port.uncounted_claims == 0);
+  HOST_CHECK(port.failed_releases == 0);
+  for (uint8_t access : {I2SAccess::RX, I2SAccess::TX}) {
+    SideCounts &counts = port.side(access);
+    HOST_CHECK(counts.claims > 0);
+    HOST_CHECK(counts.claims + counts.refusals == THREADS_PER_SIDE * ITERATIONS);
+    HOST_CHECK(port.state.count(access) == 0);
+    HOST_CHECK(!port.state.is_claimed(access));
+    if (!exclusive) {
+      HOST_CHECK(counts.refusals == 0);
+    }
+  }
+  HOST_CHECK(!port.state.release(I2SAccess::RX));
+  HOST_CHECK(!port.state.release(I2SAccess::TX));
+
+  printf("  %s: rx %u claims, tx %u claims, %u refused\n", exclusive ? "exclusive" : "duplex", port.rx.claims.load(),
+         port.tx.claims.load(), port.rx.refusals.load() + port.tx.refusals.load());
+}
+
+static void test_single_thread() {
+  I2SAccessState state;
+
+  HOST_CHECK(state.claim(I2SAccess::RX, true));
+  HOST_CHECK(!state.claim(I2SAccess::TX, true));
+  HOST_CHECK(state.claim(I2SAccess::RX, true));
+  HOST_CHECK(state.count(I2SAccess::RX) == 2);
+  HOST_CHECK(state.count(I2SAccess::TX) == 0);
+  HOST_CHECK(state.is_claimed_by_other(I2SAccess::TX));
+
+  // Duplex claims ignore the other side
+  HOST_CHECK(state.claim(I2SAccess::TX, false));
+  HOST_CHECK(state.count(I2SAccess::TX) == 1);
+  HOST_CHECK(state.release(I2SAccess::TX));
+
+  HOST_CHECK(state.release(I2SAccess::RX));
+  HOST_CHECK(state.count(I2SAccess::RX) == 1);
+  HOST_CHECK(state.release(I2SAccess::RX));
+  HOST_CHECK(!state.release(I2SAccess::RX));
+  HOST_CHECK(state.claim(I2SAccess::TX, true));
+  HOST_CHECK(state.release(I2SAccess::TX));
+}
+
+int main() {
+  test_single_thread();
+  test_mode(false);
+  test_mode(true);
+  return host_test::finish("test_i2s_access_state");
+}
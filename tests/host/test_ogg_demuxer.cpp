@@ -0,0 +1,327 @@
+// Correctness and throughput of the streaming Ogg demuxer.
+//
+// A synthetic stream of packets with random sizes is paginated with packets continuing across pages, interleaved with
+// a second logical stream, and sprinkled with garbage between pages. It is fed to the demuxer in random chunks through
+// a buffer that behaves like the decoder's input transfer buffer, and every packet must come out intact with the
+// granule position of the page it ended on.
+
+#include "host_test.h"
+
+#include "esphome/components/audio/audio_ogg_demuxer.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using esphome::audio::OGG_MAX_PACKET_SIZE;
+using esphome::audio::OggDemuxer;
+using esphome::audio::OggDemuxerResult;
+
+static const uint32_t PRIMARY_SERIAL = 0x1234;
+static const uint32_t OTHER_SERIAL = 0x9876;
+static const int64_t SAMPLES_PER_PACKET = 960;  // 20 ms Opus packets
+
+struct ExpectedPacket {
+  std::vector<uint8_t> data;
+  int64_t granule_position;
+};
+
+static void append_le(std::vector<uint8_t> &out, uint64_t value, uint8_t bytes) {
+  for (uint8_t i = 0; i < bytes; ++i) {
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+// Appends a page. The CRC is left at zero, as the demuxer doesn't verify it.
+static void write_page(std::vector<uint8_t> &out, uint32_t serial, uint32_t sequence, uint8_t header_type,
+                       int64_t granule_position, const std::vector<uint8_t> &lacing_values,
+                       const std::vector<uint8_t> &body) {
+  out.insert(out.end(), {'O', 'g', 'g', 'S', 0, header_type});
+  append_le(out, static_cast<uint64_t>(granule_position), 8);
+  append_le(out, serial, 4);
+  append_le(out, sequence, 4);
+  append_le(out, 0, 4);
+  out.push_back(static_cast<uint8_t>(lacing_values.size()));
+  out.insert(out.end(), lacing_values.begin(), lacing_values.end());
+  out.insert(out.end(), body.begin(), body.end());
+}
+
+class StreamBuilder {
+ public:
+  StreamBuilder(uint32_t serial, std::mt19937 &random) : serial_(serial), random_(random) {}
+
+  /// Splits the packets into pages of a random number of segments, so packets regularly continue onto the next page
+  std::vector<std::vector<uint8_t>> paginate(const std::vector<std::vector<uint8_t>> &packets,
+                                             std::vector<ExpectedPacket> *expected) {
+    std::vector<std::vector<uint8_t>> pages;
+    std::vector<uint8_t> lacing_values;
+    std::vector<uint8_t> body;
+    std::vector<size_t> packets_ending;  // Indexes of the packets that end on the current page
+    bool continued = false;
+    uint32_t segment_limit = this->random_segment_limit_();
+    int64_t granule_position = 0;
+
+    auto close_page = [&](bool last) {
+      uint8_t header_type = continued ? 0x01 : 0x00;
+      if (pages.empty()) {
+        header_type |= 0x02;
+      }
+      if (last) {
+        header_type |= 0x04;
+      }
+      // Pages that complete no packet have a granule position of -1
+      const int64_t page_granule = packets_ending.empty() ? -1 : granule_position;
+      if (expected != nullptr) {
+        for (size_t index : packets_ending) {
+          if (packets[index].size() <= OGG_MAX_PACKET_SIZE) {
+            expected->push_back({packets[index], page_granule});
+          }
+        }
+      }
+      pages.emplace_back();
+      write_page(pages.back(), this->serial_, this->sequence_++, header_type, page_granule, lacing_values, body);
+      lacing_values.clear();
+      body.clear();
+      packets_ending.clear();
+      segment_limit = this->random_segment_limit_();
+    };
+
+    for (size_t index = 0; index < packets.size(); ++index) {
+      const auto &packet = packets[index];
+      size_t offset = 0;
+      while (true) {
+        const size_t segment = std::min<size_t>(packet.size() - offset, 255);
+        lacing_values.push_back(static_cast<uint8_t>(segment));
+        body.insert(body.end(), packet.begin() + offset, packet.begin() + offset + segment);
+        offset += segment;
+        const bool packet_done = (segment < 255);
+        if (packet_done) {
+          granule_position += SAMPLES_PER_PACKET;
+          packets_ending.push_back(index);
+        }
+        const bool last = packet_done && (index + 1 == packets.size());
+        if ((lacing_values.size() == segment_limit) || last) {
+          close_page(last);
+          continued = !packet_done;
+        }
+        if (packet_done) {
+          break;
+        }
+      }
+    }
+    return pages;
+  }
+
+ protected:
+  uint32_t random_segment_limit_() { return std::uniform_int_distribution<uint32_t>(8, 255)(this->random_); }
+
+  uint32_t serial_;
+  uint32_t sequence_{0};
+  std::mt19937 &random_;
+};
+
+static std::vector<std::vector<uint8_t>> generate_packets(std::mt19937 &random, uint32_t count) {
+  std::vector<std::vector<uint8_t>> packets;
+  std::uniform_int_distribution<uint32_t> byte(0, 255);
+  std::uniform_int_distribution<uint32_t> kind(0, 99);
+  for (uint32_t i = 0; i < count; ++i) {
+    size_t size;
+    const uint32_t k = kind(random);
+    if (k == 0) {
+      size = 0;
+    } else if (k == 1) {
+      size = OGG_MAX_PACKET_SIZE + 1 + byte(random) * 40;  // Too large to reassemble, like cover art; skipped
+    } else if (k < 5) {
+      size = 1000 + byte(random) * 25;  // Spans several pages
+    } else if (k < 8) {
+      size = 255 * (1 + byte(random) % 4);  // Ends with a zero lacing value
+    } else {
+      size = 20 + byte(random) * 4;  // Typical Opus packet
+    }
+    std::vector<uint8_t> packet(size);
+    for (auto &value : packet) {
+      value = byte(random);
+    }
+    packets.push_back(std::move(packet));
+  }
+  return packets;
+}
+
+// Builds the primary stream interleaved with a second logical stream and garbage between pages
+static std::vector<uint8_t> build_stream(std::mt19937 &random, uint32_t packet_count,
+                                         std::vector<ExpectedPacket> *expected, bool garbage) {
+  StreamBuilder primary(PRIMARY_SERIAL, random);
+  StreamBuilder other(OTHER_SERIAL, random);
+  const auto primary_pages = primary.paginate(generate_packets(random, packet_count), expected);
+  const auto other_pages = other.paginate(generate_packets(random, packet_count / 4), nullptr);
+
+  std::vector<uint8_t> stream;
+  std::uniform_int_distribution<uint32_t> choice(0, 99);
+  size_t other_index = 0;
+  for (size_t i = 0; i < primary_pages.size(); ++i) {
+    stream.insert(stream.end(), primary_pages[i].begin(), primary_pages[i].end());
+    if ((other_index < other_pages.size()) && (choice(random) < 30)) {
+      stream.insert(stream.end(), other_pages[other_index].begin(), other_pages[other_index].end());
+      ++other_index;
+    }
+    if (garbage && (choice(random) < 5)) {
+      // Random bytes, a partial capture pattern, and a capture pattern with an unsupported version
+      const uint32_t length = 1 + choice(random) * 3;
+      for (uint32_t j = 0; j < length; ++j) {
+        const uint8_t value = static_cast<uint8_t>(choice(random));
+        stream.push_back(value == 'O' ? 0 : value);
+      }
+      stream.insert(stream.end(), {'O', 'g', 'g', 'x', 'O', 'g', 'g', 'S', 1, 0});
+    }
+  }
+  return stream;
+}
+
+struct DemuxResults {
+  std::vector<ExpectedPacket> packets;
+  bool last_packet_flagged{false};
+  bool end_of_stream{false};
+  uint32_t lost_sync{0};
+};
+
+// Feeds the stream in chunks through a buffer the way AudioDecoder does: unconsumed bytes stay at the front and more
+// input is appended only when the demuxer needs more data
+static DemuxResults demux_stream(const std::vector<uint8_t> &stream, std::mt19937 &random, size_t max_chunk) {
+  OggDemuxer demuxer;
+  HOST_CHECK(demuxer.is_allocated());
+
+  DemuxResults results;
+  std::vector<uint8_t> buffer;
+  size_t stream_offset = 0;
+  std::uniform_int_distribution<size_t> chunk(1, max_chunk);
+  while (true) {
+    size_t consumed = 0;
+    const OggDemuxerResult result = demuxer.demux(buffer.data(), buffer.size(), &consumed);
+    HOST_CHECK(consumed <= buffer.size());
+    buffer.erase(buffer.begin(), buffer.begin() + consumed);
+
+    if (result == OggDemuxerResult::PACKET) {
+      results.packets.push_back({std::vector<uint8_t>(demuxer.get_packet(),
+                                                      demuxer.get_packet() + demuxer.get_packet_length()),
+                                 demuxer.get_granule_position()});
+      results.last_packet_flagged = demuxer.is_last_packet();
+    } else if (result == OggDemuxerResult::END_OF_STREAM) {
+      results.end_of_stream = true;
+      break;
+    } else if (result == OggDemuxerResult::LOST_SYNC) {
+      ++results.lost_sync;
+    } else {
+      if (stream_offset == stream.size()) {
+        break;
+      }
+      const size_t length = std::min(chunk(random), stream.size() - stream_offset);
+      buffer.insert(buffer.end(), stream.begin() + stream_offset, stream.begin() + stream_offset + length);
+      stream_offset += length;
+    }
+  }
+  return results;
+}
+
+static void check_packets(const std::vector<ExpectedPacket> &expected, const DemuxResults &results) {
+  HOST_CHECK(results.packets.size() == expected.size());
+  size_t mismatches = 0;
+  for (size_t i = 0; i < std::min(expected.size(), results.packets.size()); ++i) {
+    if ((results.packets[i].data != expected[i].data) ||
+        (results.packets[i].granule_position != expected[i].granule_position)) {
+      ++mismatches;
+    }
+  }
+  HOST_CHECK(mismatches == 0);
+  HOST_CHECK(results.last_packet_flagged);
+  HOST_CHECK(results.end_of_stream);
+}
+
+static void test_chunked_stream() {
+  std::mt19937 random(1);
+  std::vector<ExpectedPacket> expected;
+  const auto stream = build_stream(random, 2000, &expected, true);
+
+  for (size_t max_chunk : {size_t{1}, size_t{7}, size_t{300}, size_t{4096}}) {
+    const DemuxResults results = demux_stream(stream, random, max_chunk);
+    check_packets(expected, results);
+    HOST_CHECK(results.lost_sync > 0);
+  }
+  printf("  %zu byte stream, %zu packets recovered intact in chunks of 1 to 4096 bytes\n", stream.size(),
+         expected.size());
+}
+
+static void test_lost_page() {
+  // A packet continuing over two pages whose first page is lost; its remainder must be dropped, not emitted
+  std::vector<uint8_t> first(300, 0x11);
+  std::vector<uint8_t> second(40, 0x22);
+  std::vector<uint8_t> stream;
+  write_page(stream, PRIMARY_SERIAL, 0, 0x02, 0, {40}, std::vector<uint8_t>(40, 0x33));
+  // The lost page would have held the first 255 bytes of the first packet
+  std::vector<uint8_t> remainder(first.begin() + 255, first.end());
+  std::vector<uint8_t> body = remainder;
+  body.insert(body.end(), second.begin(), second.end());
+  write_page(stream, PRIMARY_SERIAL, 2, 0x01 | 0x04, 3 * SAMPLES_PER_PACKET, {45, 40}, body);
+
+  std::mt19937 random(2);
+  const DemuxResults results = demux_stream(stream, random, 64);
+  HOST_CHECK(results.packets.size() == 2);
+  if (results.packets.size() == 2) {
+    HOST_CHECK(results.packets[0].data == std::vector<uint8_t>(40, 0x33));
+    HOST_CHECK(results.packets[1].data == second);
+  }
+  HOST_CHECK(results.end_of_stream);
+}
+
+static void benchmark() {
+  std::mt19937 random(3);
+  const auto stream = build_stream(random, 2000, nullptr, false);
+  const uint32_t repeats = 40;
+  const size_t chunk = 4096;
+
+  // Demux from a buffer the way the decoder does, without the random chunking overhead of the correctness test
+  OggDemuxer demuxer;
+  size_t packets = 0;
+  const double start = host_test::now_seconds();
+  for (uint32_t repeat = 0; repeat < repeats; ++repeat) {
+    demuxer.reset();
+    size_t offset = 0;
+    size_t available = 0;
+    while (true) {
+      size_t consumed = 0;
+      const OggDemuxerResult result = demuxer.demux(stream.data() + offset, available, &consumed);
+      offset += consumed;
+      available -= consumed;
+      if (result == OggDemuxerResult::PACKET) {
+        ++packets;
+      } else if (result == OggDemuxerResult::END_OF_STREAM) {
+        break;
+      } else if (result == OggDemuxerResult::NEED_MORE_DATA) {
+        available = std::min(available + chunk, stream.size() - offset);
+      }
+    }
+  }
+  const double seconds = host_test::now_seconds() - start;
+
+  // memcpy of the same data in the same chunks, for scale
+  std::vector<uint8_t> copy(chunk);
+  const double copy_start = host_test::now_seconds();
+  for (uint32_t repeat = 0; repeat < repeats; ++repeat) {
+    for (size_t offset = 0; offset < stream.size(); offset += chunk) {
+      std::memcpy(copy.data(), stream.data() + offset, std::min(chunk, stream.size() - offset));
+      asm volatile("" : : "r"(copy.data()) : "memory");
+    }
+  }
+  const double copy_seconds = host_test::now_seconds() - copy_start;
+
+  const double megabytes = static_cast<double>(stream.size()) * repeats / 1e6;
+  printf("  demux %.0f MB/s (%.1f million packets/s), memcpy %.0f MB/s\n", megabytes / seconds,
+         packets / seconds / 1e6, megabytes / copy_seconds);
+}
+
+int main() {
+  test_chunked_stream();
+  test_lost_page();
+  benchmark();
+
+  return host_test::finish("test_ogg_demuxer");
+}
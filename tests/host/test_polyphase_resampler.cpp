@@ -0,0 +1,243 @@
+// Stopband attenuation and throughput of the integer-ratio polyphase resampler.
+//
+// The generic resampler comes from esp-audio-libs and doesn't build on the host, so the throughput is compared with
+// a reference of the same design: a float windowed-sinc filter whose coefficients are linearly interpolated from a
+// table of sub-filters for every output sample, using the same number of taps per output sample as the polyphase path.
+
+#include "host_test.h"
+
+#include "esphome/components/audio/audio.h"
+#include "esphome/components/audio/audio_polyphase_resampler.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using esphome::audio::AudioStreamInfo;
+using esphome::audio::POLYPHASE_TAPS_PER_PHASE;
+using esphome::audio::PolyphaseResampler;
+
+static const double PI = 3.14159265358979323846;
+
+// The filter is designed for about 60 dB; Q15 coefficients cost a little of that
+static const double MIN_STOPBAND_ATTENUATION_DB = 55.0;
+
+static std::vector<int16_t> generate_tone(double frequency, uint32_t sample_rate, uint32_t frames, uint8_t channels,
+                                          double amplitude = 0.5) {
+  std::vector<int16_t> samples(frames * channels);
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    const double value = amplitude * 32767.0 * std::sin(2.0 * PI * frequency * frame / sample_rate);
+    for (uint8_t channel = 0; channel < channels; ++channel) {
+      samples[frame * channels + channel] = static_cast<int16_t>(std::lround(value));
+    }
+  }
+  return samples;
+}
+
+static std::vector<int16_t> resample(const std::vector<int16_t> &input, uint32_t input_rate, uint32_t output_rate,
+                                     uint8_t channels) {
+  PolyphaseResampler resampler;
+  HOST_CHECK(
+      resampler.initialize(AudioStreamInfo(16, channels, input_rate), AudioStreamInfo(16, channels, output_rate)));
+
+  const uint32_t input_frames = input.size() / channels;
+  std::vector<int16_t> output((static_cast<uint64_t>(input_frames) * output_rate / input_rate + 8) * channels);
+
+  // Feed the input in small blocks, as the speaker pipeline does
+  const uint32_t block_frames = 96;
+  uint32_t used = 0;
+  uint32_t generated = 0;
+  while (used < input_frames) {
+    const uint32_t frames = std::min(block_frames, input_frames - used);
+    auto results = resampler.resample(reinterpret_cast<const uint8_t *>(input.data() + used * channels),
+                                      reinterpret_cast<uint8_t *>(output.data() + generated * channels), frames,
+                                      output.size() / channels - generated);
+    if (results.frames_used == 0) {
+      break;
+    }
+    used += results.frames_used;
+    generated += results.frames_generated;
+  }
+  output.resize(generated * channels);
+  return output;
+}
+
+// Amplitude of the component at frequency in channel 0, skipping the filter's start-up transient
+static double tone_amplitude(const std::vector<int16_t> &samples, uint8_t channels, double frequency,
+                             uint32_t sample_rate, uint32_t skip_frames) {
+  double real = 0.0;
+  double imaginary = 0.0;
+  const uint32_t frames = samples.size() / channels;
+  for (uint32_t frame = skip_frames; frame < frames; ++frame) {
+    const double phase = 2.0 * PI * frequency * frame / sample_rate;
+    real += samples[frame * channels] * std::cos(phase);
+    imaginary += samples[frame * channels] * std::sin(phase);
+  }
+  return 2.0 * std::sqrt(real * real + imaginary * imaginary) / (frames - skip_frames);
+}
+
+static double rms(const std::vector<int16_t> &samples, uint8_t channels, uint32_t skip_frames) {
+  double sum = 0.0;
+  const uint32_t frames = samples.size() / channels;
+  for (uint32_t frame = skip_frames; frame < frames; ++frame) {
+    sum += static_cast<double>(samples[frame * channels]) * samples[frame * channels];
+  }
+  return std::sqrt(sum / (frames - skip_frames));
+}
+
+static double to_db(double ratio) { return 20.0 * std::log10(std::max(ratio, 1e-12)); }
+
+static void test_downsampling_stopband() {
+  const uint32_t input_rate = 48000;
+  const uint32_t output_rate = 16000;
+  const uint32_t frames = input_rate;  // One second
+  const uint32_t skip = 2 * POLYPHASE_TAPS_PER_PHASE;
+
+  const auto passband = resample(generate_tone(1000.0, input_rate, frames, 1), input_rate, output_rate, 1);
+  const double passband_rms = rms(passband, 1, skip);
+
+  // -3 dB filter gain on a 0.5 full scale tone
+  HOST_CHECK(std::fabs(to_db(passband_rms / (0.5 * 32767.0 / std::sqrt(2.0))) + 3.0) < 0.5);
+
+  double worst_db = 0.0;
+  double worst_frequency = 0.0;
+  for (double frequency = 9000.0; frequency < input_rate / 2; frequency += 500.0) {
+    const auto output = resample(generate_tone(frequency, input_rate, frames, 1), input_rate, output_rate, 1);
+    const double attenuation_db = -to_db(rms(output, 1, skip) / passband_rms);
+    if ((worst_frequency == 0.0) || (attenuation_db < worst_db)) {
+      worst_db = attenuation_db;
+      worst_frequency = frequency;
+    }
+  }
+  printf("  48 kHz -> 16 kHz: worst stopband attenuation %.1f dB at %.0f Hz\n", worst_db, worst_frequency);
+  HOST_CHECK(worst_db >= MIN_STOPBAND_ATTENUATION_DB);
+}
+
+static void test_upsampling_images() {
+  const uint32_t input_rate = 16000;
+  const uint32_t output_rate = 48000;
+  const uint32_t frames = input_rate;
+  const uint32_t skip = 2 * POLYPHASE_TAPS_PER_PHASE * 3;
+
+  double worst_db = 0.0;
+  double worst_frequency = 0.0;
+  for (double frequency = 250.0; frequency <= 6500.0; frequency += 750.0) {
+    const auto output = resample(generate_tone(frequency, input_rate, frames, 1), input_rate, output_rate, 1);
+    const double tone = tone_amplitude(output, 1, frequency, output_rate, skip);
+    // Zero stuffing mirrors the tone around multiples of the input rate
+    for (double image : {input_rate - frequency, input_rate + frequency, 2 * input_rate - frequency,
+                         2 * input_rate + frequency}) {
+      if (image >= output_rate / 2) {
+        continue;
+      }
+      const double attenuation_db = -to_db(tone_amplitude(output, 1, image, output_rate, skip) / tone);
+      if ((worst_frequency == 0.0) || (attenuation_db < worst_db)) {
+        worst_db = attenuation_db;
+        worst_frequency = image;
+      }
+    }
+  }
+  printf("  16 kHz -> 48 kHz: worst image attenuation %.1f dB at %.0f Hz\n", worst_db, worst_frequency);
+  HOST_CHECK(worst_db >= MIN_STOPBAND_ATTENUATION_DB);
+}
+
+class ReferenceResampler {
+  /*
+   * @brief Float resampler for arbitrary ratios: a Kaiser windowed-sinc prototype stored as a table of sub-filters,
+   * with the coefficients for every output sample interpolated between the two nearest sub-filters.
+   */
+ public:
+  ReferenceResampler(uint32_t input_rate, uint32_t output_rate, uint8_t channels)
+      : step_(static_cast<double>(input_rate) / output_rate), channels_(channels) {
+    const double scale = std::min(1.0, 1.0 / this->step_);
+    this->taps_ = static_cast<uint16_t>(std::ceil(POLYPHASE_TAPS_PER_PHASE / scale));
+    const double cutoff = 0.46 * scale;
+    const double half = this->taps_ / 2.0;
+    this->table_.resize((SUB_FILTERS + 1) * this->taps_);
+    for (uint32_t sub = 0; sub <= SUB_FILTERS; ++sub) {
+      for (uint16_t tap = 0; tap < this->taps_; ++tap) {
+        const double t = tap - half + static_cast<double>(sub) / SUB_FILTERS;
+        const double sinc = (t == 0.0) ? 2.0 * cutoff : std::sin(2.0 * PI * cutoff * t) / (PI * t);
+        const double ratio = t / half;
+        const double window = ratio * ratio < 1.0 ? std::cyl_bessel_i(0.0, 5.65 * std::sqrt(1.0 - ratio * ratio)) /
+                                                        std::cyl_bessel_i(0.0, 5.65)
+                                                  : 0.0;
+        this->table_[sub * this->taps_ + tap] = static_cast<float>(sinc * window);
+      }
+    }
+    this->coefficients_.resize(this->taps_);
+  }
+
+  uint32_t resample(const int16_t *input, uint32_t input_frames, int16_t *output) {
+    uint32_t generated = 0;
+    while (this->position_ + this->taps_ < input_frames) {
+      const uint32_t start = static_cast<uint32_t>(this->position_);
+      const double fraction = (this->position_ - start) * SUB_FILTERS;
+      const uint32_t sub = static_cast<uint32_t>(fraction);
+      const float weight = static_cast<float>(fraction - sub);
+      const float *lower = &this->table_[sub * this->taps_];
+      const float *upper = &this->table_[(sub + 1) * this->taps_];
+      for (uint16_t tap = 0; tap < this->taps_; ++tap) {
+        this->coefficients_[tap] = lower[tap] + weight * (upper[tap] - lower[tap]);
+      }
+      for (uint8_t channel = 0; channel < this->channels_; ++channel) {
+        float accumulator = 0.0f;
+        const int16_t *samples = input + start * this->channels_ + channel;
+        for (uint16_t tap = 0; tap < this->taps_; ++tap) {
+          accumulator += samples[tap * this->channels_] * this->coefficients_[tap];
+        }
+        output[generated * this->channels_ + channel] =
+            static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, accumulator)));
+      }
+      ++generated;
+      this->position_ += this->step_;
+    }
+    return generated;
+  }
+
+ protected:
+  static const uint32_t SUB_FILTERS = 256;
+
+  double step_;
+  double position_{0.0};
+  uint8_t channels_;
+  uint16_t taps_;
+  std::vector<float> table_;
+  std::vector<float> coefficients_;
+};
+
+static void benchmark(uint32_t input_rate, uint32_t output_rate) {
+  const uint8_t channels = 2;
+  const uint32_t frames = input_rate * 10;
+  const auto input = generate_tone(997.0, input_rate, frames, channels);
+
+  const double polyphase_start = host_test::now_seconds();
+  const auto polyphase_output = resample(input, input_rate, output_rate, channels);
+  const double polyphase_seconds = host_test::now_seconds() - polyphase_start;
+
+  ReferenceResampler reference(input_rate, output_rate, channels);
+  std::vector<int16_t> reference_output((static_cast<uint64_t>(frames) * output_rate / input_rate + 8) * channels);
+  const double reference_start = host_test::now_seconds();
+  const uint32_t reference_frames = reference.resample(input.data(), frames, reference_output.data());
+  const double reference_seconds = host_test::now_seconds() - reference_start;
+
+  const double polyphase_ns = 1e9 * polyphase_seconds / (polyphase_output.size() / channels);
+  const double reference_ns = 1e9 * reference_seconds / reference_frames;
+  printf("  %u Hz -> %u Hz stereo: polyphase %.1f ns/frame, reference %.1f ns/frame (%.1fx)\n", input_rate,
+         output_rate, polyphase_ns, reference_ns, reference_ns / polyphase_ns);
+}
+
+int main() {
+  HOST_CHECK(PolyphaseResampler::is_supported(48000, 16000));
+  HOST_CHECK(PolyphaseResampler::is_supported(24000, 48000));
+  HOST_CHECK(!PolyphaseResampler::is_supported(44100, 48000));
+
+  test_downsampling_stopband();
+  test_upsampling_images();
+
+  benchmark(48000, 16000);
+  benchmark(16000, 48000);
+  benchmark(24000, 48000);
+
+  return host_test::finish("test_polyphase_resampler");
+}
@@ -0,0 +1,88 @@
+import argparse
+import os
+import re
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+"""
+Serve audio files over http, dropping each connection after a fixed number of bytes.
+The media player has to reconnect with a Range request and resume where it left off
+to play the file to the end without a gap.
+"""
+PORT = 8080
+DROP_AFTER_BYTES = 64 * 1024
+
+CONTENT_TYPES = {
+    ".wav": "audio/wav",
+    ".mp3": "audio/mpeg",
+    ".flac": "audio/flac",
+}
+
+RANGE_PATTERN = re.compile(r"bytes=(\d+)-$")
+
+
+class FlakyHandler(BaseHTTPRequestHandler):
+    root = "."
+    drop_after = DROP_AFTER_BYTES
+    ignore_range = False
+
+    def do_GET(self):
+        path = os.path.join(self.root, os.path.basename(self.path.split("?")[0]))
+        if not os.path.isfile(path):
+            self.send_error(404)
+            return
+
+        with open(path, "rb") as f:
+            data = f.read()
+
+        start = 0
+        range_header = self.headers.get("Range")
+        if range_header and not self.ignore_range:
+            match = RANGE_PATTERN.match(range_header)
+            if match is None:
+                self.send_error(400)
+                return
+            start = int(match.group(1))
+            if start >= len(data):
+                self.send_response(416)
+                self.send_header("Content-Range", f"bytes */{len(data)}")
+                self.end_headers()
+                return
+            self.send_response(206)
+            self.send_header("Content-Range", f"bytes {start}-{len(data) - 1}/{len(data)}")
+        else:
+            self.send_response(200)
+
+        self.send_header("Content-Type", CONTENT_TYPES.get(os.path.splitext(path)[1], "application/octet-stream"))
+        self.send_header("Content-Length", str(len(data) - start))
+        self.send_header("Accept-Ranges", "none" if self.ignore_range else "bytes")
+        self.end_headers()
+
+        end = len(data) if self.drop_after <= 0 else min(len(data), start + self.drop_after)
+        self.wfile.write(data[start:end])
+        print(f"{self.client_address[0]}: sent bytes {start}-{end - 1} of {len(data)}"
+              + ("" if end == len(data) else ", dropping connection"))
+        # Closing without sending the rest of the promised Content-Length looks like a dropped connection
+        self.close_connection = True
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("directory", help="directory containing the audio files to serve")
+    parser.add_argument("--port", type=int, default=PORT)
+    parser.add_argument("--drop-after", type=int, default=DROP_AFTER_BYTES,
+                        help="bytes sent per connection before dropping it (0 never drops)")
+    parser.add_argument("--ignore-range", action="store_true",
+                        help="always send the whole file, like servers without Range support")
+    args = parser.parse_args()
+
+    FlakyHandler.root = args.directory
+    FlakyHandler.drop_after = args.drop_after
+    FlakyHandler.ignore_range = args.ignore_range
+
+    server = ThreadingHTTPServer(("", args.port), FlakyHandler)
+    print(f"Serving {args.directory} on port {args.port}, dropping connections after {args.drop_after} bytes")
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()